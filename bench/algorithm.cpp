@@ -0,0 +1,119 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "sx/algorithm.h"
+#include "sx/reduce.h"
+
+// bincount (sequential and sx::par) and searchsorted, against raw loops
+
+namespace {
+
+std::vector<int> random_labels(size_t n, int n_classes)
+{
+    std::mt19937 rng(2);
+    std::vector<int> y(n);
+    for (auto& x : y)
+        x = (int)(rng() % n_classes);
+    return y;
+}
+
+void add_bincount(size_t n, int n_classes)
+{
+    const std::string suffix = "/int/" + std::to_string(n_classes) + "/" + std::to_string(n);
+    bench::add("bincount" + suffix, [=](bench::state& st) {
+        auto y = random_labels(n, n_classes);
+        while (st.keep_running()) {
+            auto h = sx::bincount<size_t>(y);
+            bench::do_not_optimize(h.data());
+        }
+        st.set_bytes_per_iteration(n * sizeof(int));
+        st.set_items_per_iteration(n);
+    });
+    bench::add("par/bincount" + suffix, [=](bench::state& st) {
+        auto y = random_labels(n, n_classes);
+        auto yv = sx::make_array_view(y);
+        while (st.keep_running()) {
+            auto h = sx::par::bincount(yv);
+            bench::do_not_optimize(h.data());
+        }
+        st.set_bytes_per_iteration(n * sizeof(int));
+        st.set_items_per_iteration(n);
+    });
+    bench::add("par/bincount_weighted" + suffix, [=](bench::state& st) {
+        auto y = random_labels(n, n_classes);
+        std::vector<double> w(n, 0.5);
+        auto yv = sx::make_array_view(y);
+        auto wv = sx::make_array_view(w);
+        while (st.keep_running()) {
+            auto h = sx::par::bincount(yv, wv);
+            bench::do_not_optimize(h.data());
+        }
+        st.set_bytes_per_iteration(n * (sizeof(int) + sizeof(double)));
+        st.set_items_per_iteration(n);
+    });
+    bench::add("raw/bincount" + suffix, [=](bench::state& st) {
+        auto y = random_labels(n, n_classes);
+        std::vector<size_t> h;
+        while (st.keep_running()) {
+            h.assign(n_classes, 0);
+            const int* p = y.data();
+            for (size_t i = 0; i < n; ++i)
+                ++h[p[i]];
+            bench::do_not_optimize(h.data());
+        }
+        st.set_bytes_per_iteration(n * sizeof(int));
+        st.set_items_per_iteration(n);
+    });
+}
+
+template <typename T>
+void add_searchsorted(const std::string& tname, size_t n, size_t n_queries)
+{
+    auto make = [=](std::vector<T>& a, std::vector<T>& v) {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<double> u(0, 1e6);
+        a.resize(n);
+        v.resize(n_queries);
+        for (auto& x : a)
+            x = (T)u(rng);
+        for (auto& x : v)
+            x = (T)u(rng);
+        std::sort(a.begin(), a.end());
+    };
+    const std::string suffix = "/" + tname + "/" + std::to_string(n) + "/" + std::to_string(n_queries);
+    bench::add("searchsorted" + suffix, [=](bench::state& st) {
+        std::vector<T> a, v;
+        make(a, v);
+        while (st.keep_running()) {
+            auto r = sx::searchsorted<size_t>(a, v);
+            bench::do_not_optimize(r.data());
+        }
+        st.set_items_per_iteration(n_queries);
+    });
+    bench::add("raw/searchsorted" + suffix, [=](bench::state& st) {
+        std::vector<T> a, v;
+        make(a, v);
+        std::vector<size_t> r(n_queries);
+        while (st.keep_running()) {
+            const T *b = a.data(), *e = b + n;
+            for (size_t i = 0; i < n_queries; ++i)
+                r[i] = std::lower_bound(b, e, v[i]) - b;
+            bench::do_not_optimize(r.data());
+        }
+        st.set_items_per_iteration(n_queries);
+    });
+}
+
+bench::registrar r([] {
+    for (size_t n : { 1 << 12, 1 << 20 })
+        for (int n_classes : { 2, 256 })
+            add_bincount(n, n_classes);
+    for (size_t n : { 64, 1 << 16 }) {
+        add_searchsorted<float>("float", n, 1 << 12);
+        add_searchsorted<double>("double", n, 1 << 12);
+    }
+});
+}
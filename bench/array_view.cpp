@@ -0,0 +1,138 @@
+#include "bench.hpp"
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include "sx/array_view.h"
+
+// iteration and operator<<= over array_views of rank 1..3 in c_order,
+// fortran_order and strided (every second element of the innermost c_order
+// dimension) layouts, against raw-pointer loops
+
+namespace {
+
+using sx::array_view;
+using sx::rank_type;
+
+// a nearly cubic shape with about n elements
+template <rank_type Rank>
+std::array<size_t, Rank> shape(size_t n)
+{
+    std::array<size_t, Rank> e;
+    const size_t side = (size_t)std::lround(std::pow((double)n, 1.0 / Rank));
+    size_t rest = n;
+    for (rank_type i = Rank - 1; i > 0; --i) {
+        e[i] = side;
+        rest /= side;
+    }
+    e[0] = rest;
+    return e;
+}
+
+enum class layout { c, f, strided };
+const char* layout_name(layout l)
+{
+    return l == layout::c ? "c_order" : l == layout::f ? "fortran_order" : "strided";
+}
+
+// a view of `buf` (resized as needed) with the given layout
+template <typename T, rank_type Rank>
+array_view<T, Rank> make_view(std::vector<T>& buf, const std::array<size_t, Rank>& e, layout l)
+{
+    size_t n = 1;
+    for (auto x : e)
+        n *= x;
+    buf.assign(l == layout::strided ? 2 * n : n, T(1));
+    if (l == layout::c)
+        return array_view<T, Rank>(buf.data(), e, sx::array_layout::c_order);
+    if (l == layout::f)
+        return array_view<T, Rank>(buf.data(), e, sx::array_layout::fortran_order);
+    array_view<T, Rank> c(buf.data(), e, sx::array_layout::c_order);
+    auto s = c.strides();
+    for (auto& x : s)
+        x *= 2;
+    return array_view<T, Rank>(buf.data(), e, s);
+}
+
+template <typename T, rank_type Rank>
+void add_view_benchmarks(const std::string& tname, size_t n)
+{
+    const auto e = shape<Rank>(n);
+    const std::string suffix = "/" + tname + "/rank" + std::to_string(Rank) + "/" + std::to_string(n);
+    for (layout l : { layout::c, layout::f, layout::strided }) {
+        bench::add(std::string("array_view/iterate/") + layout_name(l) + suffix, [e, l](bench::state& st) {
+            std::vector<T> buf;
+            auto x = make_view<T, Rank>(buf, e, l);
+            while (st.keep_running()) {
+                T s = T();
+                for (auto v : x)
+                    s += v;
+                bench::do_not_optimize(s);
+            }
+            st.set_bytes_per_iteration(x.size() * sizeof(T));
+            st.set_items_per_iteration(x.size());
+        });
+        bench::add(std::string("array_view/copy/") + layout_name(l) + "_to_c_order" + suffix, [e, l](bench::state& st) {
+            std::vector<T> buf, dbuf;
+            auto x = make_view<T, Rank>(buf, e, l);
+            auto y = make_view<T, Rank>(dbuf, e, layout::c);
+            while (st.keep_running()) {
+                y <<= x;
+                bench::clobber_memory();
+            }
+            st.set_bytes_per_iteration(2 * x.size() * sizeof(T));
+            st.set_items_per_iteration(x.size());
+        });
+    }
+}
+
+template <typename T>
+void add_raw_benchmarks(const std::string& tname, size_t n)
+{
+    const std::string suffix = "/" + tname + "/" + std::to_string(n);
+    for (size_t stride : { 1, 2 }) {
+        const std::string l = stride == 1 ? "contiguous" : "strided";
+        bench::add("raw/iterate/" + l + suffix, [n, stride](bench::state& st) {
+            std::vector<T> buf(n * stride, T(1));
+            while (st.keep_running()) {
+                T s = T();
+                const T* p = buf.data();
+                for (size_t i = 0; i < n; ++i)
+                    s += p[i * stride];
+                bench::do_not_optimize(s);
+            }
+            st.set_bytes_per_iteration(n * sizeof(T));
+            st.set_items_per_iteration(n);
+        });
+        bench::add("raw/copy/" + l + suffix, [n, stride](bench::state& st) {
+            std::vector<T> buf(n * stride, T(1)), dbuf(n);
+            while (st.keep_running()) {
+                const T* p = buf.data();
+                T* q = dbuf.data();
+                for (size_t i = 0; i < n; ++i)
+                    q[i] = p[i * stride];
+                bench::clobber_memory();
+            }
+            st.set_bytes_per_iteration(2 * n * sizeof(T));
+            st.set_items_per_iteration(n);
+        });
+    }
+}
+
+template <typename T>
+void add_type(const std::string& tname)
+{
+    for (size_t n : { 1 << 12, 1 << 18, 1 << 22 }) {
+        add_raw_benchmarks<T>(tname, n);
+        add_view_benchmarks<T, 1>(tname, n);
+        add_view_benchmarks<T, 2>(tname, n);
+        add_view_benchmarks<T, 3>(tname, n);
+    }
+}
+
+bench::registrar r([] {
+    add_type<float>("float");
+    add_type<double>("double");
+    add_type<int>("int");
+});
+}
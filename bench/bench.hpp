@@ -0,0 +1,199 @@
+#ifndef BENCH_INCLUDED_8314092651
+#define BENCH_INCLUDED_8314092651
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Minimal micro-benchmark harness, modelled on Google Benchmark:
+//
+//     static bench::registrar r([] {
+//         for (size_t n : { 1 << 10, 1 << 20 })
+//             bench::add("copy/float/" + std::to_string(n), [n](bench::state& st) {
+//                 ... setup ...
+//                 while (st.keep_running())
+//                     ... the measured code ...
+//                 st.set_bytes_per_iteration(2 * n * sizeof(float));
+//                 st.set_items_per_iteration(n);
+//             });
+//     });
+//
+// Each benchmark is called with increasing iteration counts until it runs for
+// at least --min-time seconds. The results are printed as a table and, with
+// --json=<file>, written in Google Benchmark's JSON format so the usual
+// comparison tools work on them.
+
+namespace bench {
+
+template <typename T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+inline void clobber_memory()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+class state {
+public:
+    explicit state(size_t max_iterations)
+        : max_iterations(max_iterations)
+    {
+    }
+
+    // true while more iterations are needed, starts the clock on the first call
+    bool keep_running()
+    {
+        if (done_iterations == 0)
+            start = clock::now();
+        if (done_iterations == max_iterations) {
+            stop = clock::now();
+            return false;
+        }
+        ++done_iterations;
+        return true;
+    }
+
+    // the amount of work done by a single iteration
+    void set_bytes_per_iteration(size_t n) { bytes = n; }
+    void set_items_per_iteration(size_t n) { items = n; }
+
+    size_t iterations() const { return done_iterations; }
+    double seconds() const { return std::chrono::duration<double>(stop - start).count(); }
+    size_t bytes_per_iteration() const { return bytes; }
+    size_t items_per_iteration() const { return items; }
+
+private:
+    using clock = std::chrono::steady_clock;
+    size_t max_iterations;
+    size_t done_iterations = 0;
+    size_t bytes = 0, items = 0;
+    clock::time_point start, stop;
+};
+
+struct benchmark {
+    std::string name;
+    std::function<void(state&)> f;
+};
+
+inline std::vector<benchmark>& registry()
+{
+    static std::vector<benchmark> r;
+    return r;
+}
+
+inline void add(std::string name, std::function<void(state&)> f)
+{
+    registry().push_back(benchmark{ std::move(name), std::move(f) });
+}
+
+// runs `f` during static initialization, to register benchmarks from any file
+struct registrar {
+    template <typename F>
+    explicit registrar(F&& f) { f(); }
+};
+
+struct result {
+    std::string name;
+    size_t iterations;
+    double ns_per_iteration;
+    double bytes_per_second;
+    double items_per_second;
+};
+
+inline result run(const benchmark& b, double min_time)
+{
+    size_t n = 1;
+    for (;;) {
+        state st(n);
+        b.f(st);
+        const double t = st.seconds();
+        if (t >= min_time || n >= (size_t(1) << 40)) {
+            const double per_sec = st.iterations() / std::max(t, 1e-12);
+            return result{ b.name, st.iterations(), 1e9 * t / st.iterations(),
+                per_sec * st.bytes_per_iteration(), per_sec * st.items_per_iteration() };
+        }
+        // aim for min_time with some margin, grow at most 10x at a time
+        const double want = t > 0 ? 1.4 * min_time / t * n : 10.0 * n;
+        n = (size_t)std::min(std::max(want, n + 1.0), 10.0 * n);
+    }
+}
+
+inline void write_json(std::ostream& os, const std::vector<result>& results)
+{
+    os << "{\n  \"context\": {\n    \"library\": \"sx\"\n  },\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        os << "    {\n"
+           << "      \"name\": \"" << r.name << "\",\n"
+           << "      \"run_type\": \"iteration\",\n"
+           << "      \"iterations\": " << r.iterations << ",\n"
+           << "      \"real_time\": " << r.ns_per_iteration << ",\n"
+           << "      \"cpu_time\": " << r.ns_per_iteration << ",\n"
+           << "      \"time_unit\": \"ns\",\n"
+           << "      \"bytes_per_second\": " << r.bytes_per_second << ",\n"
+           << "      \"items_per_second\": " << r.items_per_second << "\n"
+           << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+// options: --filter=<substring> --min-time=<seconds> --json=<file>
+inline int main(int argc, char* argv[])
+{
+    std::string filter, json;
+    double min_time = 0.2;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (std::strncmp(a, "--filter=", 9) == 0)
+            filter = a + 9;
+        else if (std::strncmp(a, "--min-time=", 11) == 0)
+            min_time = std::atof(a + 11);
+        else if (std::strncmp(a, "--json=", 7) == 0)
+            json = a + 7;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--filter=<substring>] [--min-time=<seconds>] [--json=<file>]\n";
+            return 1;
+        }
+    }
+
+    std::vector<result> results;
+    std::printf("%-64s %14s %12s %10s %12s\n", "benchmark", "iterations", "ns/iter", "GB/s", "Melem/s");
+    for (auto& b : registry()) {
+        if (b.name.find(filter) == std::string::npos)
+            continue;
+        auto r = run(b, min_time);
+        std::printf("%-64s %14zu %12.1f %10.3f %12.3f\n", r.name.c_str(), r.iterations,
+            r.ns_per_iteration, r.bytes_per_second * 1e-9, r.items_per_second * 1e-6);
+        std::fflush(stdout);
+        results.push_back(r);
+    }
+    if (!json.empty()) {
+        std::ofstream f(json);
+        write_json(f, results);
+        if (!f) {
+            std::cerr << "can't write " << json << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
+}
+
+#endif
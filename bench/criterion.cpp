@@ -0,0 +1,133 @@
+#include "bench.hpp"
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "sx/criterion.h"
+
+// impurity proxies of all candidates at once against a scalar loop per candidate,
+// the counts in c_order (rows of candidates, as the scalar loop reads them)
+// and in fortran_order (columns of classes)
+
+namespace {
+
+struct counts {
+    std::vector<double> L; // candidates x classes, c_order
+    std::vector<double> Lf; // the same, fortran_order
+    std::vector<double> total;
+};
+
+counts make_counts(size_t m, size_t nc)
+{
+    std::mt19937 rng(8);
+    counts c;
+    c.L.resize(m * nc);
+    c.total.assign(nc, 0.0);
+    for (size_t i = 0; i < m; ++i) {
+        c.total[rng() % nc] += 1;
+        for (size_t k = 0; k < nc; ++k)
+            c.L[i * nc + k] = c.total[k];
+    }
+    for (auto& t : c.total)
+        t += 1;
+    c.Lf.resize(m * nc);
+    for (size_t i = 0; i < m; ++i)
+        for (size_t k = 0; k < nc; ++k)
+            c.Lf[k * m + i] = c.L[i * nc + k];
+    return c;
+}
+
+void add_criterion(size_t m, size_t nc)
+{
+    const std::string suffix = "/" + std::to_string(m) + "x" + std::to_string(nc);
+    bench::add("gini_proxy/scalar" + suffix, [=](bench::state& st) {
+        const auto c = make_counts(m, nc);
+        double n = 0;
+        for (auto t : c.total)
+            n += t;
+        std::vector<double> p(m);
+        while (st.keep_running()) {
+            for (size_t i = 0; i < m; ++i) {
+                double nl = 0, sl = 0, sr = 0;
+                for (size_t k = 0; k < nc; ++k) {
+                    const double l = c.L[i * nc + k], r = c.total[k] - l;
+                    nl += l;
+                    sl += l * l;
+                    sr += r * r;
+                }
+                p[i] = (nl > 0 ? sl / nl : 0) + (n - nl > 0 ? sr / (n - nl) : 0);
+            }
+            bench::do_not_optimize(p.data());
+        }
+        st.set_items_per_iteration(m);
+    });
+    bench::add("gini_proxy/1_thread" + suffix, [=](bench::state& st) {
+        const auto c = make_counts(m, nc);
+        sx::array_view<const double, 2> L(c.L.data(), { m, nc }, sx::array_layout::c_order);
+        sx::par::sequential_executor seq;
+        while (st.keep_running()) {
+            auto p = sx::gini_proxy(L, sx::make_array_view(c.total), seq);
+            bench::do_not_optimize(p.data());
+        }
+        st.set_items_per_iteration(m);
+    });
+    bench::add("gini_proxy/1_thread_fortran" + suffix, [=](bench::state& st) {
+        const auto c = make_counts(m, nc);
+        sx::array_view<const double, 2> L(c.Lf.data(), { m, nc }, sx::array_layout::fortran_order);
+        sx::par::sequential_executor seq;
+        while (st.keep_running()) {
+            auto p = sx::gini_proxy(L, sx::make_array_view(c.total), seq);
+            bench::do_not_optimize(p.data());
+        }
+        st.set_items_per_iteration(m);
+    });
+    bench::add("entropy_proxy/scalar" + suffix, [=](bench::state& st) {
+        const auto c = make_counts(m, nc);
+        double n = 0;
+        for (auto t : c.total)
+            n += t;
+        auto xlx = [](double x) { return x > 0 ? x * std::log(x) : 0.0; };
+        std::vector<double> p(m);
+        while (st.keep_running()) {
+            for (size_t i = 0; i < m; ++i) {
+                double nl = 0, s = 0;
+                for (size_t k = 0; k < nc; ++k) {
+                    const double l = c.L[i * nc + k];
+                    nl += l;
+                    s += xlx(l) + xlx(c.total[k] - l);
+                }
+                p[i] = s - xlx(nl) - xlx(n - nl);
+            }
+            bench::do_not_optimize(p.data());
+        }
+        st.set_items_per_iteration(m);
+    });
+    bench::add("entropy_proxy/1_thread" + suffix, [=](bench::state& st) {
+        const auto c = make_counts(m, nc);
+        sx::array_view<const double, 2> L(c.L.data(), { m, nc }, sx::array_layout::c_order);
+        sx::par::sequential_executor seq;
+        while (st.keep_running()) {
+            auto p = sx::entropy_proxy(L, sx::make_array_view(c.total), seq);
+            bench::do_not_optimize(p.data());
+        }
+        st.set_items_per_iteration(m);
+    });
+    bench::add("entropy_proxy/1_thread_fortran" + suffix, [=](bench::state& st) {
+        const auto c = make_counts(m, nc);
+        sx::array_view<const double, 2> L(c.Lf.data(), { m, nc }, sx::array_layout::fortran_order);
+        sx::par::sequential_executor seq;
+        while (st.keep_running()) {
+            auto p = sx::entropy_proxy(L, sx::make_array_view(c.total), seq);
+            bench::do_not_optimize(p.data());
+        }
+        st.set_items_per_iteration(m);
+    });
+}
+
+bench::registrar r([] {
+    add_criterion(256, 2);
+    add_criterion(100000, 2);
+    add_criterion(100000, 10);
+});
+}
@@ -0,0 +1,169 @@
+#include "bench.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+#include "sx/forest.h"
+
+// batched forest inference against a per-sample recursive traversal of
+// pointer-based nodes
+
+namespace {
+
+struct node {
+    int feature;
+    float threshold;
+    node *left, *right;
+    std::vector<double> value;
+};
+
+struct raw_forest {
+    std::vector<std::vector<node> > trees; // nodes[0] is the root
+};
+
+void grow(std::mt19937& rng, std::vector<node>& nodes, std::vector<int>& l, std::vector<int>& r,
+    std::vector<int>& f, std::vector<float>& t, std::vector<double>& v, int depth, int n_features,
+    int n_outputs)
+{
+    const int i = (int)l.size();
+    l.push_back(-1);
+    r.push_back(-1);
+    f.push_back(-2);
+    t.push_back(-2);
+    for (int o = 0; o < n_outputs; ++o)
+        v.push_back((double)(rng() % 1000) / 1000);
+    if (depth > 0 && rng() % 8 != 0) {
+        f[i] = (int)(rng() % n_features);
+        t[i] = (float)(rng() % 1000) / 1000;
+        const int li = (int)l.size();
+        grow(rng, nodes, l, r, f, t, v, depth - 1, n_features, n_outputs);
+        const int ri = (int)l.size();
+        grow(rng, nodes, l, r, f, t, v, depth - 1, n_features, n_outputs);
+        l[i] = li;
+        r[i] = ri;
+    }
+}
+
+void make_forests(size_t n_trees, int depth, int n_features, int n_outputs, sx::forest<float, double>& sf,
+    raw_forest& rf)
+{
+    std::mt19937 rng(4);
+    for (size_t k = 0; k < n_trees; ++k) {
+        std::vector<node> nodes;
+        std::vector<int> l, r, f;
+        std::vector<float> t;
+        std::vector<double> v;
+        grow(rng, nodes, l, r, f, t, v, depth, n_features, n_outputs);
+        const size_t n = l.size();
+        sf.push_back(sx::tree<float, double>(sx::make_array_view(l), sx::make_array_view(r),
+            sx::make_array_view(f), sx::make_array_view(t),
+            sx::array_view<double, 2>(v.data(), { n, (size_t)n_outputs }, sx::array_layout::c_order)));
+        nodes.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            nodes[i].feature = f[i];
+            nodes[i].threshold = t[i];
+            nodes[i].left = l[i] < 0 ? nullptr : &nodes[l[i]];
+            nodes[i].right = r[i] < 0 ? nullptr : &nodes[r[i]];
+            nodes[i].value.assign(v.begin() + i * n_outputs, v.begin() + (i + 1) * n_outputs);
+        }
+        rf.trees.push_back(std::move(nodes));
+    }
+}
+
+const node* leaf_of(const node* p, const float* x)
+{
+    if (!p->left)
+        return p;
+    return leaf_of(x[p->feature] <= p->threshold ? p->left : p->right, x);
+}
+
+void add_forest(size_t n_trees, int depth)
+{
+    const int n_features = 32, n_outputs = 2;
+    const size_t n = 1 << 14;
+    const std::string suffix = "/" + std::to_string(n_trees) + "x" + std::to_string(depth) + "/" + std::to_string(n);
+    auto make_X = [=] {
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> u(0, 1);
+        std::vector<float> X(n * n_features);
+        for (auto& x : X)
+            x = u(rng);
+        return X;
+    };
+    bench::add("raw/forest_predict" + suffix, [=](bench::state& st) {
+        sx::forest<float, double> sf;
+        raw_forest rf;
+        make_forests(n_trees, depth, n_features, n_outputs, sf, rf);
+        auto X = make_X();
+        std::vector<double> P(n * n_outputs);
+        while (st.keep_running()) {
+            for (size_t i = 0; i < n; ++i) {
+                double* p = P.data() + i * n_outputs;
+                std::fill_n(p, n_outputs, 0.0);
+                for (auto& t : rf.trees) {
+                    auto leaf = leaf_of(t.data(), X.data() + i * n_features);
+                    for (int o = 0; o < n_outputs; ++o)
+                        p[o] += leaf->value[o];
+                }
+                for (int o = 0; o < n_outputs; ++o)
+                    p[o] /= n_trees;
+            }
+            bench::do_not_optimize(P.data());
+        }
+        st.set_items_per_iteration(n);
+    });
+    bench::add("forest_predict/1_thread" + suffix, [=](bench::state& st) {
+        sx::forest<float, double> sf;
+        raw_forest rf;
+        make_forests(n_trees, depth, n_features, n_outputs, sf, rf);
+        auto X = make_X();
+        sx::array_view<const float, 2> Xv(X.data(), { n, (size_t)n_features }, sx::array_layout::c_order);
+        sx::par::sequential_executor seq;
+        while (st.keep_running()) {
+            auto P = sx::predict(sf, Xv, sx::predict_options(), seq);
+            bench::do_not_optimize(P.data());
+        }
+        st.set_items_per_iteration(n);
+    });
+    for (auto mode : { sx::inference::node_walk, sx::inference::quickscorer }) {
+        const std::string name = mode == sx::inference::node_walk ? "node_walk" : "quickscorer";
+        bench::add("forest_predict/" + name + "/1_thread" + suffix, [=](bench::state& st) {
+            sx::forest<float, double> sf;
+            raw_forest rf;
+            make_forests(n_trees, depth, n_features, n_outputs, sf, rf);
+            auto X = make_X();
+            sx::array_view<const float, 2> Xv(X.data(), { n, (size_t)n_features }, sx::array_layout::c_order);
+            sx::par::sequential_executor seq;
+            sx::predict_options opts;
+            opts.mode = mode;
+            sx::predict(sf, Xv, opts, seq); // builds the model
+            while (st.keep_running()) {
+                auto P = sx::predict(sf, Xv, opts, seq);
+                bench::do_not_optimize(P.data());
+            }
+            st.set_items_per_iteration(n);
+        });
+    }
+    bench::add("forest_predict/default_pool" + suffix, [=](bench::state& st) {
+        sx::forest<float, double> sf;
+        raw_forest rf;
+        make_forests(n_trees, depth, n_features, n_outputs, sf, rf);
+        auto X = make_X();
+        sx::array_view<const float, 2> Xv(X.data(), { n, (size_t)n_features }, sx::array_layout::c_order);
+        while (st.keep_running()) {
+            auto P = sx::predict(sf, Xv);
+            bench::do_not_optimize(P.data());
+        }
+        st.set_items_per_iteration(n);
+    });
+}
+
+bench::registrar r([] {
+    add_forest(2000, 2);
+    add_forest(500, 3);
+    add_forest(100, 4);
+    add_forest(100, 6);
+    add_forest(10, 8);
+    add_forest(100, 12);
+});
+}
@@ -0,0 +1,97 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include "sx/multi_array.h"
+#include "sx/sort.h"
+
+// sortperm and indmax_along along both dimensions of c_order and
+// fortran_order matrices, against the same work on raw pointers
+
+namespace {
+
+template <typename T>
+sx::matrix<T> random_matrix(size_t rows, size_t cols, sx::array_layout_t layout)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> u(0, 1000);
+    sx::matrix<T> X(typename sx::matrix<T>::extents_type(rows, cols), layout);
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            X(i, j) = (T)u(rng);
+    return X;
+}
+
+template <typename T>
+void add_type(const std::string& tname)
+{
+    const size_t rows = 1 << 12, cols = 64;
+    for (auto layout : { sx::array_layout::c_order, sx::array_layout::fortran_order }) {
+        const std::string l = layout == sx::array_layout::c_order ? "c_order" : "fortran_order";
+        for (sx::rank_type dim : { 0, 1 }) {
+            const std::string suffix = "/" + l + "/" + tname + "/dim" + std::to_string(dim) + "/"
+                + std::to_string(rows) + "x" + std::to_string(cols);
+            bench::add("sortperm" + suffix, [=](bench::state& st) {
+                auto X = random_matrix<T>(rows, cols, layout);
+                while (st.keep_running()) {
+                    auto P = sx::sortperm<int>(sx::array_view<const T, 2>(X.view()), dim);
+                    bench::do_not_optimize(P.data());
+                }
+                st.set_bytes_per_iteration(rows * cols * sizeof(T));
+                st.set_items_per_iteration(rows * cols);
+            });
+            bench::add("indmax_along" + suffix, [=](bench::state& st) {
+                auto X = random_matrix<T>(rows, cols, layout);
+                while (st.keep_running()) {
+                    auto M = sx::indmax_along(sx::array_view<const T, 2>(X.view()), dim);
+                    bench::do_not_optimize(M.data());
+                }
+                st.set_bytes_per_iteration(rows * cols * sizeof(T));
+                st.set_items_per_iteration(rows * cols);
+            });
+        }
+    }
+
+    // contiguous columns of length n
+    for (size_t n : { 64, 1 << 12 }) {
+        const size_t m = rows * cols / n;
+        const std::string suffix = "/" + tname + "/" + std::to_string(m) + "x" + std::to_string(n);
+        bench::add("raw/sortperm" + suffix, [=](bench::state& st) {
+            auto X = random_matrix<T>(n, m, sx::array_layout::fortran_order);
+            std::vector<int> P(n * m);
+            while (st.keep_running()) {
+                for (size_t k = 0; k < m; ++k) {
+                    const T* x = X.data() + k * n;
+                    int* p = P.data() + k * n;
+                    std::iota(p, p + n, 0);
+                    std::stable_sort(p, p + n, [x](int a, int b) { return x[a] < x[b]; });
+                }
+                bench::do_not_optimize(P.data());
+            }
+            st.set_bytes_per_iteration(n * m * sizeof(T));
+            st.set_items_per_iteration(n * m);
+        });
+        bench::add("raw/indmax" + suffix, [=](bench::state& st) {
+            auto X = random_matrix<T>(n, m, sx::array_layout::fortran_order);
+            std::vector<size_t> M(m);
+            while (st.keep_running()) {
+                for (size_t k = 0; k < m; ++k) {
+                    const T* x = X.data() + k * n;
+                    M[k] = std::max_element(x, x + n) - x;
+                }
+                bench::do_not_optimize(M.data());
+            }
+            st.set_bytes_per_iteration(n * m * sizeof(T));
+            st.set_items_per_iteration(n * m);
+        });
+    }
+}
+
+bench::registrar r([] {
+    add_type<float>("float");
+    add_type<double>("double");
+});
+}
@@ -0,0 +1,165 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "sx/histogram_splitter.h"
+#include "sx/splitter.h"
+
+// growing a regression tree to a fixed depth: the presorted and the histogram
+// splitters against sorting the samples of every feature at every node
+
+namespace {
+
+const size_t kFeatures = 8;
+const size_t kBins = 64;
+
+struct data {
+    std::vector<float> X; // c_order
+    std::vector<std::uint8_t> Xb; // X binned, c_order
+    std::vector<double> y, ones;
+};
+
+data make_data(size_t n)
+{
+    std::mt19937 rng(6);
+    data d;
+    d.X.resize(n * kFeatures);
+    d.Xb.resize(n * kFeatures);
+    d.y.resize(n);
+    d.ones.assign(n, 1.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < kFeatures; ++j) {
+            const auto b = rng() % kBins;
+            d.Xb[i * kFeatures + j] = (std::uint8_t)b;
+            d.X[i * kFeatures + j] = (float)b + (float)(rng() % 1000) / 1000;
+        }
+        d.y[i] = d.X[i * kFeatures] * 0.1 + (d.X[i * kFeatures + 1] > 20 ? 1 : 0) + (double)(rng() % 100) / 100;
+    }
+    return d;
+}
+
+// sorts the node's samples by each feature, the split rule of presorted_splitter
+void grow_naive(const data& d, std::vector<std::uint32_t>& s, size_t begin, size_t end, int depth)
+{
+    if (depth == 0 || end - begin < 2)
+        return;
+    double sum = 0;
+    for (size_t k = begin; k < end; ++k)
+        sum += d.y[s[k]];
+    const double n = (double)(end - begin), parent = sum * sum / n;
+    double best = 0;
+    size_t best_f = 0;
+    float best_t = 0;
+    std::vector<std::uint32_t> o(s.begin() + begin, s.begin() + end);
+    for (size_t j = 0; j < kFeatures; ++j) {
+        std::sort(o.begin(), o.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return d.X[a * kFeatures + j] < d.X[b * kFeatures + j];
+        });
+        double left = 0;
+        for (size_t k = 1; k < o.size(); ++k) {
+            left += d.y[o[k - 1]];
+            const float a = d.X[o[k - 1] * kFeatures + j], c = d.X[o[k] * kFeatures + j];
+            if (!(a < c))
+                continue;
+            const double right = sum - left;
+            const double gain = left * left / (double)k + right * right / (n - (double)k) - parent;
+            if (gain > best) {
+                best = gain;
+                best_f = j;
+                best_t = a;
+            }
+        }
+    }
+    if (best <= 0)
+        return;
+    auto mid = std::stable_partition(s.begin() + begin, s.begin() + end,
+        [&](std::uint32_t i) { return !(d.X[i * kFeatures + best_f] > best_t); });
+    const size_t m = (size_t)(mid - s.begin());
+    grow_naive(d, s, begin, m, depth - 1);
+    grow_naive(d, s, m, end, depth - 1);
+}
+
+template <typename Executor>
+void grow_presorted(sx::presorted_splitter<float>& sp, const data& d,
+    const sx::presorted_splitter<float>::node_range& node, int depth, Executor& ex)
+{
+    if (depth == 0)
+        return;
+    auto s = sp.find_split(node, sx::make_array_view(d.y), sx::split_options(), ex);
+    if (!s.is_valid())
+        return;
+    auto c = sp.apply_split(node, s, ex);
+    grow_presorted(sp, d, c.first, depth - 1, ex);
+    grow_presorted(sp, d, c.second, depth - 1, ex);
+}
+
+template <typename Executor>
+void grow_histogram(sx::histogram_splitter& sp, const data& d, const sx::histogram_splitter::node& node,
+    int depth, Executor& ex)
+{
+    auto s = depth == 0 ? sx::split<std::uint8_t>() : sp.find_split(node, sx::split_options(), ex);
+    if (!s.is_valid()) {
+        sp.release(node);
+        return;
+    }
+    auto c = sp.apply_split(node, s, sx::make_array_view(d.y), sx::make_array_view(d.ones), ex);
+    grow_histogram(sp, d, c.first, depth - 1, ex);
+    grow_histogram(sp, d, c.second, depth - 1, ex);
+}
+
+void add_splitters(size_t n, int depth)
+{
+    const std::string suffix = "/" + std::to_string(n) + "x" + std::to_string(depth);
+    bench::add("grow_tree_naive/1_thread" + suffix, [=](bench::state& st) {
+        const auto d = make_data(n);
+        std::vector<std::uint32_t> s(n);
+        while (st.keep_running()) {
+            for (size_t i = 0; i < n; ++i)
+                s[i] = (std::uint32_t)i;
+            grow_naive(d, s, 0, n, depth);
+            bench::do_not_optimize(s.data());
+        }
+        st.set_items_per_iteration(n);
+    });
+    bench::add("grow_tree_presorted/1_thread" + suffix, [=](bench::state& st) {
+        const auto d = make_data(n);
+        sx::array_view<const float, 2> X(d.X.data(), { n, kFeatures }, sx::array_layout::c_order);
+        sx::par::sequential_executor seq;
+        while (st.keep_running()) {
+            sx::presorted_splitter<float> sp(X, seq);
+            grow_presorted(sp, d, sp.root(), depth, seq);
+            bench::clobber_memory();
+        }
+        st.set_items_per_iteration(n);
+    });
+    bench::add("grow_tree_histogram/1_thread" + suffix, [=](bench::state& st) {
+        const auto d = make_data(n);
+        sx::array_view<const std::uint8_t, 2> Xb(d.Xb.data(), { n, kFeatures }, sx::array_layout::c_order);
+        sx::par::sequential_executor seq;
+        while (st.keep_running()) {
+            sx::histogram_splitter sp(Xb, kBins);
+            sp.build_histogram(sp.root(), sx::make_array_view(d.y), sx::make_array_view(d.ones), seq);
+            grow_histogram(sp, d, sp.root(), depth, seq);
+            bench::clobber_memory();
+        }
+        st.set_items_per_iteration(n);
+    });
+    bench::add("grow_tree_histogram/default_pool" + suffix, [=](bench::state& st) {
+        const auto d = make_data(n);
+        sx::array_view<const std::uint8_t, 2> Xb(d.Xb.data(), { n, kFeatures }, sx::array_layout::c_order);
+        while (st.keep_running()) {
+            sx::histogram_splitter sp(Xb, kBins);
+            sp.build_histogram(sp.root(), sx::make_array_view(d.y), sx::make_array_view(d.ones));
+            grow_histogram(sp, d, sp.root(), depth, sx::par::default_executor());
+            bench::clobber_memory();
+        }
+        st.set_items_per_iteration(n);
+    });
+}
+
+bench::registrar r([] {
+    add_splitters(100000, 6);
+});
+}
@@ -0,0 +1,19 @@
+# sx_add_compiled_forest(<target> <header>)
+#
+# Builds the header written by sx::write_compiled_forest (sx/codegen.h) into a
+# loadable module <target> for sx::compiled_forest. The header may be the
+# OUTPUT of a custom command in the same directory.
+function(sx_add_compiled_forest target header)
+    get_filename_component(header "${header}" ABSOLUTE)
+    set(src "${CMAKE_CURRENT_BINARY_DIR}/${target}_export.cpp")
+    set(content "#define SX_COMPILED_FOREST_EXPORT\n#include \"${header}\"\n")
+    if(EXISTS "${src}")
+        file(READ "${src}" old)
+    endif()
+    if(NOT old STREQUAL content)
+        file(WRITE "${src}" "${content}")
+    endif()
+    set_source_files_properties("${src}" PROPERTIES OBJECT_DEPENDS "${header}")
+    add_library(${target} MODULE "${src}")
+    set_target_properties(${target} PROPERTIES PREFIX "")
+endfunction()
@@ -2,6 +2,9 @@
 #define RANGES_SX_VIEW_TAKE_AT_HPP
 
 #include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
 //#include <atomic>
 //#include <utility>
 //#include "sx/type_traits.h"
@@ -20,6 +23,7 @@
 //#include <range/v3/view/view.hpp>
 //#include <range/v3/view/all.hpp>
 #include "range/range.hpp"
+#include "sx/utility.h"
 
 namespace ranges
 {
@@ -44,8 +48,21 @@ namespace ranges
 				>::value;
 			};
 
-            //todo certain memfns should be enabled depending
-            //on iterator_category
+			// pointers and the iterators of std::vector and std::string
+			// address contiguous elements
+			template<typename T, typename V = std::remove_cv_t<typename std::iterator_traits<T>::value_type>>
+			struct is_contiguous_iterator {
+				static const bool value = std::is_pointer<T>::value
+					|| (!std::is_same<V, bool>::value
+						&& (std::is_same<T, typename std::vector<V>::iterator>::value
+							|| std::is_same<T, typename std::vector<V>::const_iterator>::value))
+					|| std::is_same<T, std::string::iterator>::value
+					|| std::is_same<T, std::string::const_iterator>::value;
+			};
+
+			// take_at_iterator<D, I>: iterates over data[*index_it]
+			// D is the random access iterator of the data, I is the iterator of
+			// the indices, the category of take_at_iterator is the category of I
 			template<typename D, typename I,
 				typename = std::enable_if_t<
 					is_random_access_iterator<D>::value
@@ -53,19 +70,19 @@ namespace ranges
 			>
 			struct take_at_iterator
 			: public std::iterator<
-					typename I::iterator_category
-					, typename D::value_type
-					, typename I::difference_type
-					, typename D::pointer
-					, typename D::reference
+					typename std::iterator_traits<I>::iterator_category
+					, typename std::iterator_traits<D>::value_type
+					, typename std::iterator_traits<I>::difference_type
+					, typename std::iterator_traits<D>::pointer
+					, typename std::iterator_traits<D>::reference
 				>
 			{
                 using iterator = std::iterator<
-                typename I::iterator_category
-                , typename D::value_type
-                , typename I::difference_type
-                , typename D::pointer
-                , typename D::reference
+                typename std::iterator_traits<I>::iterator_category
+                , typename std::iterator_traits<D>::value_type
+                , typename std::iterator_traits<I>::difference_type
+                , typename std::iterator_traits<D>::pointer
+                , typename std::iterator_traits<D>::reference
                 >;
 
             public:
@@ -75,8 +92,8 @@ namespace ranges
                 using typename iterator::pointer;
                 using typename iterator::reference;
 			private:
-				const D data_begin;
-				const difference_type data_size;
+				D data_begin;
+				difference_type data_size = 0;
 				I base_it;
 			public:
 				using this_type = take_at_iterator;
@@ -100,23 +117,27 @@ namespace ranges
 				}
 				pointer operator->() const
 				{
-					assert(0 <= *base_it && *base_it < data_size);
-					return (data_begin + *base_it).operator->();
+					return &**this;
 				}
-				decltype(data_begin[*base_it]) operator[](difference_type y) const {
-					const auto idx = *base_it[y];
+				reference operator[](difference_type y) const
+				{
+					static_assert(is_random_access_iterator<I>::value, "operator[] needs random access indices");
+					const auto idx = base_it[y];
 					assert(0 <= idx && idx < data_size);
 					return data_begin[idx];
 				}
+				const D& data() const { return data_begin; }
+				const I& base() const { return base_it; }
 
 				// modifiers
 				this_type& operator++() { ++base_it; return *this; }
 				this_type operator++(int) { this_type x(*this); ++(*this); return x; }
 				this_type& operator--() { --base_it; return *this; }
-				this_type operator--(int) const { this_type x(*this); --(*this); return x; }
+				this_type operator--(int) { this_type x(*this); --(*this); return x; }
 				void swap(this_type& y) {
 					using std::swap;
 					swap(data_begin, y.data_begin);
+					swap(data_size, y.data_size);
 					swap(base_it, y.base_it);
 				}
 				this_type& operator+=(difference_type y) { base_it += y; return *this; }
@@ -135,7 +156,7 @@ namespace ranges
                 //operations
                 this_type operator+(difference_type y) const { this_type x(*this); x += y; return x; }
                 this_type operator-(difference_type y) const { this_type x(*this); x -= y; return x; }
-                difference_type operator-(const this_type& y) {
+                difference_type operator-(const this_type& y) const {
                     return base_it - y.base_it;
                 }
 			};
@@ -146,6 +167,86 @@ namespace ranges
 			template<typename D, typename I>
             inline take_at_iterator<D, I> operator+(typename take_at_iterator<D, I>::difference_type x, const take_at_iterator<D, I>& y) { return y + x; }
 
+            // the range returned by take_at
+            // knows its size and, with random access indices, is random access itself
+            template<typename D, typename I>
+            struct take_at_view
+            : public range_default_sentinel<take_at_iterator<D, I>>
+            {
+                using iterator = take_at_iterator<D, I>;
+                using base_type = range_default_sentinel<iterator>;
+                using size_type = typename std::make_unsigned<typename iterator::difference_type>::type;
+                using reference = typename iterator::reference;
+
+                // elements of this many iterations ahead are prefetched by gather_into
+                static const int kPrefetchDistance = 16;
+
+                take_at_view() = default;
+                take_at_view(iterator b, iterator e)
+                : base_type(b, e)
+                {}
+
+                size_type size() const { return std::distance(this->begin().base(), this->end().base()); }
+                bool empty() const { return this->begin() == this->end(); }
+                reference operator[](size_type i) const { return this->begin()[i]; }
+
+                // copies the elements to dst, returns the end of the output
+                // the data of later elements is prefetched, for contiguous data
+                // and random access indices the loop is unrolled
+                template<typename O>
+                O gather_into(O dst) const
+                {
+                    const D data = this->begin().data();
+                    I it = this->begin().base();
+                    const I e = this->end().base();
+                    if (it == e)
+                        return dst;
+                    return gather_into_impl(data, it, e, dst,
+                        std::integral_constant<bool, is_contiguous_iterator<D>::value && is_random_access_iterator<I>::value>());
+                }
+
+            private:
+                template<typename O>
+                static O gather_into_impl(const D& data, I it, const I& e, O dst, std::false_type)
+                {
+                    for (; it != e; ++it, ++dst) {
+                        prefetch_ahead(data, it, e, typename iterator::iterator_category());
+                        *dst = data[*it];
+                    }
+                    return dst;
+                }
+                template<typename O>
+                static O gather_into_impl(const D& d, I it, const I& e, O dst, std::true_type)
+                {
+                    static_assert(is_random_access_iterator<I>::value, "");
+                    const auto data = std::addressof(*d);
+                    for (; e - it >= kPrefetchDistance + 4; it += 4) {
+                        SX_PREFETCH(data + it[kPrefetchDistance]);
+                        SX_PREFETCH(data + it[kPrefetchDistance + 1]);
+                        SX_PREFETCH(data + it[kPrefetchDistance + 2]);
+                        SX_PREFETCH(data + it[kPrefetchDistance + 3]);
+                        *dst = data[it[0]];
+                        ++dst;
+                        *dst = data[it[1]];
+                        ++dst;
+                        *dst = data[it[2]];
+                        ++dst;
+                        *dst = data[it[3]];
+                        ++dst;
+                    }
+                    for (; it != e; ++it, ++dst)
+                        *dst = data[*it];
+                    return dst;
+                }
+                // prefetches the element kPrefetchDistance ahead if the indices are random access
+                static void prefetch_ahead(const D& data, const I& it, const I& e, std::random_access_iterator_tag)
+                {
+                    if (e - it > kPrefetchDistance)
+                        SX_PREFETCH(&data[it[kPrefetchDistance]]);
+                }
+                static void prefetch_ahead(const D&, const I&, const I&, std::input_iterator_tag) {}
+            };
+
 			//take_at(data, indices): return data[indices]
             struct take_at_fn
             {
@@ -155,19 +256,17 @@ namespace ranges
 						has_random_access_iterator<RngData>::value
 					>
 				>
-                range_default_sentinel<
-                    take_at_iterator<
+                take_at_view<
                         range_iterator_t<RngData>
                         , range_iterator_t<RngIdcs>
-                    >
                 >
 				operator()(RngData && rngdata, RngIdcs && rngidcs) const
                 {
 					using it_t = take_at_iterator<range_iterator_t<RngData>, range_iterator_t<RngIdcs>>;
-                    //using idcs_iterator_cat_t = typename range_iterator_t<RngIdcs>::iterator_category;
+					auto data_size = end(rngdata) - begin(rngdata);
                     return {
-						it_t(begin(rngdata), rngdata.size(), begin(rngidcs))
-						, it_t(begin(rngdata), rngdata.size(), end(rngidcs))
+						it_t(begin(rngdata), data_size, begin(rngidcs))
+						, it_t(begin(rngdata), data_size, end(rngidcs))
 					};
                 }
             };
@@ -7,6 +7,8 @@
 #include <cassert>
 
 #include "sx/abbrev.h"
+#include "sx/instrument.h"
+#include "sx/memory.h"
 #include "range/range_traits.hpp"
 
 namespace sx {
@@ -178,6 +180,9 @@ void range_mul_scalar(X& x, const Y& y)
 template <typename SizeT, typename RangeA, typename RangeV>
 std::vector<SizeT> searchsorted(RangeA&& a, RangeV&& v)
 {
+    SX_INSTRUMENT_SCOPE("searchsorted", v.size(), v.size() * sizeof(SizeT));
+    SX_INSTRUMENT_PATH(instrument::path::fallback);
+    memory::details::on_untracked_allocate("searchsorted", v.size() * sizeof(SizeT));
     std::vector<SizeT> result;
     result.reserve(v.size());
     for (auto& x : v)
@@ -185,6 +190,19 @@ std::vector<SizeT> searchsorted(RangeA&& a, RangeV&& v)
     return result;
 }
 
+// searchsorted into an output iterator, returns the end of the output
+template <typename RangeA, typename RangeV, typename OutputIt>
+OutputIt searchsorted(RangeA&& a, RangeV&& v, OutputIt out)
+{
+    SX_INSTRUMENT_SCOPE("searchsorted", v.size(), v.size() * sizeof(*out));
+    SX_INSTRUMENT_PATH(instrument::path::fallback);
+    for (auto& x : v) {
+        *out = std::lower_bound(BEGINEND(a), x) - a.begin();
+        ++out;
+    }
+    return out;
+}
+
 template <typename T, typename Rng>
 T sum(Rng&& rng)
 {
@@ -258,11 +276,14 @@ template <typename ResultType, typename Rng,
     typename = std::enable_if_t<std::is_integral<ranges::range_value_t<Rng> >::value> >
 void bincount(std::vector<ResultType>& result, Rng&& rng)
 {
+    SX_INSTRUMENT_SCOPE("bincount", rng.size(), rng.size() * sizeof(ranges::range_value_t<Rng>));
+    SX_INSTRUMENT_PATH(instrument::path::fallback);
     if (rng.empty())
         result.clear();
     else {
         auto mm = std::minmax_element(BEGINEND(rng));
         assert(*mm.first >= 0);
+        memory::details::on_untracked_allocate("bincount", (*mm.second + 1) * sizeof(ResultType));
         result.assign(*mm.second + 1, 0);
         for (auto& x : rng)
             ++result[x];
@@ -2,9 +2,12 @@
 #define _IMPL_ARRAY_VIEW_H_ 1
 
 #include <stdexcept>
+#include <algorithm>
 #include "sx/type_traits.h"
 #include <utility>
 #include <numeric>
+#include <tuple>
+#include <cstdlib>
 #include <vector>
 #include <cmath>
 #include <string>
@@ -14,6 +17,8 @@
 #include "sx/coordinate.h"
 #include "sx/random_access_iterator_pair.h"
 #include "sx/array_par.h"
+#include "sx/fast_divisor.h"
+#include "sx/instrument.h"
 
 namespace sx {
 
@@ -30,7 +35,7 @@ struct array_layout_t {
     }
     constexpr bool operator==(const array_layout_t& x) const noexcept { return value == x.value; }
     constexpr bool operator!=(const array_layout_t& x) const noexcept { return value != x.value; }
-    const int value;
+    int value;
 };
 
 namespace array_layout {
@@ -107,9 +112,13 @@ namespace details {
         return to_pointer(t[0]);
     }
 
-    template <typename T, typename ValueType>
+    template <typename T, typename ValueType, typename = void>
+    struct is_viewable : std::false_type {
+    };
 
-    struct is_viewable
+    template <typename T, typename ValueType>
+    struct is_viewable<T, ValueType,
+        decltype((void)std::declval<T>().size(), (void)std::declval<T>().data())>
         : std::integral_constant<bool, std::is_convertible<decltype(std::declval<T>().size()),
                                            ptrdiff_t>::value
                   && std::is_convertible<decltype(std::declval<T>().data()),
@@ -166,6 +175,9 @@ namespace details {
     using extents_template = array_par<size_t, Rank>;
     template <rank_type Rank>
     using indices_template = array_par<size_t, Rank>;
+    // strides are signed, slices with negative step walk backwards
+    template <rank_type Rank>
+    using strides_template = array_par<std::ptrdiff_t, Rank>;
 
     template <rank_type Rank, typename T, typename U>
     constexpr bool is_within_extents(T&& idx,
@@ -362,21 +374,29 @@ struct index_or_fromend_or_length : protected index_or_fromend {
 };
 
 //encapsulates a slice between a `index_or_fromend` to
-//`index_or_fromend_or_length` values
+//`index_or_fromend_or_length` values, with an optional step:
+//every `step`-th element of [from, to) is taken, a negative step walks
+//from the last element of [from, to) backwards like Python slices, e.g.
+//{0, end, -1} reverses a dimension, {0, end, -2} takes 5, 3, 1 of 6 elements,
+//{1, end, 2} takes the odd indices
 struct slice_bounds {
     const index_or_fromend from;
     const index_or_fromend_or_length to_or_length;
+    const std::ptrdiff_t step;
 
     template <typename F, typename T>
-    constexpr slice_bounds(F from, T to_or_length)
+    constexpr slice_bounds(F from, T to_or_length, std::ptrdiff_t step = 1)
         : from(from)
         , to_or_length(to_or_length)
+        , step(step)
     {
+        assert(step != 0);
     }
 
     constexpr slice_bounds(all_fn)
         : from(0)
         , to_or_length(sx::end)
+        , step(1)
     {
     }
 
@@ -388,8 +408,129 @@ struct slice_bounds {
             ? to_or_length.value
             : to_or_length.index_when_not_length(extent) - from.index(extent);
     }
+
+    //number of elements taken from [from, to) with `step`
+    constexpr size_t count(size_t extent) const
+    {
+        const size_t n = length(extent);
+        const size_t k = (size_t)(step < 0 ? -step : step);
+        return (n + k - 1) / k;
+    }
 };
 
+namespace details {
+    // subscript arguments of array_view::operator(): an index or a slice
+    template <typename A>
+    struct is_slice_subscript
+        : std::integral_constant<bool, std::is_same<std::decay_t<A>, slice_bounds>::value
+              || std::is_same<std::decay_t<A>, all_fn>::value> {
+    };
+    template <typename... Args>
+    struct are_subscripts;
+    template <>
+    struct are_subscripts<> : std::true_type {
+    };
+    template <typename A, typename... Args>
+    struct are_subscripts<A, Args...>
+        : std::integral_constant<bool, (std::is_integral<std::decay_t<A> >::value || is_slice_subscript<A>::value)
+              && are_subscripts<Args...>::value> {
+    };
+    template <typename... Args>
+    struct count_slices;
+    template <>
+    struct count_slices<> : std::integral_constant<rank_type, 0> {
+    };
+    template <typename A, typename... Args>
+    struct count_slices<A, Args...>
+        : std::integral_constant<rank_type, is_slice_subscript<A>::value + count_slices<Args...>::value> {
+    };
+    // T& if all arguments are indices, array_view<T, number of slices> otherwise
+    template <typename T, typename... Args>
+    using subscript_result_t = std::conditional_t<count_slices<Args...>::value == 0,
+        T&, array_view<T, count_slices<Args...>::value> >;
+
+    // dimensions in loop nest order, outermost first: by decreasing |stride|
+    template <rank_type Rank>
+    std::array<rank_type, Rank> loop_order(const std::array<std::ptrdiff_t, Rank>& strides)
+    {
+        std::array<rank_type, Rank> order;
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&strides](rank_type a, rank_type b) {
+            return std::abs(strides[a]) > std::abs(strides[b]);
+        });
+        return order;
+    }
+
+    template <typename Ptrs, typename... V, size_t... I>
+    void advance_pointers(Ptrs& p, rank_type d, std::ptrdiff_t k, std::index_sequence<I...>, const V&... v)
+    {
+        (void)std::initializer_list<int>{ (std::get<I>(p) += k * v.strides(d), 0)... };
+    }
+    template <typename F, typename Ptrs, typename... V, size_t... I>
+    void call_on_run(F& f, size_t n, const Ptrs& p, rank_type d, std::index_sequence<I...>, const V&... v)
+    {
+        f(n, std::get<I>(p)..., v.strides(d)...);
+    }
+
+    // kernel of the same-shape copy: dp[i * ds] = sp[i * ss], i < n
+    struct copy_run {
+        template <typename T, typename U>
+        void operator()(size_t n, T* dp, U* sp, std::ptrdiff_t ds, std::ptrdiff_t ss) const
+        {
+            const std::ptrdiff_t m = (std::ptrdiff_t)n;
+            if (ss == 0) {
+                const T v = *sp;
+                if (ds == 1)
+                    std::fill_n(dp, m, v);
+                else
+                    for (std::ptrdiff_t i = 0; i < m; ++i)
+                        dp[i * ds] = v;
+            }
+            else if (ds == 1 && ss == 1)
+                std::copy_n(sp, m, dp);
+            else if (ds == -1 && ss == -1)
+                std::copy_n(sp - (m - 1), m, dp - (m - 1));
+            else
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    dp[i * ds] = sp[i * ss];
+        }
+    };
+
+    // traverses same-shape views in a loop nest of the dimensions in `order`
+    // and calls f(n, p0, p1, .., s0, s1, ..) for each run of the innermost
+    // dimension: the n elements p0[i * s0], p1[i * s1], ..
+    // a zero stride means the same element for the whole run, so the kernels
+    // can load it once (broadcasting)
+    template <rank_type Rank, typename F, typename... V>
+    void for_each_run(const std::array<size_t, Rank>& e, const std::array<rank_type, Rank>& order,
+        F&& f, const V&... v)
+    {
+        for (rank_type d = 0; d < Rank; ++d)
+            if (e[d] == 0)
+                return;
+        auto p = std::make_tuple(v.data()...);
+        const auto seq = std::index_sequence_for<V...>();
+        const rank_type inner = order[Rank - 1];
+        std::array<size_t, Rank> idx;
+        idx.fill(0);
+        for (;;) {
+            call_on_run(f, e[inner], p, inner, seq, v...);
+            int k = (int)Rank - 2;
+            for (; k >= 0; --k) {
+                const rank_type d = order[k];
+                if (++idx[d] < e[d]) {
+                    advance_pointers(p, d, 1, seq, v...);
+                    break;
+                }
+                advance_pointers(p, d, -(std::ptrdiff_t)(e[d] - 1), seq, v...);
+                idx[d] = 0;
+            }
+            if (k < 0)
+                break;
+        }
+    }
+}
+
 template <typename T, rank_type Rank = 1>
 class array_view {
     static_assert(Rank > 0, "rank must be > 0");
@@ -400,6 +541,7 @@ public:
     using size_type = ::sx::size_t;
     using indices_type = details::indices_template<Rank>;
     using extents_type = details::extents_template<Rank>;
+    using strides_type = details::strides_template<Rank>;
     using value_type = typename std::remove_const<T>::type;
     using pointer = T*;
     using reference = T&;
@@ -410,7 +552,7 @@ protected:
     // state
     pointer data_ptr;
     extents_type bnd;
-    indices_type srd;
+    strides_type srd;
 
 public:
     // construction
@@ -420,7 +562,7 @@ public:
     }
 
     // fundamental ctor
-    constexpr array_view(pointer data, extents_type extents, indices_type strides) noexcept
+    constexpr array_view(pointer data, extents_type extents, strides_type strides) noexcept
         : data_ptr(data),
           bnd(extents),
           srd(strides)
@@ -441,13 +583,13 @@ public:
         if (layout == array_layout::c_order) {
             srd[Rank - 1] = 1;
             for (int i = (int)Rank - 2; i >= 0; --i)
-                srd[i] = srd[i + 1] * bnd[i + 1];
+                srd[i] = srd[i + 1] * (std::ptrdiff_t)bnd[i + 1];
         }
         else {
             assert(layout == array_layout::fortran_order);
             srd[0] = 1;
             for (rank_type i = 1; i < Rank; ++i)
-                srd[i] = srd[i - 1] * bnd[i - 1];
+                srd[i] = srd[i - 1] * (std::ptrdiff_t)bnd[i - 1];
         }
     }
 
@@ -532,8 +674,8 @@ public:
     constexpr const std::array<size_t, Rank>& extents() const noexcept { return bnd; }
     constexpr size_t extents(rank_type i) const noexcept { return bnd[i]; }
 
-    constexpr const std::array<size_t, Rank>& strides() const noexcept { return srd; }
-    constexpr size_t strides(rank_type i) const noexcept { return srd[i]; }
+    constexpr const std::array<std::ptrdiff_t, Rank>& strides() const noexcept { return srd; }
+    constexpr std::ptrdiff_t strides(rank_type i) const noexcept { return srd[i]; }
 
     constexpr size_type size() const noexcept
     {
@@ -558,45 +700,59 @@ public:
         assert(details::is_within_extents<Rank>(idx, bnd));
         auto ptr = data_ptr;
         for (int i = 0; i < Rank; i++) {
-            ptr += idx[i] * srd[i];
+            ptr += (std::ptrdiff_t)idx[i] * srd[i];
         }
         return *ptr;
     }
 
-    //todo: probably this could be solved in a general way with some metaprogramming
-    //with variadic templates
-    //however I'm not sure a variadic template could handle
-    //the case where slice_bounds is initialized with {x, y} which has no
-    //type on its own
+    // element access and slicing, for any rank
+    // each argument is either an index (integral) or a slice (slice_bounds, `all`),
+    // the result is a reference if all arguments are indices, otherwise an
+    // array_view whose rank is the number of slices:
+    //
+    //     A(i, j, k)                     // T&
+    //     A(i, all, slice_bounds{2, end}) // array_view<T, 2>
+    //
+    // A braced slice like {2, end} has no type on its own so it can't be
+    // deduced by the variadic template. For rank 1 and 2 the overloads below
+    // take slice_bounds parameters explicitly, so there {2, end} works; for
+    // higher ranks write slice_bounds{2, end}.
+    template <typename... Args,
+        typename = std::enable_if_t<(Rank > 2) && sizeof...(Args) == Rank
+            && details::are_subscripts<Args...>::value> >
+    constexpr details::subscript_result_t<T, Args...> operator()(Args... args) const noexcept
+    {
+        return subscript(std::make_index_sequence<Rank>(), args...);
+    }
     constexpr reference operator()(size_t x) const noexcept
     {
         static_assert(Rank == 1, "operator() must be called with Rank number of arguments");
-        return data_ptr[x * srd[0]];
+        return subscript(std::make_index_sequence<1>(), x);
     }
     constexpr array_view<T, 1> operator()(slice_bounds x) const noexcept
     {
         static_assert(Rank == 1, "operator() must be called with Rank number of arguments");
-        return array_view<T, 1>(data_ptr, x.length(bnd[0]), srd);
+        return subscript(std::make_index_sequence<1>(), x);
     }
     constexpr reference operator()(size_t x, size_t y) const noexcept
     {
         static_assert(Rank == 2, "operator() must be called with Rank number of arguments");
-        return data_ptr[x * srd[0] + y * srd[1]];
+        return subscript(std::make_index_sequence<2>(), x, y);
     }
     constexpr array_view<T, 1> operator()(slice_bounds x, size_t y) const noexcept
     {
         static_assert(Rank == 2, "operator() must be called with Rank number of arguments");
-        return array_view<T, 1>(data_ptr + x.from.index(bnd[0]) * srd[0] + y * srd[1], x.length(bnd[0]), srd[0]);
+        return subscript(std::make_index_sequence<2>(), x, y);
     }
     constexpr array_view<T, 1> operator()(size_t x, slice_bounds y) const noexcept
     {
         static_assert(Rank == 2, "operator() must be called with Rank number of arguments");
-        return array_view<T, 1>(data_ptr + x * srd[0] + y.from.index(bnd[1]) * srd[1], y.length(bnd[1]), srd[1]);
+        return subscript(std::make_index_sequence<2>(), x, y);
     }
     constexpr array_view<T, 2> operator()(slice_bounds x, slice_bounds y) const noexcept
     {
         static_assert(Rank == 2, "operator() must be called with Rank number of arguments");
-        return array_view<T, 2>(data_ptr + x.from.index(bnd[0]) * srd[0] + y.from.index(bnd[1]) * srd[1], { x.length(bnd[0]), y.length(bnd[1]) }, srd);
+        return subscript(std::make_index_sequence<2>(), x, y);
     }
 
     struct iterator;
@@ -619,19 +775,77 @@ public:
     }
 
 private:
+    // applies the subscripts dimension by dimension: indices move the pointer,
+    // slices move the pointer and add a dimension to the result
+    template <rank_type N>
+    struct subscript_state {
+        pointer p;
+        details::extents_template<N> e;
+        details::strides_template<N> s;
+        rank_type j;
+    };
+    template <rank_type N, typename I,
+        typename = std::enable_if_t<std::is_integral<I>::value> >
+    constexpr void apply_subscript(subscript_state<N>& st, rank_type dim, I i) const noexcept
+    {
+        assert(0 <= i && (size_t)i < bnd[dim]);
+        st.p += (std::ptrdiff_t)i * srd[dim];
+    }
+    template <rank_type N>
+    constexpr void apply_subscript(subscript_state<N>& st, rank_type dim, const slice_bounds& b) const noexcept
+    {
+        const size_t from = b.from.index(bnd[dim]);
+        const size_t len = b.length(bnd[dim]);
+        assert(from + len <= bnd[dim]);
+        const size_t n = b.count(bnd[dim]);
+        // a negative step starts at the last element of [from, from + len)
+        const size_t first = b.step > 0 || n == 0 ? from : from + len - 1;
+        st.p += (std::ptrdiff_t)first * srd[dim];
+        st.e[st.j] = n;
+        st.s[st.j] = srd[dim] * b.step;
+        ++st.j;
+    }
+    template <rank_type N>
+    constexpr void apply_subscript(subscript_state<N>& st, rank_type dim, all_fn) const noexcept
+    {
+        apply_subscript(st, dim, slice_bounds(all));
+    }
+    template <rank_type N>
+    static constexpr reference make_subscript_result(const subscript_state<N>& st, std::true_type) noexcept
+    {
+        return *st.p;
+    }
+    template <rank_type N>
+    static constexpr array_view<T, N> make_subscript_result(const subscript_state<N>& st, std::false_type) noexcept
+    {
+        return array_view<T, N>(st.p, st.e, st.s);
+    }
+    template <size_t... Dim, typename... Args>
+    constexpr details::subscript_result_t<T, Args...> subscript(std::index_sequence<Dim...>, Args... args) const noexcept
+    {
+        constexpr rank_type N = details::count_slices<Args...>::value;
+        subscript_state<N> st{ data_ptr, {}, {}, 0 };
+        (void)std::initializer_list<int>{ (apply_subscript(st, Dim, args), 0)... };
+        return make_subscript_result(st, std::integral_constant<bool, N == 0>());
+    }
+
     // helper functions
     template <typename U,
         typename = std::enable_if_t<!std::is_const<T>::value
             && std::is_convertible<U, T>::value> >
     void copy_from_same_shape_array_view(const array_view<U, Rank>& x) const
     {
-        //todo this could be optimized for special cases
-        //(for example, two min(strides)=1 array_views, with same strides
         assert(bnd == x.extents());
-        auto it_end = this->end();
-        for (auto it = this->begin(); it != it_end; ++it) {
-            *it = x[it.indices()];
-        }
+        for (rank_type d = 0; d < Rank; ++d)
+            assert(srd[d] != 0 || bnd[d] <= 1); // can't write through a broadcast view
+        SX_INSTRUMENT_SCOPE("copy", size(), size() * (sizeof(T) + sizeof(U)));
+        // loop nest with the smallest destination |stride| innermost,
+        // the pointers are bumped by the (possibly negative) strides
+        const auto order = details::loop_order<Rank>(srd);
+        SX_INSTRUMENT_PATH(std::abs(srd[order[Rank - 1]]) == 1 && std::abs(x.strides(order[Rank - 1])) == 1
+                ? instrument::path::contiguous
+                : instrument::path::strided);
+        details::for_each_run<Rank>(bnd, order, details::copy_run(), *this, x);
     }
     // helper functions
     template <typename Rng>
@@ -639,6 +853,8 @@ private:
     {
         static_assert(Rank == 1, "");
         assert(extents(0) == ranges::end(x) - ranges::begin(x));
+        SX_INSTRUMENT_SCOPE("copy", extents(0), extents(0) * 2 * sizeof(T));
+        SX_INSTRUMENT_PATH(instrument::path::fallback);
         auto it = ranges::begin(x);
         //        auto e = ranges::end(x);
         for (size_t i = 0; i < extents(0); ++i, ++it)
@@ -648,15 +864,20 @@ private:
     {
         it.that = this;
         std::iota(it.dim_permut.begin(), it.dim_permut.end(), 0);
+        // memory order: by increasing |stride|
         auto strides = srd;
+        for (auto& x : strides)
+            x = std::abs(x);
         std::sort(
             make_random_access_iterator_pair(strides.begin(), it.dim_permut.begin()),
-            make_random_access_iterator_pair(strides.end(), it.dim_permut.end()));
+            make_random_access_iterator_pair(strides.end(), it.dim_permut.end()),
+            less_by_first());
         size_t s = 1;
         for (int i = 0; i < Rank; ++i) {
             auto dpi = it.dim_permut[i];
             s *= extents(dpi);
             it.cumprod_extents[dpi] = s;
+            it.ext_div[i] = fast_divisor(std::max<size_t>(extents(dpi), 1));
         }
     }
 
@@ -675,9 +896,11 @@ public:
         std::array<int, Rank> dim_permut; //strides[dim_permut[i]] is sorted
         std::array<size_t, Rank> cumprod_extents; //cumprod in the order of dim_permut
         // cumprod_extents[dim_permut[i]] = strides[dim_permut[0]] * .. * strides[dim_permut[i]]
+        std::array<fast_divisor, Rank> ext_div; // ext_div[i] divides by extents(dim_permut[i])
 
         using iterator_base = std::iterator<std::random_access_iterator_tag,
-            value_type, std::ptrdiff_t, pointer, reference>;
+            typename array_view::value_type, std::ptrdiff_t,
+            typename array_view::pointer, typename array_view::reference>;
 
     public:
         using this_type = iterator;
@@ -703,9 +926,9 @@ public:
         reference operator[](difference_type n) const
         {
             auto new_lin_idx = (difference_type)to_linear_idx() + n;
-            assert(0 <= new_lin_idx && new_lin_idx <= cumprod_extents[dim_permut[Rank - 1]]);
+            assert(0 <= new_lin_idx && (size_t)new_lin_idx < cumprod_extents[dim_permut[Rank - 1]]);
             indices_type new_idx;
-            from_linear_idx(n, new_idx);
+            from_linear_idx(new_lin_idx, new_idx);
             return that->operator[](new_idx);
         }
         constexpr const indices_type& indices() const noexcept { return idx; }
@@ -752,15 +975,7 @@ public:
             swap(idx, y.idx);
             swap(dim_permut, y.dim_permut);
             swap(cumprod_extents, y.cumprod_extents);
-        }
-        //like x % y but the handling of negative x is such that
-        //the cyclic pattern of the remainder continues
-        static inline size_t cyclic_remainder(difference_type x, size_t y)
-        {
-            assert(y > 0);
-            if (x >= 0)
-                return x % y;
-            return (y - (-x % y)) % y;
+            swap(ext_div, y.ext_div);
         }
         size_t to_linear_idx() const
         {
@@ -773,22 +988,28 @@ public:
             }
             return r;
         }
+        // the last dimension takes the quotient so n == size() gives end()
         void from_linear_idx(size_t n, indices_type& result) const
         {
-            assert(0 <= n && n <= cumprod_extents[dim_permut[Rank - 1]]);
-            size_t cextj_prev = 1;
-            for (rank_type i = 0; n != 0 && i < Rank; ++i) {
-                auto j = dim_permut[i];
-                const size_t cextj = cumprod_extents[j];
-                result[j] = cyclic_remainder(n, cextj) / cextj_prev;
-                n -= result[j] * cextj_prev;
-                cextj_prev = cextj;
+            assert(n <= cumprod_extents[dim_permut[Rank - 1]]);
+            std::uint64_t q = n, r;
+            for (rank_type i = 0; i + 1 < Rank; ++i) {
+                q = ext_div[i].divmod(q, r);
+                result[dim_permut[i]] = (size_t)r;
             }
+            result[dim_permut[Rank - 1]] = (size_t)q;
         }
         this_type& operator+=(difference_type n)
         {
+            // short jumps within the innermost dimension
+            const int j = dim_permut[0];
+            const difference_type inner = (difference_type)idx[j] + n;
+            if (0 <= inner && (size_t)inner < that->extents(j)) {
+                idx[j] = (size_t)inner;
+                return *this;
+            }
             auto new_lin_idx = (difference_type)to_linear_idx() + n;
-            assert(0 <= new_lin_idx && new_lin_idx <= cumprod_extents[dim_permut[Rank - 1]]);
+            assert(0 <= new_lin_idx && (size_t)new_lin_idx <= cumprod_extents[dim_permut[Rank - 1]]);
             from_linear_idx(new_lin_idx, idx);
             return *this;
         }
@@ -870,7 +1091,7 @@ constexpr bool is_same_view(const array_view<T, Rank>& x,
 
 template <rank_type Rank = 1, typename T>
 constexpr array_view<T, Rank> make_array_view(T* data, details::extents_template<Rank> e,
-    details::indices_template<Rank> s) noexcept
+    details::strides_template<Rank> s) noexcept
 {
     return { data, e, s };
 }
@@ -887,6 +1108,51 @@ constexpr array_view<const T> make_array_view(const std::vector<T>& v) noexcept
     return { v.data(), v.size(), 1 };
 }
 
+// broadcasting, like numpy.broadcast_to: the dimensions of `x` are aligned
+// with the trailing dimensions of `e`, each must be either equal to the new
+// extent or 1. The new and the size-1 dimensions get stride 0, so the result
+// refers to the same elements repeatedly (it's read-only in effect).
+//
+//     // X(i, j) - mean(j) for a matrix X and a vector mean
+//     sx::transform(X, X, sx::broadcast_to(mean, X.extents()), std::minus<>());
+template <typename T, rank_type Rank, rank_type N>
+array_view<T, N> broadcast_to(const array_view<T, Rank>& x, const std::array<size_t, N>& e) noexcept
+{
+    static_assert(Rank <= N, "broadcast_to can't decrease the rank");
+    details::strides_template<N> s;
+    for (rank_type i = 0; i < N; ++i) {
+        if (i < N - Rank)
+            s[i] = 0;
+        else {
+            const rank_type k = i - (N - Rank);
+            assert(x.extents(k) == e[i] || x.extents(k) == 1);
+            s[i] = x.extents(k) == e[i] ? x.strides(k) : 0;
+        }
+    }
+    return { x.data(), e, s };
+}
+
+// inserts a dimension of extent 1 at `axis`, like numpy.expand_dims
+template <typename T, rank_type Rank>
+array_view<T, Rank + 1> expand_dims(const array_view<T, Rank>& x, rank_type axis) noexcept
+{
+    assert(axis <= Rank);
+    details::extents_template<Rank + 1> e;
+    details::strides_template<Rank + 1> s;
+    for (rank_type i = 0, k = 0; i <= Rank; ++i) {
+        if (i == axis) {
+            e[i] = 1;
+            s[i] = 0;
+        }
+        else {
+            e[i] = x.extents(k);
+            s[i] = x.strides(k);
+            ++k;
+        }
+    }
+    return { x.data(), e, s };
+}
+
 template <typename T>
 using matrix_view = array_view<T, 2>;
 
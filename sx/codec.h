@@ -0,0 +1,390 @@
+#ifndef CODEC_INCLUDED_3340192837
+#define CODEC_INCLUDED_3340192837
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <vector>
+#include <type_traits>
+
+// Small, fast, dependency-free compression codecs for blocks of numbers
+//
+// - integers: frame-of-reference or delta (zigzag) + bitpacking
+//   pack_ints/unpack_ints choose whichever is smaller for the block
+// - any other trivially copyable type (floats): byte-shuffle + LZ77
+//   (lz_compress/lz_decompress use a simplified LZ4-like sequence format)
+//
+// All encoders append to a std::vector<uint8_t>, decoders read from a raw
+// pointer and return the pointer past the consumed bytes.
+
+namespace sx {
+namespace codec {
+
+    namespace details {
+        template <typename T>
+        inline void put(std::vector<std::uint8_t>& out, T x)
+        {
+            auto n = out.size();
+            out.resize(n + sizeof(T));
+            std::memcpy(out.data() + n, &x, sizeof(T));
+        }
+
+        template <typename T>
+        inline T get(const std::uint8_t*& p)
+        {
+            T x;
+            std::memcpy(&x, p, sizeof(T));
+            p += sizeof(T);
+            return x;
+        }
+
+        inline std::uint64_t zigzag(std::uint64_t x)
+        {
+            return (x << 1) ^ (std::uint64_t)((std::int64_t)x >> 63);
+        }
+
+        inline std::uint64_t unzigzag(std::uint64_t x)
+        {
+            return (x >> 1) ^ (std::uint64_t)(-(std::int64_t)(x & 1));
+        }
+
+        inline unsigned bit_width(std::uint64_t x)
+        {
+            unsigned w = 0;
+            for (; x; x >>= 1)
+                ++w;
+            return w;
+        }
+
+        // values wider than this are stored as 64-bit words
+        static const unsigned kMaxPackedWidth = 56;
+
+        // appends n values of w bits each
+        template <typename F>
+        void pack_bits(std::vector<std::uint8_t>& out, size_t n, unsigned w, F&& value)
+        {
+            if (w == 0)
+                return;
+            if (w > kMaxPackedWidth) {
+                for (size_t i = 0; i < n; ++i)
+                    put<std::uint64_t>(out, value(i));
+                return;
+            }
+            out.reserve(out.size() + (n * w + 7) / 8);
+            std::uint64_t acc = 0;
+            unsigned bits = 0;
+            for (size_t i = 0; i < n; ++i) {
+                acc |= value(i) << bits;
+                bits += w;
+                while (bits >= 8) {
+                    out.push_back((std::uint8_t)acc);
+                    acc >>= 8;
+                    bits -= 8;
+                }
+            }
+            if (bits > 0)
+                out.push_back((std::uint8_t)acc);
+        }
+
+        // reads n values of w bits each, calls f(i, value)
+        template <typename F>
+        const std::uint8_t* unpack_bits(const std::uint8_t* p, size_t n, unsigned w, F&& f)
+        {
+            if (w == 0) {
+                for (size_t i = 0; i < n; ++i)
+                    f(i, 0);
+                return p;
+            }
+            if (w > kMaxPackedWidth) {
+                for (size_t i = 0; i < n; ++i)
+                    f(i, get<std::uint64_t>(p));
+                return p;
+            }
+            const std::uint64_t mask = (std::uint64_t(1) << w) - 1;
+            std::uint64_t acc = 0;
+            unsigned bits = 0;
+            for (size_t i = 0; i < n; ++i) {
+                while (bits < w) {
+                    acc |= (std::uint64_t)*p++ << bits;
+                    bits += 8;
+                }
+                f(i, acc & mask);
+                acc >>= w;
+                bits -= w;
+            }
+            return p;
+        }
+
+        template <typename I>
+        std::uint64_t to_u64(I x)
+        {
+            return (std::uint64_t)(typename std::conditional<std::is_signed<I>::value,
+                std::int64_t, std::uint64_t>::type)x;
+        }
+    }
+
+    enum int_mode : std::uint8_t {
+        int_for = 0, // frame of reference: min + bitpacked (x - min)
+        int_delta = 1 // first + bitpacked zigzag(x[i] - x[i-1])
+    };
+
+    // appends the encoded x[0], ..., x[n-1]
+    template <typename I, typename = std::enable_if_t<std::is_integral<I>::value> >
+    void pack_ints(const I* x, size_t n, std::vector<std::uint8_t>& out)
+    {
+        using namespace details;
+        if (n == 0)
+            return;
+        std::uint64_t mn = to_u64(x[0]), mx_for = 0, mx_delta = 0;
+        for (size_t i = 1; i < n; ++i) {
+            if (std::is_signed<I>::value ? (std::int64_t)to_u64(x[i]) < (std::int64_t)mn
+                                         : to_u64(x[i]) < mn)
+                mn = to_u64(x[i]);
+            mx_delta |= zigzag(to_u64(x[i]) - to_u64(x[i - 1]));
+        }
+        for (size_t i = 0; i < n; ++i)
+            mx_for |= to_u64(x[i]) - mn;
+        const unsigned w_for = bit_width(mx_for), w_delta = bit_width(mx_delta);
+        if (w_delta < w_for) {
+            out.push_back(int_delta);
+            out.push_back((std::uint8_t)w_delta);
+            put<std::uint64_t>(out, to_u64(x[0]));
+            pack_bits(out, n - 1, w_delta,
+                [x](size_t i) { return zigzag(to_u64(x[i + 1]) - to_u64(x[i])); });
+        }
+        else {
+            out.push_back(int_for);
+            out.push_back((std::uint8_t)w_for);
+            put<std::uint64_t>(out, mn);
+            pack_bits(out, n, w_for, [x, mn](size_t i) { return to_u64(x[i]) - mn; });
+        }
+    }
+
+    // decodes n values written by pack_ints
+    template <typename I, typename = std::enable_if_t<std::is_integral<I>::value> >
+    const std::uint8_t* unpack_ints(const std::uint8_t* p, size_t n, I* x)
+    {
+        using namespace details;
+        if (n == 0)
+            return p;
+        const auto mode = *p++;
+        const unsigned w = *p++;
+        const auto base = get<std::uint64_t>(p);
+        if (mode == int_delta) {
+            auto prev = base;
+            x[0] = (I)prev;
+            return unpack_bits(p, n - 1, w, [x, &prev](size_t i, std::uint64_t v) {
+                prev += unzigzag(v);
+                x[i + 1] = (I)prev;
+            });
+        }
+        assert(mode == int_for);
+        return unpack_bits(p, n, w, [x, base](size_t i, std::uint64_t v) {
+            x[i] = (I)(base + v);
+        });
+    }
+
+    // transposes the bytes of n elements of `size` bytes: all first bytes,
+    // then all second bytes, etc. Makes the exponent and high mantissa bytes
+    // of floats compressible.
+    inline void byte_shuffle(const std::uint8_t* in, size_t n, size_t size, std::uint8_t* out)
+    {
+        for (size_t b = 0; b < size; ++b)
+            for (size_t i = 0; i < n; ++i)
+                out[b * n + i] = in[i * size + b];
+    }
+
+    inline void byte_unshuffle(const std::uint8_t* in, size_t n, size_t size, std::uint8_t* out)
+    {
+        for (size_t b = 0; b < size; ++b)
+            for (size_t i = 0; i < n; ++i)
+                out[i * size + b] = in[b * n + i];
+    }
+
+    namespace details {
+        static const size_t kMinMatch = 4;
+        static const size_t kHashBits = 12;
+        static const size_t kMaxOffset = 65535;
+        // the last bytes are always literals so the matcher can read 4 bytes
+        static const size_t kLastLiterals = 5;
+
+        inline std::uint32_t read32(const std::uint8_t* p)
+        {
+            std::uint32_t x;
+            std::memcpy(&x, p, 4);
+            return x;
+        }
+
+        inline void put_length(std::vector<std::uint8_t>& out, size_t len)
+        {
+            for (; len >= 255; len -= 255)
+                out.push_back(255);
+            out.push_back((std::uint8_t)len);
+        }
+
+        inline size_t get_length(const std::uint8_t*& p, size_t nibble)
+        {
+            size_t len = nibble;
+            if (nibble == 15) {
+                std::uint8_t b;
+                do {
+                    b = *p++;
+                    len += b;
+                } while (b == 255);
+            }
+            return len;
+        }
+
+        inline void put_sequence(std::vector<std::uint8_t>& out, const std::uint8_t* lit,
+            size_t n_lit, size_t offset, size_t match_len)
+        {
+            const size_t ml = match_len ? match_len - kMinMatch : 0;
+            out.push_back((std::uint8_t)((std::min<size_t>(n_lit, 15) << 4) | std::min<size_t>(ml, 15)));
+            if (n_lit >= 15)
+                put_length(out, n_lit - 15);
+            out.insert(out.end(), lit, lit + n_lit);
+            if (match_len) {
+                put<std::uint16_t>(out, (std::uint16_t)offset);
+                if (ml >= 15)
+                    put_length(out, ml - 15);
+            }
+        }
+    }
+
+    // LZ77 compression with a single-entry hash table (greedy parsing)
+    // output: sequences of [token][literal length ext][literals][offset16][match length ext]
+    // the last sequence has literals only
+    inline void lz_compress(const std::uint8_t* in, size_t n, std::vector<std::uint8_t>& out)
+    {
+        using namespace details;
+        std::vector<std::uint32_t> table(size_t(1) << kHashBits, 0);
+        size_t anchor = 0;
+        size_t i = 0; // table stores position + 1, 0 means empty
+        while (n >= kLastLiterals + kMinMatch && i + kMinMatch + kLastLiterals <= n) {
+            const auto v = read32(in + i);
+            const auto h = (v * 2654435761u) >> (32 - kHashBits);
+            const size_t cand = table[h];
+            table[h] = (std::uint32_t)(i + 1);
+            if (cand && i + 1 - cand <= kMaxOffset && read32(in + cand - 1) == v) {
+                const size_t c = cand - 1;
+                size_t len = kMinMatch;
+                while (i + len + kLastLiterals < n && in[c + len] == in[i + len])
+                    ++len;
+                put_sequence(out, in + anchor, i - anchor, i - c, len);
+                i += len;
+                anchor = i;
+            }
+            else
+                ++i;
+        }
+        put_sequence(out, in + anchor, n - anchor, 0, 0);
+    }
+
+    // decompresses exactly n bytes, returns the pointer past the consumed input
+    inline const std::uint8_t* lz_decompress(const std::uint8_t* p, std::uint8_t* out, size_t n)
+    {
+        using namespace details;
+        std::uint8_t* o = out;
+        std::uint8_t* const oe = out + n;
+        for (;;) {
+            const auto token = *p++;
+            const size_t n_lit = get_length(p, token >> 4);
+            std::memcpy(o, p, n_lit);
+            o += n_lit;
+            p += n_lit;
+            if (o == oe)
+                return p;
+            assert(o < oe);
+            const size_t offset = get<std::uint16_t>(p);
+            const size_t len = get_length(p, token & 15) + kMinMatch;
+            const std::uint8_t* m = o - offset;
+            for (size_t k = 0; k < len; ++k)
+                o[k] = m[k]; // may overlap
+            o += len;
+        }
+    }
+
+    enum block_mode : std::uint8_t {
+        block_raw = 0,
+        block_ints = 1,
+        block_shuffle_lz = 2
+    };
+
+    namespace details {
+        template <typename T>
+        using is_packable_int = std::integral_constant<bool,
+            std::is_integral<T>::value && !std::is_same<T, bool>::value>;
+
+        template <typename T>
+        void encode_block_payload(const T* x, size_t n, std::vector<std::uint8_t>& out, std::true_type)
+        {
+            out.push_back(block_ints);
+            pack_ints(x, n, out);
+        }
+
+        template <typename T>
+        void encode_block_payload(const T* x, size_t n, std::vector<std::uint8_t>& out, std::false_type)
+        {
+            out.push_back(block_shuffle_lz);
+            std::vector<std::uint8_t> shuffled(n * sizeof(T));
+            byte_shuffle(reinterpret_cast<const std::uint8_t*>(x), n, sizeof(T), shuffled.data());
+            lz_compress(shuffled.data(), shuffled.size(), out);
+        }
+
+        template <typename T>
+        const std::uint8_t* decode_ints_payload(const std::uint8_t* p, size_t n, T* x, std::true_type)
+        {
+            return unpack_ints(p, n, x);
+        }
+
+        template <typename T>
+        const std::uint8_t* decode_ints_payload(const std::uint8_t* p, size_t, T*, std::false_type)
+        {
+            assert(false);
+            return p;
+        }
+    }
+
+    // appends the encoded block, picks the codec by the type and
+    // falls back to raw storage if compression doesn't help
+    template <typename T>
+    void encode_block(const T* x, size_t n, std::vector<std::uint8_t>& out)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+        const size_t start = out.size();
+        const size_t raw_size = n * sizeof(T);
+        details::encode_block_payload(x, n, out, details::is_packable_int<T>{});
+        if (out.size() - start > raw_size + 1) {
+            out.resize(start);
+            out.push_back(block_raw);
+            auto p = reinterpret_cast<const std::uint8_t*>(x);
+            out.insert(out.end(), p, p + raw_size);
+        }
+    }
+
+    // decodes a block written by encode_block
+    template <typename T>
+    const std::uint8_t* decode_block(const std::uint8_t* p, size_t n, T* x)
+    {
+        const auto mode = *p++;
+        const size_t raw_size = n * sizeof(T);
+        switch (mode) {
+        case block_raw:
+            std::memcpy(x, p, raw_size);
+            return p + raw_size;
+        case block_ints:
+            return details::decode_ints_payload(p, n, x, details::is_packable_int<T>{});
+        default: {
+            assert(mode == block_shuffle_lz);
+            std::vector<std::uint8_t> shuffled(raw_size);
+            p = lz_decompress(p, shuffled.data(), raw_size);
+            byte_unshuffle(shuffled.data(), n, sizeof(T), reinterpret_cast<std::uint8_t*>(x));
+            return p;
+        }
+        }
+    }
+}
+}
+
+#endif
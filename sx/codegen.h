@@ -0,0 +1,251 @@
+#ifndef CODEGEN_INCLUDED_6620381945
+#define CODEGEN_INCLUDED_6620381945
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <limits>
+#include <locale>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include "sx/forest.h"
+
+// Forests compiled into code
+//
+//     std::ofstream os("model.h");
+//     sx::write_compiled_forest(os, f, "model"); // f: sx::forest<T, V>
+//
+//     # CMakeLists.txt, with sx's cmake/sx_compiled_forest.cmake included
+//     sx_add_compiled_forest(model ${CMAKE_CURRENT_BINARY_DIR}/model.h)
+//
+//     sx::compiled_forest m("path/to/model.so"); // dlopen
+//     auto P = m.predict(X);                     // X: array_view<const float, 2>
+//
+// write_compiled_forest emits a self-contained header (no sx includes) with
+// one function per tree. A tree is a nest of if (x[feature] > threshold)
+// branches with the thresholds and leaf values as literals, so the compiler
+// sees the whole model as constants and no node arrays are loaded. The split
+// and averaging rules are the ones of sx::predict, for double leaf values and
+// float samples the results are identical.
+//
+// Used directly the header gives model::predict_row and model::predict.
+// Compiled with SX_COMPILED_FOREST_EXPORT defined (what sx_add_compiled_forest
+// does) it also exports the C entry point `sx_compiled_forest`, the ABI
+// compiled_forest loads: float samples with element strides, double outputs.
+//
+// Code size grows with the number of nodes, meant for frozen models of
+// moderate size where single sample latency matters.
+
+namespace sx {
+
+namespace details {
+    // a literal of type T which reads back as x
+    template <typename T>
+    void write_literal(std::ostream& os, T x)
+    {
+        const char* type = std::is_same<T, float>::value ? "float" : "double";
+        if (std::isnan(x))
+            os << "std::numeric_limits<" << type << ">::quiet_NaN()";
+        else if (std::isinf(x))
+            os << (x < 0 ? "-" : "") << "std::numeric_limits<" << type << ">::infinity()";
+        else {
+            std::ostringstream s;
+            s.imbue(std::locale::classic());
+            s << std::setprecision(std::numeric_limits<T>::max_digits10) << std::showpoint << x;
+            os << s.str() << (std::is_same<T, float>::value ? "f" : "");
+        }
+    }
+
+    template <typename T>
+    void write_literal_of(std::ostream& os, T x)
+    {
+        using F = typename std::conditional<std::is_same<T, float>::value, float, double>::type;
+        write_literal(os, (F)x);
+    }
+
+    template <typename T, typename V>
+    void write_tree_node(std::ostream& os, const tree<T, V>& t, std::int32_t i, int indent)
+    {
+        const std::string pad((size_t)indent * 4, ' ');
+        if (t.is_leaf(i)) {
+            auto v = t.value(i);
+            for (size_t o = 0; o < t.n_outputs(); ++o) {
+                os << pad << "out[" << o << "] += ";
+                write_literal_of(os, v(o));
+                os << ";\n";
+            }
+            return;
+        }
+        os << pad << "if (x[" << t.feature(i) << " * cs] > ";
+        write_literal_of(os, t.threshold(i));
+        os << ") {\n";
+        write_tree_node(os, t, t.right(i), indent + 1);
+        os << pad << "}\n" << pad << "else {\n";
+        write_tree_node(os, t, t.left(i), indent + 1);
+        os << pad << "}\n";
+    }
+}
+
+// writes the C++ header of the forest f in namespace `name`, see the comment
+// at the top
+template <typename T, typename V>
+void write_compiled_forest(std::ostream& os, const forest<T, V>& f, const std::string& name)
+{
+    assert(!f.empty());
+    std::int32_t n_features = 0;
+    for (auto& t : f)
+        for (std::int32_t i = 0; i < (std::int32_t)t.size(); ++i)
+            if (!t.is_leaf(i))
+                n_features = std::max(n_features, t.feature(i) + 1);
+
+    const std::string guard = "SX_COMPILED_FOREST_" + name + "_INCLUDED";
+    os << "// generated by sx::write_compiled_forest, don't edit\n"
+       << "#ifndef " << guard << "\n#define " << guard << "\n\n"
+       << "#include <cstddef>\n#include <limits>\n\n"
+       << "namespace " << name << " {\n\n"
+       << "constexpr std::size_t n_features = " << n_features << ";\n"
+       << "constexpr std::size_t n_outputs = " << f.n_outputs() << ";\n"
+       << "constexpr std::size_t n_trees = " << f.size() << ";\n\n";
+    for (size_t k = 0; k < f.size(); ++k) {
+        // a single leaf doesn't read the sample
+        const bool leaf = f[k].is_leaf(0);
+        os << "inline void tree_" << k << (leaf ? "(const float*, std::ptrdiff_t, double* out)\n{\n"
+                                                : "(const float* x, std::ptrdiff_t cs, double* out)\n{\n");
+        details::write_tree_node(os, f[k], 0, 1);
+        os << "}\n\n";
+    }
+    os << "// out[0, n_outputs): mean of the leaf values for the sample x[0], x[cs], ..\n"
+       << "inline void predict_row(const float* x, std::ptrdiff_t cs, double* out)\n{\n"
+       << "    for (std::size_t o = 0; o < n_outputs; ++o)\n"
+       << "        out[o] = 0;\n";
+    for (size_t k = 0; k < f.size(); ++k)
+        os << "    tree_" << k << "(x, cs, out);\n";
+    os << "    const double scale = 1.0 / (double)n_trees;\n"
+       << "    for (std::size_t o = 0; o < n_outputs; ++o)\n"
+       << "        out[o] *= scale;\n"
+       << "}\n\n"
+       << "// the rows x[r * rs + feature * cs] into out, rows x n_outputs, c_order\n"
+       << "inline void predict(const float* x, std::size_t rows, std::ptrdiff_t rs, std::ptrdiff_t cs, double* out)\n{\n"
+       << "    for (std::size_t r = 0; r < rows; ++r)\n"
+       << "        predict_row(x + (std::ptrdiff_t)r * rs, cs, out + r * n_outputs);\n"
+       << "}\n"
+       << "}\n\n"
+       << "#ifdef SX_COMPILED_FOREST_EXPORT\n"
+       << "extern \"C\" {\n"
+       << "struct sx_compiled_forest_v1 {\n"
+       << "    unsigned abi;\n"
+       << "    std::size_t n_features, n_outputs, n_trees;\n"
+       << "    void (*predict)(const float*, std::size_t, std::ptrdiff_t, std::ptrdiff_t, double*);\n"
+       << "};\n"
+       << "#ifdef _WIN32\n__declspec(dllexport)\n#else\n__attribute__((visibility(\"default\")))\n#endif\n"
+       << "const sx_compiled_forest_v1* sx_compiled_forest()\n{\n"
+       << "    static const sx_compiled_forest_v1 m = { 1, " << name << "::n_features, " << name
+       << "::n_outputs, " << name << "::n_trees, &" << name << "::predict };\n"
+       << "    return &m;\n"
+       << "}\n"
+       << "}\n"
+       << "#endif\n\n"
+       << "#endif\n";
+}
+
+// a forest built by sx_add_compiled_forest, loaded at run time
+// Throws std::runtime_error if the module can't be loaded or isn't a compiled forest.
+class compiled_forest {
+public:
+    compiled_forest() = default;
+    explicit compiled_forest(const std::string& filename)
+    {
+#ifdef _WIN32
+        handle = (void*)::LoadLibraryA(filename.c_str());
+        if (!handle)
+            throw std::runtime_error("can't load '" + filename + "'");
+        auto entry = (const abi_v1* (*)())::GetProcAddress((HMODULE)handle, "sx_compiled_forest");
+#else
+        handle = ::dlopen(filename.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle)
+            throw std::runtime_error("can't load '" + filename + "': " + ::dlerror());
+        auto entry = (const abi_v1* (*)())::dlsym(handle, "sx_compiled_forest");
+#endif
+        if (!entry || !(m = entry()) || m->abi != 1) {
+            close();
+            throw std::runtime_error("'" + filename + "' is not a compiled forest");
+        }
+    }
+    compiled_forest(const compiled_forest&) = delete;
+    compiled_forest& operator=(const compiled_forest&) = delete;
+    compiled_forest(compiled_forest&& x) noexcept
+        : handle(x.handle)
+        , m(x.m)
+    {
+        x.handle = nullptr;
+        x.m = nullptr;
+    }
+    compiled_forest& operator=(compiled_forest&& x) noexcept
+    {
+        std::swap(handle, x.handle);
+        std::swap(m, x.m);
+        return *this;
+    }
+    ~compiled_forest() { close(); }
+
+    bool is_open() const { return m != nullptr; }
+    size_t n_features() const { return m->n_features; }
+    size_t n_outputs() const { return m->n_outputs; }
+    size_t n_trees() const { return m->n_trees; }
+
+    // out(r, ..) = mean of the leaf values for row r of X (samples x features)
+    // out: X.extents(0) x n_outputs(), c_order
+    void predict(const array_view<const float, 2>& X, double* out) const
+    {
+        assert(X.extents(1) >= n_features());
+        m->predict(X.data(), X.extents(0), X.strides(0), X.strides(1), out);
+    }
+    matrix<double> predict(const array_view<const float, 2>& X) const
+    {
+        matrix<double> P(matrix<double>::extents_type(X.extents(0), n_outputs()), array_layout::c_order);
+        predict(X, P.data());
+        return P;
+    }
+
+private:
+    // must match sx_compiled_forest_v1 in the generated code
+    struct abi_v1 {
+        unsigned abi;
+        std::size_t n_features, n_outputs, n_trees;
+        void (*predict)(const float*, std::size_t, std::ptrdiff_t, std::ptrdiff_t, double*);
+    };
+
+    void close()
+    {
+        if (handle)
+#ifdef _WIN32
+            ::FreeLibrary((HMODULE)handle);
+#else
+            ::dlclose(handle);
+#endif
+        handle = nullptr;
+        m = nullptr;
+    }
+
+    void* handle = nullptr;
+    const abi_v1* m = nullptr;
+};
+}
+
+#endif
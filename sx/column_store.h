@@ -0,0 +1,429 @@
+#ifndef COLUMN_STORE_INCLUDED_9912038471
+#define COLUMN_STORE_INCLUDED_9912038471
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "sx/array_view.h"
+#include "sx/multi_array.h"
+#include "sx/mapped_file.h"
+#include "sx/npy.h"
+#include "sx/codec.h"
+
+// Block-compressed columnar storage of a matrix
+//
+// The columns are split into blocks of `block_rows` rows, each block is
+// compressed separately (see codec.h: bitpacking for integers, byte-shuffle
+// + LZ77 for floats). Blocks are decompressed lazily, on access, into a
+// small LRU cache.
+//
+//     sx::column_store<std::uint8_t> cs(X_binned);     // compress in memory
+//     cs.save("X.sxc");
+//
+//     sx::column_store<std::uint8_t> cs("X.sxc");      // maps the file, nothing is decompressed
+//     for (auto& blk : cs.column(j))                   // scan a column block by block
+//         use(blk.first_row(), blk.view());            // array_view<const uint8_t>
+//
+// Matrices which don't fit in memory can be written by appending row blocks
+// with column_store_writer.
+//
+// File layout (all integers are little-endian uint64):
+//
+//     "SXCOLST1"
+//     compressed blocks, block-major: (block 0, col 0), (block 0, col 1), ...
+//     offset table: n_blocks * cols + 1 offsets relative to the file start
+//     footer: rows, cols, block_rows, offset table position, 8-byte npy descr, "SXCOLST1"
+
+namespace sx {
+
+struct column_store_error : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+namespace details {
+    static constexpr char column_store_magic[] = "SXCOLST1";
+    static const size_t column_store_magic_size = 8;
+    static const size_t column_store_footer_size = 4 * 8 + 8 + 8;
+
+    inline void put_u64(std::ostream& os, std::uint64_t x)
+    {
+        char b[8];
+        for (int i = 0; i < 8; ++i, x >>= 8)
+            b[i] = (char)(x & 0xff);
+        os.write(b, 8);
+    }
+
+    inline std::uint64_t get_u64(const char* p)
+    {
+        std::uint64_t x = 0;
+        for (int i = 8; i-- > 0;)
+            x = (x << 8) | (unsigned char)p[i];
+        return x;
+    }
+
+    template <typename T>
+    void write_column_store_footer(std::ostream& os, size_t rows, size_t cols,
+        size_t block_rows, size_t table_pos)
+    {
+        put_u64(os, rows);
+        put_u64(os, cols);
+        put_u64(os, block_rows);
+        put_u64(os, table_pos);
+        char d[8] = {};
+        auto descr = npy_dtype<T>::descr();
+        std::memcpy(d, descr.data(), std::min<size_t>(descr.size(), 8));
+        os.write(d, 8);
+        os.write(column_store_magic, column_store_magic_size);
+    }
+}
+
+// a decompressed block of a column
+template <typename T>
+class column_block {
+public:
+    column_block() = default;
+    column_block(std::shared_ptr<const std::vector<T> > d, size_t first_row)
+        : d(std::move(d))
+        , first(first_row)
+    {
+    }
+
+    array_view<const T> view() const { return array_view<const T>(d->data(), d->size()); }
+    size_t first_row() const { return first; }
+    size_t size() const { return d->size(); }
+    const T* begin() const { return d->data(); }
+    const T* end() const { return d->data() + d->size(); }
+
+private:
+    // keeps the data alive after being evicted from the cache
+    std::shared_ptr<const std::vector<T> > d;
+    size_t first = 0;
+};
+
+template <typename T>
+class column_store;
+
+// iterates over the blocks of a column
+template <typename T>
+class column_block_iterator
+    : public std::iterator<std::input_iterator_tag, column_block<T>, std::ptrdiff_t,
+          const column_block<T>*, const column_block<T>&> {
+public:
+    column_block_iterator() = default;
+    column_block_iterator(const column_store<T>* cs, size_t col, size_t b)
+        : cs(cs)
+        , col(col)
+        , b(b)
+    {
+    }
+
+    const column_block<T>& operator*() const
+    {
+        if (!loaded) {
+            current = cs->block(col, b);
+            loaded = true;
+        }
+        return current;
+    }
+    const column_block<T>* operator->() const { return &**this; }
+    column_block_iterator& operator++()
+    {
+        ++b;
+        loaded = false;
+        return *this;
+    }
+    column_block_iterator operator++(int)
+    {
+        auto x = *this;
+        ++*this;
+        return x;
+    }
+    bool operator==(const column_block_iterator& x) const { return b == x.b; }
+    bool operator!=(const column_block_iterator& x) const { return b != x.b; }
+
+private:
+    const column_store<T>* cs = nullptr;
+    size_t col = 0, b = 0;
+    mutable column_block<T> current;
+    mutable bool loaded = false;
+};
+
+template <typename T>
+struct column_block_range {
+    column_block_iterator<T> b, e;
+    column_block_iterator<T> begin() const { return b; }
+    column_block_iterator<T> end() const { return e; }
+};
+
+template <typename T>
+class column_store {
+public:
+    static const size_t kDefaultBlockRows = 1 << 16;
+    static const size_t kDefaultCacheBlocks = 16;
+
+    column_store() = default;
+
+    // compresses X into memory
+    explicit column_store(const array_view<const T, 2>& X, size_t block_rows = kDefaultBlockRows)
+        : n_rows(X.extents(0))
+        , n_cols(X.extents(1))
+        , n_block_rows(block_rows)
+    {
+        assert(block_rows > 0);
+        owned.assign(details::column_store_magic,
+            details::column_store_magic + details::column_store_magic_size);
+        std::vector<T> col(block_rows);
+        for (size_t b = 0; b < n_blocks(); ++b) {
+            const size_t r0 = b * block_rows;
+            const size_t n = block_size(b);
+            for (size_t j = 0; j < n_cols; ++j) {
+                offsets.push_back(owned.size());
+                for (size_t i = 0; i < n; ++i)
+                    col[i] = X(r0 + i, j);
+                codec::encode_block(col.data(), n, owned);
+            }
+        }
+        offsets.push_back(owned.size());
+        data = owned.data();
+    }
+
+    // opens a file written by save() or column_store_writer
+    // blocks are decompressed from the memory-mapped file on access
+    explicit column_store(const std::string& filename)
+    {
+        using namespace details;
+        try {
+            file.open(filename);
+        }
+        catch (const std::runtime_error& e) {
+            throw column_store_error(std::string("column_store: ") + e.what());
+        }
+        const size_t magic_size = column_store_magic_size;
+        if (file.size() < magic_size + column_store_footer_size
+            || std::memcmp(file.data(), column_store_magic, magic_size) != 0
+            || std::memcmp(file.end() - magic_size, column_store_magic, magic_size) != 0)
+            throw column_store_error("column_store: '" + filename + "' is not a column store");
+        const char* f = file.end() - column_store_footer_size;
+        n_rows = get_u64(f);
+        n_cols = get_u64(f + 8);
+        n_block_rows = get_u64(f + 16);
+        const size_t table_pos = get_u64(f + 24);
+        const std::string descr(f + 32, strnlen(f + 32, 8));
+        if (descr != npy_dtype<T>::descr())
+            throw column_store_error("column_store: type mismatch, file has '" + descr + "'");
+        const size_t n_offsets = n_blocks() * n_cols + 1;
+        if (n_block_rows == 0 || table_pos + n_offsets * 8 > file.size() - column_store_footer_size)
+            throw column_store_error("column_store: corrupt file");
+        offsets.resize(n_offsets);
+        for (size_t i = 0; i < n_offsets; ++i)
+            offsets[i] = get_u64(file.data() + table_pos + i * 8);
+        data = reinterpret_cast<const std::uint8_t*>(file.data());
+    }
+
+    column_store(column_store&&) = default;
+    column_store& operator=(column_store&&) = default;
+
+    size_t rows() const { return n_rows; }
+    size_t cols() const { return n_cols; }
+    size_t block_rows() const { return n_block_rows; }
+    size_t n_blocks() const { return (n_rows + n_block_rows - 1) / n_block_rows; }
+    // number of rows in block `b`
+    size_t block_size(size_t b) const { return std::min(n_block_rows, n_rows - b * n_block_rows); }
+    // size of all compressed blocks in bytes
+    size_t compressed_size() const { return offsets.empty() ? 0 : offsets.back() - offsets.front(); }
+
+    // maximum number of decompressed blocks kept in the cache
+    void set_cache_size(size_t n_blocks)
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        cache->capacity = n_blocks;
+        while (cache->entries.size() > n_blocks)
+            cache->entries.erase(std::min_element(cache->entries.begin(), cache->entries.end(),
+                [](const cache_entry& x, const cache_entry& y) { return x.last_use < y.last_use; }));
+    }
+
+    // block `b` of column `col`, from the cache or decompressed
+    column_block<T> block(size_t col, size_t b) const
+    {
+        assert(col < n_cols && b < n_blocks());
+        const size_t key = b * n_cols + col;
+        {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            for (auto& e : cache->entries)
+                if (e.key == key) {
+                    e.last_use = ++cache->clock;
+                    return column_block<T>(e.d, b * n_block_rows);
+                }
+        }
+        auto d = std::make_shared<std::vector<T> >(block_size(b));
+        decompress_block(col, b, d->data());
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        if (cache->capacity > 0) {
+            if (cache->entries.size() >= cache->capacity)
+                cache->entries.erase(std::min_element(cache->entries.begin(), cache->entries.end(),
+                    [](const cache_entry& x, const cache_entry& y) { return x.last_use < y.last_use; }));
+            cache->entries.push_back(cache_entry{ key, ++cache->clock, d });
+        }
+        return column_block<T>(std::move(d), b * n_block_rows);
+    }
+
+    // the blocks of a column, decompressed one by one
+    column_block_range<T> column(size_t col) const
+    {
+        return { column_block_iterator<T>(this, col, 0),
+            column_block_iterator<T>(this, col, n_blocks()) };
+    }
+
+    // decompresses block `b` of column `col` into `dst` (bypasses the cache)
+    void decompress_block(size_t col, size_t b, T* dst) const
+    {
+        codec::decode_block(data + offsets[b * n_cols + col], block_size(b), dst);
+    }
+
+    // decompresses a whole column into dst
+    void decompress_column(size_t col, const array_view<T, 1>& dst) const
+    {
+        assert(dst.extents(0) == n_rows);
+        if (dst.strides(0) == 1) {
+            for (size_t b = 0; b < n_blocks(); ++b)
+                decompress_block(col, b, &dst(b * n_block_rows));
+        }
+        else {
+            for (auto& blk : column(col)) {
+                auto it = blk.begin();
+                for (size_t i = 0; i < blk.size(); ++i, ++it)
+                    dst(blk.first_row() + i) = *it;
+            }
+        }
+    }
+
+    void save(std::ostream& os) const
+    {
+        os.write(details::column_store_magic, details::column_store_magic_size);
+        os.write(reinterpret_cast<const char*>(data + offsets.front()), compressed_size());
+        const size_t table_pos = details::column_store_magic_size + compressed_size();
+        for (auto o : offsets)
+            details::put_u64(os, o - offsets.front() + details::column_store_magic_size);
+        details::write_column_store_footer<T>(os, n_rows, n_cols, n_block_rows, table_pos);
+        if (!os)
+            throw column_store_error("column_store: write failed");
+    }
+
+    void save(const std::string& filename) const
+    {
+        std::ofstream f(filename, std::ios::binary);
+        if (!f)
+            throw column_store_error("column_store: can't open '" + filename + "' for writing");
+        save(f);
+    }
+
+private:
+    struct cache_entry {
+        size_t key;
+        size_t last_use;
+        std::shared_ptr<const std::vector<T> > d;
+    };
+    struct block_cache {
+        std::mutex mutex;
+        size_t capacity = kDefaultCacheBlocks;
+        size_t clock = 0;
+        std::vector<cache_entry> entries;
+    };
+
+    size_t n_rows = 0, n_cols = 0, n_block_rows = kDefaultBlockRows;
+    std::vector<size_t> offsets; // offsets[b * n_cols + col], relative to `data`
+    std::vector<std::uint8_t> owned;
+    mapped_file file;
+    const std::uint8_t* data = nullptr;
+    std::unique_ptr<block_cache> cache{ new block_cache };
+};
+
+// writes a column store file by appending row blocks, only one block of
+// rows is held in memory
+template <typename T>
+class column_store_writer {
+public:
+    column_store_writer(std::ostream& os, size_t cols,
+        size_t block_rows = column_store<T>::kDefaultBlockRows)
+        : os(os)
+        , n_cols(cols)
+        , n_block_rows(block_rows)
+        , buf(typename matrix<T>::extents_type(block_rows, cols), array_layout::fortran_order)
+    {
+        os.write(details::column_store_magic, details::column_store_magic_size);
+        pos = details::column_store_magic_size;
+    }
+    ~column_store_writer()
+    {
+        if (!finished) {
+            try {
+                finish();
+            }
+            catch (...) {
+            }
+        }
+    }
+
+    void append(const array_view<const T, 2>& X)
+    {
+        assert(!finished && X.extents(1) == n_cols);
+        for (size_t i = 0; i < X.extents(0); ++i) {
+            for (size_t j = 0; j < n_cols; ++j)
+                buf(buffered, j) = X(i, j);
+            if (++buffered == n_block_rows)
+                flush();
+        }
+    }
+
+    // writes the last block, the offset table and the footer
+    void finish()
+    {
+        if (finished)
+            return;
+        finished = true;
+        flush();
+        offsets.push_back(pos);
+        const size_t table_pos = pos;
+        for (auto o : offsets)
+            details::put_u64(os, o);
+        details::write_column_store_footer<T>(os, n_rows, n_cols, n_block_rows, table_pos);
+        if (!os)
+            throw column_store_error("column_store: write failed");
+    }
+
+private:
+    void flush()
+    {
+        if (buffered == 0)
+            return;
+        for (size_t j = 0; j < n_cols; ++j) {
+            bytes.clear();
+            codec::encode_block(&buf(0, j), buffered, bytes);
+            offsets.push_back(pos);
+            os.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            pos += bytes.size();
+        }
+        n_rows += buffered;
+        buffered = 0;
+    }
+
+    std::ostream& os;
+    const size_t n_cols, n_block_rows;
+    matrix<T> buf; // fortran_order: the columns are contiguous
+    size_t buffered = 0;
+    size_t n_rows = 0;
+    size_t pos = 0;
+    std::vector<size_t> offsets;
+    std::vector<std::uint8_t> bytes;
+    bool finished = false;
+};
+}
+
+#endif
@@ -2,9 +2,13 @@
 #define _IMPL_COORDINATE_H_ 1
 
 #include <assert.h>
+#include <algorithm>
 #include <iterator>
 #include "sx/type_traits.h"
 #include <array>
+#include <cstdint>
+
+#include "sx/fast_divisor.h"
 
 #ifdef _MSC_VER
 #define _CONSTEXPR
@@ -12,6 +16,11 @@
 #define _CONSTEXPR constexpr
 #endif
 
+// _NOEXCEPT is provided by libc++ and MSVC, but not by libstdc++
+#ifndef _NOEXCEPT
+#define _NOEXCEPT noexcept
+#endif
+
 namespace sx {
 
 namespace details {
@@ -511,6 +520,13 @@ struct bounds_iterator
         : bnd(std::move(bnd)),
           curr(std::move(curr))
     {
+        // the strides and the reciprocals of the extents are computed once
+        // here, so jumps don't recompute them and don't divide
+        stride[Rank - 1] = 1;
+        for (int i = Rank - 1; i-- > 0;)
+            stride[i] = stride[i + 1] * this->bnd[i + 1];
+        for (int i = 1; i < Rank; ++i)
+            div[i] = fast_divisor(std::max<ptrdiff_t>(this->bnd[i], 1));
     }
 
     reference operator*() const _NOEXCEPT { return curr; }
@@ -522,19 +538,17 @@ struct bounds_iterator
 
     bounds_iterator& operator++() _NOEXCEPT
     {
-        for (int i = Rank; i-- > 0;) {
-            if (++curr[i] < bnd[i]) {
+        if (++curr[Rank - 1] < bnd[Rank - 1])
+            return *this;
+        curr[Rank - 1] = 0;
+        for (int i = Rank - 1; i-- > 0;) {
+            if (++curr[i] < bnd[i])
                 return *this;
-            }
-            else {
-                curr[i] = 0;
-            }
+            curr[i] = 0;
         }
 
         // If we're here we've wrapped over - set to past-the-end.
-        for (int i = 0; i < Rank; ++i) {
-            curr[i] = bnd[i];
-        }
+        set_past_the_end();
         return *this;
     }
 
@@ -547,6 +561,11 @@ struct bounds_iterator
 
     bounds_iterator& operator--() _NOEXCEPT
     {
+        if (is_past_the_end(curr)) {
+            for (int i = 0; i < Rank; ++i)
+                curr[i] = bnd[i] - 1;
+            return *this;
+        }
         for (int i = Rank; i-- > 0;) {
             if (curr[i]-- > 0) {
                 return *this;
@@ -577,19 +596,25 @@ struct bounds_iterator
 
     bounds_iterator& operator+=(difference_type n) _NOEXCEPT
     {
-        auto linear_idx = linearize(curr) + n;
-
-        bounds<Rank> stride;
-        stride[Rank - 1] = 1;
-        for (int i = Rank - 1; i-- > 0;) {
-            stride[i] = stride[i + 1] * bnd[i + 1];
+        // short jumps within the innermost dimension
+        const ptrdiff_t inner = curr[Rank - 1] + n;
+        if (0 <= inner && inner < bnd[Rank - 1] && !is_past_the_end(curr)) {
+            curr[Rank - 1] = inner;
+            return *this;
         }
 
-        for (int i = 0; i < Rank; ++i) {
-            curr[i] = linear_idx / stride[i];
-            linear_idx = linear_idx % stride[i];
+        const ptrdiff_t linear_idx = linearize(curr) + n;
+        assert(0 <= linear_idx && linear_idx <= (ptrdiff_t)bnd.size());
+        if (linear_idx == (ptrdiff_t)bnd.size()) {
+            set_past_the_end();
+            return *this;
         }
-
+        std::uint64_t q = (std::uint64_t)linear_idx, r;
+        for (int i = Rank - 1; i > 0; --i) {
+            q = div[i].divmod(q, r);
+            curr[i] = (ptrdiff_t)r;
+        }
+        curr[0] = (ptrdiff_t)q;
         return *this;
     }
 
@@ -626,11 +651,7 @@ struct bounds_iterator
 
     bool operator<(const bounds_iterator& rhs) const _NOEXCEPT
     {
-        for (int i = 0; i < Rank; ++i) {
-            if (curr[i] < rhs.curr[i])
-                return true;
-        }
-        return false;
+        return linearize(curr) < linearize(rhs.curr);
     }
 
     bool operator<=(const bounds_iterator& rhs) const _NOEXCEPT
@@ -652,44 +673,39 @@ struct bounds_iterator
     {
         std::swap(bnd, rhs.bnd);
         std::swap(curr, rhs.curr);
+        std::swap(stride, rhs.stride);
+        std::swap(div, rhs.div);
     }
 
 private:
-    ptrdiff_t linearize(const index<Rank>& idx) const _NOEXCEPT
+    void set_past_the_end() _NOEXCEPT
     {
-        // TODO: Smarter impl.
+        for (int i = 0; i < Rank; ++i)
+            curr[i] = bnd[i];
+    }
 
-        // Check if past-the-end
-        bool pte = true;
-        for (int i = 0; i < Rank; ++i) {
-            if (idx[i] != bnd[i]) {
-                pte = false;
-                break;
-            }
-        }
+    bool is_past_the_end(const index<Rank>& idx) const _NOEXCEPT
+    {
+        for (int i = 0; i < Rank; ++i)
+            if (idx[i] != bnd[i])
+                return false;
+        return true;
+    }
 
-        ptrdiff_t multiplier = 1;
+    ptrdiff_t linearize(const index<Rank>& idx) const _NOEXCEPT
+    {
+        if (is_past_the_end(idx))
+            return (ptrdiff_t)bnd.size();
         ptrdiff_t res = 0;
-
-        if (pte) {
-            res = 1;
-            for (int i = Rank; i-- > 0;) {
-                res += (idx[i] - 1) * multiplier;
-                multiplier *= bnd[i];
-            }
-        }
-        else {
-            for (int i = Rank; i-- > 0;) {
-                res += idx[i] * multiplier;
-                multiplier *= bnd[i];
-            }
-        }
-
+        for (int i = 0; i < Rank; ++i)
+            res += idx[i] * stride[i];
         return res;
     }
 
     bounds<Rank> bnd;
     index<Rank> curr;
+    index<Rank> stride; // row-major strides of bnd
+    std::array<fast_divisor, Rank> div; // div[i] divides by bnd[i], i > 0
 };
 
 template <>
@@ -808,6 +824,30 @@ operator+(typename bounds_iterator<Rank>::difference_type n,
 {
     return rhs + n;
 }
+
+// calls f(idx) for all the indices within `b` in row-major order, as a loop
+// nest where only the innermost index changes in the inner loop (cheaper than
+// incrementing a bounds_iterator)
+template <int Rank, typename F>
+void for_each_index(const bounds<Rank>& b, F&& f)
+{
+    if (b.empty())
+        return;
+    index<Rank> idx;
+    const ptrdiff_t n = b[Rank - 1];
+    for (;;) {
+        for (idx[Rank - 1] = 0; idx[Rank - 1] < n; ++idx[Rank - 1])
+            f(static_cast<const index<Rank>&>(idx));
+        int i = Rank - 1;
+        while (i-- > 0) {
+            if (++idx[i] < b[i])
+                break;
+            idx[i] = 0;
+        }
+        if (i < 0)
+            return;
+    }
+}
 } // namespace ARRAY_VIEW_NAMESPACE
 
 #endif // _IMPL_COORDINATE_H_
@@ -0,0 +1,171 @@
+#ifndef CRITERION_INCLUDED_8530671924
+#define CRITERION_INCLUDED_8530671924
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "sx/array_view.h"
+#include "sx/multi_array.h"
+#include "sx/parallel.h"
+
+// Impurity criteria of all split candidates of a node at once
+//
+//     // L(i, c): the weight of class c left of candidate i (cumulative counts)
+//     // total(c): the weight of class c in the node
+//     auto p = sx::gini_proxy(L, total);   // one value per candidate, larger is better
+//
+// The proxies rank the candidates of one node like the decrease of the
+// impurity would, without the terms that are the same for all of them (as
+// scikit-learn's proxy_impurity_improvement):
+//
+// - gini_proxy: sum_c L_c^2 / n_L + sum_c R_c^2 / n_R
+// - entropy_proxy: sum_c (L_c log L_c + R_c log R_c) - n_L log n_L - n_R log n_R
+// - mse_proxy: sum_o S_o^2 / n_L + sum_o (T_o - S_o)^2 / n_R, S: cumulative
+//   sums of the outputs, T: their totals in the node
+//
+// where R = total - L and n_L, n_R are the weights of the two sides. A side
+// with no weight contributes 0. The weights are non-negative.
+//
+// The candidates are processed in blocks, in parallel. A block loops over the
+// classes outside and over its candidates inside, accumulating the terms of
+// every candidate in small arrays: the inner loops are without branches
+// across candidates, the compiler vectorizes them. They read a column of L,
+// contiguous in fortran_order only; copying c_order columns to a contiguous
+// buffer first was measured slower, the block stays in L1 either way. Every candidate
+// sums its classes in order, the results don't depend on the executor. The
+// logarithm is details::log_positive, a polynomial which vectorizes too
+// (std::log is a library call).
+
+namespace sx {
+
+namespace details {
+    // log(x) for a positive normal x, within an ulp, finite for any finite x
+    // Only bit operations and arithmetic, no compares, so loops calling it
+    // vectorize without -ffast-math.
+    inline double log_positive(double x)
+    {
+        // x = 2^e * m with m in [sqrt(1/2), sqrt(2))
+        const std::uint64_t kSqrtHalf = 0x3fe6a09e667f3bcdULL;
+        std::uint64_t b;
+        std::memcpy(&b, &x, sizeof b);
+        const std::uint64_t t = b - kSqrtHalf;
+        // e is the top 12 bits of t, signed: 2^52 + (t >> 52) - 2^52, minus
+        // 4096 if t is negative
+        const std::uint64_t kb = (t >> 52) | 0x4330000000000000ULL;
+        const std::uint64_t wb = (0 - (t >> 63)) & 0x40b0000000000000ULL;
+        double k, w;
+        std::memcpy(&k, &kb, sizeof k);
+        std::memcpy(&w, &wb, sizeof w);
+        const double e = k - 4503599627370496.0 - w;
+        b -= t & 0xfff0000000000000ULL;
+        double m;
+        std::memcpy(&m, &b, sizeof m);
+        // log(m) = 2 atanh(s) = 2 (s + s^3 / 3 + s^5 / 5 + ..), |s| < 0.172
+        const double s = (m - 1) / (m + 1), z = s * s;
+        const double p = 1
+            + z * (1. / 3 + z * (1. / 5 + z * (1. / 7 + z * (1. / 9 + z * (1. / 11 + z * (1. / 13
+            + z * (1. / 15 + z * (1. / 17 + z * (1. / 19 + z * (1. / 21))))))))));
+        return e * 0.69314718055994530942 + 2 * s * p;
+    }
+
+    // x log x for x >= 0 (0 for 0), about 0 for the tiny negative results of
+    // rounding
+    inline double xlogx(double x) { return x * log_positive(x); }
+
+    // a / w, 0 for w == 0 if a is 0 too (a side without samples)
+    inline double over_weight(double a, double w) { return a / (w + std::numeric_limits<double>::min()); }
+
+    // candidates per block, the per-candidate sums of a block stay in L1
+    static const size_t kCriterionBlock = 256;
+
+    // R(i) = finish(i, n_L, a, b) where n_L, a and b are the sums of l,
+    // term_a(l, t - l) and term_b(l, t - l) over the classes of row i of L,
+    // l = L(i, c), t = total(c)
+    template <typename TermA, typename TermB, typename Finish, typename Executor>
+    multi_array<double, 1> fold_classes(const array_view<const double, 2>& L, const array_view<const double>& total,
+        TermA term_a, TermB term_b, Finish finish, Executor& ex)
+    {
+        const size_t m = L.extents(0), nc = L.extents(1);
+        multi_array<double, 1> R(m);
+        const std::ptrdiff_t rs = L.strides(0), cs = L.strides(1);
+        ex.parallel_for((m + kCriterionBlock - 1) / kCriterionBlock, [&](size_t blk) {
+            const size_t b = blk * kCriterionBlock;
+            const std::ptrdiff_t len = (std::ptrdiff_t)std::min(kCriterionBlock, m - b);
+            double nl[kCriterionBlock] = {}, sa[kCriterionBlock] = {}, sb[kCriterionBlock] = {};
+            for (size_t c = 0; c < nc; ++c) {
+                const double t = total(c);
+                const double* l = L.data() + (std::ptrdiff_t)b * rs + (std::ptrdiff_t)c * cs;
+                for (std::ptrdiff_t i = 0; i < len; ++i) {
+                    const double x = l[i * rs];
+                    nl[i] += x;
+                    sa[i] += term_a(x, t - x);
+                    sb[i] += term_b(x, t - x);
+                }
+            }
+            double* r = R.data() + b;
+            for (std::ptrdiff_t i = 0; i < len; ++i)
+                r[i] = finish(b + (size_t)i, nl[i], sa[i], sb[i]);
+        });
+        return R;
+    }
+
+    inline double sum_of(const array_view<const double>& x)
+    {
+        double s = 0;
+        for (auto v : x)
+            s += v;
+        return s;
+    }
+}
+
+// L: candidates x classes, cumulative class weights, total: classes
+template <typename Executor = thread_pool>
+multi_array<double, 1> gini_proxy(const matrix_view<const double>& L, const array_view<const double>& total,
+    Executor& ex = par::default_executor())
+{
+    assert(total.extents(0) == L.extents(1));
+    const double n = details::sum_of(total);
+    return details::fold_classes(L, total, [](double l, double) { return l * l; },
+        [](double, double r) { return r * r; },
+        [n](size_t, double nl, double a, double b) {
+            return details::over_weight(a, nl) + details::over_weight(b, n - nl);
+        },
+        ex);
+}
+
+// L: candidates x classes, cumulative class weights, total: classes
+template <typename Executor = thread_pool>
+multi_array<double, 1> entropy_proxy(const matrix_view<const double>& L, const array_view<const double>& total,
+    Executor& ex = par::default_executor())
+{
+    assert(total.extents(0) == L.extents(1));
+    const double n = details::sum_of(total);
+    return details::fold_classes(L, total, [](double l, double) { return details::xlogx(l); },
+        [](double, double r) { return details::xlogx(r); },
+        [n](size_t, double nl, double a, double b) {
+            return a + b - details::xlogx(nl) - details::xlogx(n - nl);
+        },
+        ex);
+}
+
+// S: candidates x outputs, cumulative sums of the outputs, nl: candidates,
+// the cumulative weights, total: outputs, the sums in the node, n: the weight
+// of the node
+template <typename Executor = thread_pool>
+multi_array<double, 1> mse_proxy(const matrix_view<const double>& S, const array_view<const double>& nl,
+    const array_view<const double>& total, double n, Executor& ex = par::default_executor())
+{
+    assert(total.extents(0) == S.extents(1) && nl.extents(0) == S.extents(0));
+    return details::fold_classes(S, total, [](double s, double) { return s * s; },
+        [](double, double r) { return r * r; },
+        [&nl, n](size_t i, double, double a, double b) {
+            return details::over_weight(a, nl(i)) + details::over_weight(b, n - nl(i));
+        },
+        ex);
+}
+}
+
+#endif
@@ -0,0 +1,486 @@
+#ifndef CSV_INCLUDED_6602938471
+#define CSV_INCLUDED_6602938471
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "sx/array_view.h"
+#include "sx/multi_array.h"
+#include "sx/mapped_file.h"
+#include "sx/parallel.h"
+
+// Loading delimited numeric text (CSV, TSV, whitespace separated values)
+// into matrix<T>
+//
+// Whole file, parsed in parallel over chunks split at newline boundaries,
+// directly into the result (no intermediate buffers), on the executor given
+// as the last argument (par::default_executor() by default):
+//
+//     auto X = sx::load_csv<float>("X.csv");                 // matrix<float>
+//     sx::load_csv<float>("X.csv", X_view);                  // into a pre-sized matrix_view
+//
+// Streaming, fixed-size row blocks, only a small read buffer is held in memory:
+//
+//     std::ifstream f("X.csv");
+//     sx::csv_reader<float> r(f, 4096);
+//     sx::matrix_view<const float> block;
+//     while (r.next(block))
+//         train_on(block);
+//
+// Empty lines and lines starting with `csv_options::comment` are skipped.
+
+namespace sx {
+
+struct csv_error : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct csv_options {
+    char delimiter = ',';
+    char comment = '#';
+    size_t skip_rows = 0; // number of lines to skip at the beginning (e.g. header)
+    array_layout_t layout = array_layout::c_order; // layout of the result matrix
+};
+
+namespace details {
+    // exact powers of 10 in double
+    static constexpr double exact_pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    inline bool is_digit(char c) { return '0' <= c && c <= '9'; }
+
+    // significant digits accumulated into the 64-bit mantissa, 10^19 - 1 < 2^64
+    static const int kMaxMantissaDigits = 19;
+
+    // parses a floating point number from [p, e), advances p past the number
+    // Decimal numbers with at most 19 significant digits whose value is
+    // exactly representable before the final scaling are converted without
+    // rounding error with a single multiplication or division
+    // (Clinger's fast path), all other cases (long mantissas, large
+    // exponents, nan, inf) fall back to strtod.
+    inline bool parse_number(const char*& p, const char* e, double& out)
+    {
+        const char* s = p;
+        const char* q = p;
+        bool neg = false;
+        if (q != e && (*q == '-' || *q == '+'))
+            neg = *q++ == '-';
+        std::uint64_t m = 0;
+        int n_digits = 0, exp10 = 0;
+        bool any_digit = false;
+        for (; q != e && is_digit(*q); ++q) {
+            any_digit = true;
+            if (n_digits < kMaxMantissaDigits) {
+                m = m * 10 + (*q - '0');
+                if (m != 0)
+                    ++n_digits;
+            }
+            else
+                ++exp10, ++n_digits;
+        }
+        if (q != e && *q == '.') {
+            ++q;
+            for (; q != e && is_digit(*q); ++q) {
+                any_digit = true;
+                if (n_digits < kMaxMantissaDigits) {
+                    m = m * 10 + (*q - '0');
+                    --exp10;
+                    if (m != 0)
+                        ++n_digits;
+                }
+                else
+                    ++n_digits;
+            }
+        }
+        if (any_digit && q != e && (*q == 'e' || *q == 'E')) {
+            const char* r = q + 1;
+            bool eneg = false;
+            if (r != e && (*r == '-' || *r == '+'))
+                eneg = *r++ == '-';
+            if (r != e && is_digit(*r)) {
+                int x = 0;
+                for (; r != e && is_digit(*r); ++r)
+                    if (x < 100000)
+                        x = x * 10 + (*r - '0');
+                exp10 += eneg ? -x : x;
+                q = r;
+            }
+        }
+        if (any_digit && n_digits <= kMaxMantissaDigits && m <= (std::uint64_t(1) << 53)
+            && -22 <= exp10 && exp10 <= 22) {
+            double d = (double)m;
+            d = exp10 < 0 ? d / exact_pow10[-exp10] : d * exact_pow10[exp10];
+            out = neg ? -d : d;
+            p = q;
+            return true;
+        }
+
+        // slow path, strtod needs a zero-terminated string
+        const char* t = s;
+        while (t != e && (is_digit(*t) || ('a' <= (*t | 0x20) && (*t | 0x20) <= 'z')
+                             || *t == '.' || *t == '+' || *t == '-'))
+            ++t;
+        if (t == s)
+            return false;
+        char buf[64];
+        std::string long_buf;
+        const char* z;
+        if (t - s < (ptrdiff_t)sizeof(buf)) {
+            std::memcpy(buf, s, t - s);
+            buf[t - s] = 0;
+            z = buf;
+        }
+        else {
+            long_buf.assign(s, t);
+            z = long_buf.c_str();
+        }
+        char* zend;
+        out = std::strtod(z, &zend);
+        if (zend == z)
+            return false;
+        p = s + (zend - z);
+        return true;
+    }
+
+    // The double is correctly rounded, and every midpoint between two
+    // normal floats is a double, so rounding it to float is correct unless it
+    // landed on such a midpoint (the decimal may be on either side of it) or
+    // is in the subnormal range of float. Those go to strtof.
+    inline bool parse_number(const char*& p, const char* e, float& out)
+    {
+        const char* s = p;
+        double d;
+        if (!parse_number(p, e, d))
+            return false;
+        std::uint64_t b;
+        std::memcpy(&b, &d, sizeof b);
+        const double a = std::abs(d);
+        if ((b & 0x1fffffffu) == 0x10000000u || (a != 0 && a < std::numeric_limits<float>::min())) {
+            const std::string t(s, p);
+            out = std::strtof(t.c_str(), nullptr);
+        }
+        else
+            out = (float)d;
+        return true;
+    }
+
+    // fails for values out of the range of T
+    template <typename T, typename = std::enable_if_t<std::is_integral<T>::value> >
+    bool parse_number(const char*& p, const char* e, T& out)
+    {
+        const char* q = p;
+        bool neg = false;
+        if (q != e && (*q == '-' || *q == '+'))
+            neg = *q++ == '-';
+        if (q == e || !is_digit(*q))
+            return false;
+        // the largest magnitude with this sign
+        const std::uint64_t max = (std::uint64_t)std::numeric_limits<T>::max();
+        const std::uint64_t limit = !neg ? max : std::is_signed<T>::value ? max + 1 : 0;
+        std::uint64_t m = 0;
+        for (; q != e && is_digit(*q); ++q) {
+            const std::uint64_t d = (std::uint64_t)(*q - '0');
+            if (d > limit || m > (limit - d) / 10)
+                return false;
+            m = m * 10 + d;
+        }
+        out = neg ? (T)(0 - m) : (T)m;
+        p = q;
+        return true;
+    }
+
+    inline bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    // true if the line [b, e) (without '\n') doesn't contain data
+    inline bool is_skipped_line(const char* b, const char* e, char comment)
+    {
+        while (b != e && is_space(*b))
+            ++b;
+        return b == e || *b == comment;
+    }
+
+    inline const char* find_eol(const char* b, const char* e)
+    {
+        auto p = static_cast<const char*>(std::memchr(b, '\n', e - b));
+        return p ? p : e;
+    }
+
+    // number of fields in a line
+    inline size_t csv_count_fields(const char* b, const char* e, char delim)
+    {
+        while (e != b && is_space(e[-1]))
+            --e;
+        if (delim == ' ') {
+            size_t n = 0;
+            for (;;) {
+                while (b != e && is_space(*b))
+                    ++b;
+                if (b == e)
+                    return n;
+                ++n;
+                while (b != e && !is_space(*b))
+                    ++b;
+            }
+        }
+        return std::count(b, e, delim) + 1;
+    }
+
+    // parses the fields of the line [b, e) into out[0], out[stride], ...
+    template <typename T>
+    void csv_parse_line(const char* b, const char* e, char delim,
+        T* out, ptrdiff_t stride, size_t n_cols, size_t row)
+    {
+        const char* p = b;
+        // with delimiter ' ' any whitespace separates the fields
+        auto skip_space = [&]() {
+            while (p != e && is_space(*p) && (*p != delim || delim == ' '))
+                ++p;
+        };
+        for (size_t j = 0; j < n_cols; ++j, out += stride) {
+            skip_space();
+            if (j > 0 && delim != ' ') {
+                if (p == e || *p != delim)
+                    throw csv_error("csv: row " + std::to_string(row)
+                        + ": expected " + std::to_string(n_cols) + " fields");
+                ++p;
+                skip_space();
+            }
+            if (!parse_number(p, e, *out))
+                throw csv_error("csv: row " + std::to_string(row)
+                    + ", column " + std::to_string(j) + ": invalid number");
+        }
+        while (p != e && is_space(*p))
+            ++p;
+        if (p != e)
+            throw csv_error("csv: row " + std::to_string(row)
+                + ": expected " + std::to_string(n_cols) + " fields");
+    }
+
+    inline size_t csv_count_rows(const char* b, const char* e, char comment)
+    {
+        size_t n = 0;
+        while (b != e) {
+            auto eol = find_eol(b, e);
+            if (!is_skipped_line(b, eol, comment))
+                ++n;
+            b = eol == e ? e : eol + 1;
+        }
+        return n;
+    }
+
+    inline const char* skip_lines(const char* b, const char* e, size_t n)
+    {
+        for (; n > 0 && b != e; --n) {
+            auto eol = find_eol(b, e);
+            b = eol == e ? e : eol + 1;
+        }
+        return b;
+    }
+
+    // splits [b, e) into at most n chunks ending at line boundaries
+    inline std::vector<const char*> split_at_lines(const char* b, const char* e, size_t n)
+    {
+        std::vector<const char*> r{ b };
+        const size_t chunk = (e - b) / n + 1;
+        while (r.back() != e) {
+            auto p = r.back() + std::min<size_t>(chunk, e - r.back());
+            p = find_eol(p, e);
+            r.push_back(p == e ? e : p + 1);
+        }
+        return r;
+    }
+
+    struct csv_layout {
+        const char* data_begin; // first line after skip_rows
+        size_t n_cols;
+    };
+
+    inline csv_layout csv_find_layout(const char* b, const char* e, const csv_options& opts)
+    {
+        b = skip_lines(b, e, opts.skip_rows);
+        for (auto p = b; p != e;) {
+            auto eol = find_eol(p, e);
+            if (!is_skipped_line(p, eol, opts.comment))
+                return { b, csv_count_fields(p, eol, opts.delimiter) };
+            p = eol == e ? e : eol + 1;
+        }
+        return { b, 0 };
+    }
+
+    // parses [b, e) (without skip_rows) into dst which must have exactly
+    // the right shape
+    template <typename T, typename Executor>
+    void csv_parse_into(const char* b, const char* e, const array_view<T, 2>& dst,
+        const csv_options& opts, Executor& ex)
+    {
+        // chunks smaller than this are not worth a task
+        const size_t kMinChunkSize = 1 << 18;
+        const size_t n = std::max<size_t>(1, std::min<size_t>(ex.concurrency(), (e - b) / kMinChunkSize));
+        const auto chunks = split_at_lines(b, e, n);
+        const size_t n_chunks = chunks.size() - 1;
+
+        // first pass: rows per chunk (memchr-speed) to find where each chunk goes
+        std::vector<size_t> first_row(n_chunks + 1, 0);
+        ex.parallel_for(n_chunks, [&](size_t i) {
+            first_row[i + 1] = csv_count_rows(chunks[i], chunks[i + 1], opts.comment);
+        });
+        std::partial_sum(first_row.begin(), first_row.end(), first_row.begin());
+        if (first_row.back() != dst.extents(0))
+            throw csv_error("csv: expected " + std::to_string(dst.extents(0))
+                + " rows, found " + std::to_string(first_row.back()));
+
+        // second pass: parse directly into the destination
+        const size_t n_cols = dst.extents(1);
+        ex.parallel_for(n_chunks, [&](size_t i) {
+            size_t row = first_row[i];
+            for (auto p = chunks[i], pe = chunks[i + 1]; p != pe;) {
+                auto eol = find_eol(p, pe);
+                if (!is_skipped_line(p, eol, opts.comment)) {
+                    csv_parse_line(p, eol, opts.delimiter, &dst[{ row, 0 }],
+                        dst.strides(1), n_cols, row);
+                    ++row;
+                }
+                p = eol == pe ? pe : eol + 1;
+            }
+        });
+    }
+}
+
+// parses the text [b, e) into a pre-sized matrix view
+// throws csv_error if the shape doesn't match
+template <typename T, typename Executor = thread_pool>
+void parse_csv(const char* b, const char* e, const array_view<T, 2>& dst,
+    const csv_options& opts = csv_options(), Executor& ex = par::default_executor())
+{
+    auto l = details::csv_find_layout(b, e, opts);
+    if (l.n_cols != dst.extents(1) && dst.extents(0) > 0)
+        throw csv_error("csv: expected " + std::to_string(dst.extents(1))
+            + " columns, found " + std::to_string(l.n_cols));
+    details::csv_parse_into(l.data_begin, e, dst, opts, ex);
+}
+
+// parses the text [b, e) into a new matrix, the number of rows and columns
+// are determined from the text
+template <typename T, typename Executor = thread_pool>
+matrix<T> parse_csv(const char* b, const char* e, const csv_options& opts = csv_options(),
+    Executor& ex = par::default_executor())
+{
+    auto l = details::csv_find_layout(b, e, opts);
+    const size_t n_rows = details::csv_count_rows(l.data_begin, e, opts.comment);
+    matrix<T> r(typename matrix<T>::extents_type(n_rows, l.n_cols), opts.layout);
+    details::csv_parse_into(l.data_begin, e, r.view(), opts, ex);
+    return r;
+}
+
+template <typename T, typename Executor = thread_pool>
+matrix<T> load_csv(const std::string& filename, const csv_options& opts = csv_options(),
+    Executor& ex = par::default_executor())
+{
+    mapped_file f(filename);
+    return parse_csv<T>(f.begin(), f.end(), opts, ex);
+}
+
+template <typename T, typename Executor = thread_pool>
+void load_csv(const std::string& filename, const array_view<T, 2>& dst,
+    const csv_options& opts = csv_options(), Executor& ex = par::default_executor())
+{
+    mapped_file f(filename);
+    parse_csv(f.begin(), f.end(), dst, opts, ex);
+}
+
+// reads delimited text from a stream in blocks of `block_rows` rows
+// The view returned by next() is valid until the next call.
+template <typename T>
+class csv_reader {
+public:
+    csv_reader(std::istream& is, size_t block_rows, const csv_options& opts = csv_options())
+        : is(is)
+        , opts(opts)
+        , block_rows(block_rows)
+        , buf(kInitialBufsize)
+    {
+        assert(block_rows > 0);
+    }
+
+    // reads the next block of at most `block_rows` rows into `block`
+    // returns false if there are no more rows
+    bool next(array_view<const T, 2>& block)
+    {
+        size_t n = 0;
+        const char *b, *e;
+        while (n < block_rows && next_line(b, e)) {
+            if (line_no <= opts.skip_rows || details::is_skipped_line(b, e, opts.comment))
+                continue;
+            if (n_cols == 0) {
+                n_cols = details::csv_count_fields(b, e, opts.delimiter);
+                storage = matrix<T>(typename matrix<T>::extents_type(block_rows, n_cols), opts.layout);
+            }
+            details::csv_parse_line(b, e, opts.delimiter, &storage[{ n, 0 }],
+                storage.strides(1), n_cols, rows_read);
+            ++n;
+            ++rows_read;
+        }
+        if (n == 0)
+            return false;
+        block = storage.view()(slice_bounds(0, n), all);
+        return true;
+    }
+
+    size_t cols() const { return n_cols; }
+    size_t rows_so_far() const { return rows_read; }
+
+private:
+    static const size_t kInitialBufsize = 1 << 20;
+
+    // returns the next line without the '\n'
+    bool next_line(const char*& b, const char*& e)
+    {
+        for (;;) {
+            auto eol = details::find_eol(buf.data() + pos, buf.data() + end);
+            if (eol != buf.data() + end || (eof && pos != end)) {
+                b = buf.data() + pos;
+                e = eol;
+                pos = eol == buf.data() + end ? end : eol - buf.data() + 1;
+                ++line_no;
+                return true;
+            }
+            if (eof)
+                return false;
+            // move the partial line to the front and refill
+            std::memmove(buf.data(), buf.data() + pos, end - pos);
+            end -= pos;
+            pos = 0;
+            if (end == buf.size())
+                buf.resize(buf.size() * 2);
+            is.read(buf.data() + end, buf.size() - end);
+            end += (size_t)is.gcount();
+            if (!is)
+                eof = true;
+        }
+    }
+
+    std::istream& is;
+    const csv_options opts;
+    const size_t block_rows;
+    std::vector<char> buf;
+    size_t pos = 0, end = 0; // valid data is buf[pos, end)
+    bool eof = false;
+    size_t line_no = 0;
+    size_t rows_read = 0;
+    size_t n_cols = 0;
+    matrix<T> storage;
+};
+}
+
+#endif
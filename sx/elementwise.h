@@ -0,0 +1,144 @@
+#ifndef ELEMENTWISE_INCLUDED_2093487561
+#define ELEMENTWISE_INCLUDED_2093487561
+
+#include <cassert>
+
+#include "sx/array_view.h"
+
+// Element-wise kernels over same-shape array_views of any rank and layout
+//
+//     sx::transform(Y, X, [](float x) { return x * x; });  // Y(i, j) = X(i, j)^2
+//     sx::transform(X, X, S, std::divides<>());            // X(i, j) /= S(i, j)
+//     auto s = sx::accumulate(X, 0.0, std::plus<>());
+//
+// The loop nest follows the strides of the destination (of `x` for accumulate)
+// so the innermost loop is the one with the smallest stride. An argument with
+// zero stride in the innermost dimension (see broadcast_to) is loaded once per
+// run instead of once per element, so
+//
+//     sx::transform(X, X, sx::broadcast_to(mean, X.extents()), std::minus<>());
+//
+// costs the same as subtracting a scalar from each row. `f` should not have
+// side effects: it's called once per run for broadcast arguments.
+
+namespace sx {
+
+namespace details {
+    // the kernels below process a run of n elements: d[i * ds], a[i * as], ..
+
+    template <typename F>
+    struct transform_run {
+        F& f;
+        template <typename T, typename U>
+        void operator()(size_t n, T* d, U* a, std::ptrdiff_t ds, std::ptrdiff_t as) const
+        {
+            const std::ptrdiff_t m = (std::ptrdiff_t)n;
+            if (as == 0) {
+                const auto v = f(*a);
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    d[i * ds] = v;
+            }
+            else if (ds == 1 && as == 1)
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    d[i] = f(a[i]);
+            else
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    d[i * ds] = f(a[i * as]);
+        }
+    };
+
+    template <typename F>
+    struct transform2_run {
+        F& f;
+        template <typename T, typename U, typename V>
+        void operator()(size_t n, T* d, U* a, V* b, std::ptrdiff_t ds, std::ptrdiff_t as, std::ptrdiff_t bs) const
+        {
+            const std::ptrdiff_t m = (std::ptrdiff_t)n;
+            if (as == 0 && bs == 0) {
+                const auto v = f(*a, *b);
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    d[i * ds] = v;
+            }
+            else if (bs == 0) {
+                const auto bv = *b;
+                if (ds == 1 && as == 1)
+                    for (std::ptrdiff_t i = 0; i < m; ++i)
+                        d[i] = f(a[i], bv);
+                else
+                    for (std::ptrdiff_t i = 0; i < m; ++i)
+                        d[i * ds] = f(a[i * as], bv);
+            }
+            else if (as == 0) {
+                const auto av = *a;
+                if (ds == 1 && bs == 1)
+                    for (std::ptrdiff_t i = 0; i < m; ++i)
+                        d[i] = f(av, b[i]);
+                else
+                    for (std::ptrdiff_t i = 0; i < m; ++i)
+                        d[i * ds] = f(av, b[i * bs]);
+            }
+            else if (ds == 1 && as == 1 && bs == 1)
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    d[i] = f(a[i], b[i]);
+            else
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    d[i * ds] = f(a[i * as], b[i * bs]);
+        }
+    };
+
+    template <typename Acc, typename Op>
+    struct accumulate_run {
+        Acc& acc;
+        Op& op;
+        template <typename T>
+        void operator()(size_t n, T* p, std::ptrdiff_t s) const
+        {
+            const std::ptrdiff_t m = (std::ptrdiff_t)n;
+            Acc a = acc; // local, so it can stay in a register
+            if (s == 0) {
+                const auto v = *p;
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    a = op(a, v);
+            }
+            else if (s == 1)
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    a = op(a, p[i]);
+            else
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    a = op(a, p[i * s]);
+            acc = a;
+        }
+    };
+}
+
+// dst(i..) = f(x(i..))
+template <typename T, typename U, rank_type Rank, typename F>
+void transform(const array_view<T, Rank>& dst, const array_view<U, Rank>& x, F f)
+{
+    assert(dst.extents() == x.extents());
+    details::for_each_run<Rank>(dst.extents(), details::loop_order<Rank>(dst.strides()),
+        details::transform_run<F>{ f }, dst, x);
+}
+
+// dst(i..) = f(x(i..), y(i..))
+template <typename T, typename U, typename V, rank_type Rank, typename F>
+void transform(const array_view<T, Rank>& dst, const array_view<U, Rank>& x,
+    const array_view<V, Rank>& y, F f)
+{
+    assert(dst.extents() == x.extents() && dst.extents() == y.extents());
+    details::for_each_run<Rank>(dst.extents(), details::loop_order<Rank>(dst.strides()),
+        details::transform2_run<F>{ f }, dst, x, y);
+}
+
+// folds all elements of `x` into `init` with acc = op(acc, x(i..)), in memory
+// order (broadcast elements are visited as many times as they appear)
+template <typename T, rank_type Rank, typename Acc, typename Op>
+Acc accumulate(const array_view<T, Rank>& x, Acc init, Op op)
+{
+    details::for_each_run<Rank>(x.extents(), details::loop_order<Rank>(x.strides()),
+        details::accumulate_run<Acc, Op>{ init, op }, x);
+    return init;
+}
+}
+
+#endif
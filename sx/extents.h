@@ -0,0 +1,365 @@
+#ifndef EXTENTS_INCLUDED_8830127465
+#define EXTENTS_INCLUDED_8830127465
+
+#include <array>
+#include <cassert>
+#include <utility>
+#include <type_traits>
+
+#include "sx/array_view.h"
+
+// Mixed static/dynamic extents and compile-time layouts (like mdspan)
+//
+//     sx::extents<3, 3>                    // 3x3, nothing stored
+//     sx::extents<sx::dynamic, 4>(n)       // nx4, stores n only
+//
+//     sx::fixed_view<double, sx::extents<3, sx::dynamic>> v(p, n);     // layout_right (c_order)
+//     sx::fixed_view<double, sx::extents<3, 3>, sx::layout_left> w(q); // fortran_order
+//     v(i, j) = w(j, i);
+//
+//     sx::fixed_array<double, 4, 4> A;    // owning, fully static
+//
+// With static extents the index computation constant-folds and the loops of
+// for_each_index, copy and fill are fully unrolled for small extents.
+// fixed_view converts to array_view<T, Rank> for the rest of the library.
+
+namespace sx {
+
+static constexpr size_t dynamic = ~size_t(0);
+
+namespace details {
+    template <size_t... E>
+    struct count_dynamic;
+    template <>
+    struct count_dynamic<> : std::integral_constant<rank_type, 0> {
+    };
+    template <size_t E0, size_t... E>
+    struct count_dynamic<E0, E...>
+        : std::integral_constant<rank_type, (E0 == dynamic) + count_dynamic<E...>::value> {
+    };
+}
+
+template <size_t... E>
+class extents {
+    static_assert(sizeof...(E) > 0, "rank must be > 0");
+
+public:
+    using rank_type = ::sx::rank_type;
+
+    static constexpr rank_type rank() { return sizeof...(E); }
+    static constexpr rank_type rank_dynamic() { return details::count_dynamic<E...>::value; }
+    static constexpr size_t static_extent(rank_type i)
+    {
+        constexpr size_t e[] = { E... };
+        return e[i];
+    }
+    static constexpr bool is_static() { return rank_dynamic() == 0; }
+
+    // the dynamic extents are zero
+    constexpr extents() noexcept = default;
+    // the values of the dynamic extents, in order
+    template <typename... Ts,
+        typename = std::enable_if_t<sizeof...(Ts) == details::count_dynamic<E...>::value && (sizeof...(Ts) > 0)> >
+    constexpr explicit extents(Ts... dyn) noexcept
+        : d{ { static_cast<size_t>(dyn)... } }
+    {
+    }
+    // from all the extents, the static ones must match
+    explicit extents(const std::array<size_t, sizeof...(E)>& e) noexcept
+    {
+        for (rank_type i = 0; i < rank(); ++i) {
+            if (static_extent(i) == dynamic)
+                d[dynamic_index(i)] = e[i];
+            else
+                assert(static_extent(i) == e[i]);
+        }
+    }
+
+    constexpr size_t extent(rank_type i) const
+    {
+        return static_extent(i) == dynamic ? d[dynamic_index(i)] : static_extent(i);
+    }
+    // compile-time dimension: folds to a constant for static extents
+    template <rank_type I>
+    constexpr size_t extent() const
+    {
+        return static_extent(I) == dynamic ? d[dynamic_index(I)] : static_extent(I);
+    }
+    constexpr size_t size() const
+    {
+        size_t s = 1;
+        for (rank_type i = 0; i < rank(); ++i)
+            s *= extent(i);
+        return s;
+    }
+    std::array<size_t, sizeof...(E)> to_array() const
+    {
+        std::array<size_t, sizeof...(E)> a;
+        for (rank_type i = 0; i < rank(); ++i)
+            a[i] = extent(i);
+        return a;
+    }
+
+    constexpr bool operator==(const extents& x) const
+    {
+        for (rank_type i = 0; i < rank(); ++i)
+            if (extent(i) != x.extent(i))
+                return false;
+        return true;
+    }
+    constexpr bool operator!=(const extents& x) const { return !(*this == x); }
+
+private:
+    // index of dimension i among the dynamic ones
+    static constexpr rank_type dynamic_index(rank_type i)
+    {
+        rank_type n = 0;
+        for (rank_type j = 0; j < i; ++j)
+            n += static_extent(j) == dynamic;
+        return n;
+    }
+
+    // at least one element so extents with no dynamic extent are valid
+    std::array<size_t, (details::count_dynamic<E...>::value > 0 ? details::count_dynamic<E...>::value : 1)> d = {};
+};
+
+// the last index is contiguous, like array_layout::c_order
+struct layout_right {
+    template <typename Extents>
+    static constexpr size_t stride(const Extents& e, rank_type r)
+    {
+        size_t s = 1;
+        for (rank_type i = r + 1; i < Extents::rank(); ++i)
+            s *= e.extent(i);
+        return s;
+    }
+    // dimension iterated at the `level`-th level of a loop nest in memory order
+    static constexpr rank_type loop_dim(rank_type /*rank*/, rank_type level) { return level; }
+    static constexpr array_layout_t array_layout() { return array_layout::c_order; }
+};
+
+// the first index is contiguous, like array_layout::fortran_order
+struct layout_left {
+    template <typename Extents>
+    static constexpr size_t stride(const Extents& e, rank_type r)
+    {
+        size_t s = 1;
+        for (rank_type i = 0; i < r; ++i)
+            s *= e.extent(i);
+        return s;
+    }
+    static constexpr rank_type loop_dim(rank_type rank, rank_type level) { return rank - 1 - level; }
+    static constexpr array_layout_t array_layout() { return array_layout::fortran_order; }
+};
+
+namespace details {
+    // extents at most this large are unrolled
+    static const size_t kMaxUnrolledExtent = 16;
+
+    template <size_t N, typename F, size_t... I>
+    void unrolled_for(F&& f, std::index_sequence<I...>)
+    {
+        (void)std::initializer_list<int>{ (f(I), 0)... };
+    }
+
+    // calls f(i) for i = 0..n-1, unrolled if the extent is static and small
+    template <size_t StaticN, typename F,
+        typename = std::enable_if_t<(StaticN != dynamic && StaticN <= kMaxUnrolledExtent)> >
+    void static_or_dynamic_for(size_t, F&& f)
+    {
+        unrolled_for<StaticN>(f, std::make_index_sequence<StaticN>());
+    }
+    template <size_t StaticN, typename F,
+        typename = std::enable_if_t<!(StaticN != dynamic && StaticN <= kMaxUnrolledExtent)>, typename = void>
+    void static_or_dynamic_for(size_t n, F&& f)
+    {
+        for (size_t i = 0; i < n; ++i)
+            f(i);
+    }
+
+    template <rank_type Level, typename Extents, typename Layout, typename F,
+        bool Done = (Level == Extents::rank())>
+    struct index_loop {
+        static void run(const Extents& e, std::array<size_t, Extents::rank()>& idx, F& f)
+        {
+            constexpr rank_type d = Layout::loop_dim(Extents::rank(), Level);
+            static_or_dynamic_for<Extents::static_extent(d)>(e.template extent<d>(), [&](size_t i) {
+                idx[d] = i;
+                index_loop<Level + 1, Extents, Layout, F>::run(e, idx, f);
+            });
+        }
+    };
+    template <rank_type Level, typename Extents, typename Layout, typename F>
+    struct index_loop<Level, Extents, Layout, F, true> {
+        static void run(const Extents&, std::array<size_t, Extents::rank()>& idx, F& f)
+        {
+            f(idx);
+        }
+    };
+}
+
+// calls f(idx) for all the multi-indices within `e`, in the memory order of Layout
+template <typename Layout = layout_right, size_t... E, typename F>
+void for_each_index(const extents<E...>& e, F&& f)
+{
+    std::array<size_t, sizeof...(E)> idx;
+    idx.fill(0);
+    details::index_loop<0, extents<E...>, Layout, F>::run(e, idx, f);
+}
+
+template <typename T, typename Extents, typename Layout = layout_right>
+class fixed_view {
+public:
+    using extents_type = Extents;
+    using layout_type = Layout;
+    using value_type = std::remove_const_t<T>;
+    using pointer = T*;
+    using reference = T&;
+    using indices_type = std::array<size_t, Extents::rank()>;
+
+    static constexpr rank_type rank() { return Extents::rank(); }
+
+    constexpr fixed_view() noexcept
+        : p(nullptr)
+        , e()
+    {
+    }
+    // the dynamic extents follow the pointer
+    template <typename... Ts,
+        typename = std::enable_if_t<sizeof...(Ts) == Extents::rank_dynamic()> >
+    constexpr explicit fixed_view(pointer p, Ts... dyn) noexcept
+        : p(p)
+        , e(dyn...)
+    {
+    }
+    constexpr fixed_view(pointer p, const Extents& e) noexcept
+        : p(p)
+        , e(e)
+    {
+    }
+    // from an array_view with the same layout (asserted)
+    explicit fixed_view(const array_view<T, Extents::rank()>& x)
+        : p(x.data())
+        , e(x.extents())
+    {
+        for (rank_type i = 0; i < rank(); ++i)
+            assert(e.extent(i) <= 1 || x.strides(i) == (std::ptrdiff_t)Layout::stride(e, i));
+    }
+    // from a view of non-const
+    template <typename U, typename = std::enable_if_t<std::is_same<const U, T>::value> >
+    constexpr fixed_view(const fixed_view<U, Extents, Layout>& x) noexcept
+        : p(x.data())
+        , e(x.extents())
+    {
+    }
+
+    constexpr pointer data() const noexcept { return p; }
+    constexpr const Extents& extents() const noexcept { return e; }
+    constexpr size_t extents(rank_type i) const noexcept { return e.extent(i); }
+    constexpr size_t strides(rank_type i) const noexcept { return Layout::stride(e, i); }
+    constexpr size_t size() const noexcept { return e.size(); }
+    constexpr bool empty() const noexcept { return size() == 0; }
+
+    template <typename... Is,
+        typename = std::enable_if_t<sizeof...(Is) == Extents::rank()> >
+    constexpr reference operator()(Is... i) const noexcept
+    {
+        return p[offset(std::make_index_sequence<sizeof...(Is)>(), i...)];
+    }
+    reference operator[](const indices_type& idx) const noexcept
+    {
+        return p[offset_of(idx, std::make_index_sequence<Extents::rank()>())];
+    }
+
+    // to be used with the rest of the library
+    array_view<T, Extents::rank()> view() const
+    {
+        return array_view<T, Extents::rank()>(p, e.to_array(), Layout::array_layout());
+    }
+    operator array_view<T, Extents::rank()>() const { return view(); }
+
+    // calls f(element) in memory order
+    template <typename F>
+    void for_each(F&& f) const
+    {
+        for_each_index<Layout>(e, [&](const indices_type& idx) { f((*this)[idx]); });
+    }
+    void fill(const value_type& v) const
+    {
+        for_each([&v](reference x) { x = v; });
+    }
+    // deep copy from a same-shape view
+    template <typename U, typename L>
+    const fixed_view& operator<<=(const fixed_view<U, Extents, L>& x) const
+    {
+        assert(e == x.extents());
+        for_each_index<Layout>(e, [&](const indices_type& idx) { (*this)[idx] = x[idx]; });
+        return *this;
+    }
+    template <typename U>
+    const fixed_view& operator<<=(const array_view<U, Extents::rank()>& x) const
+    {
+        for_each_index<Layout>(e, [&](const indices_type& idx) { (*this)[idx] = x[idx]; });
+        return *this;
+    }
+
+private:
+    template <rank_type R>
+    constexpr size_t stride() const { return Layout::stride(e, R); }
+
+    template <size_t... R, typename... Is>
+    constexpr size_t offset(std::index_sequence<R...>, Is... i) const
+    {
+        size_t s = 0;
+        (void)std::initializer_list<int>{ (s += static_cast<size_t>(i) * stride<R>(), 0)... };
+        return s;
+    }
+    template <size_t... R>
+    constexpr size_t offset_of(const indices_type& idx, std::index_sequence<R...>) const
+    {
+        return offset(std::index_sequence<R...>(), idx[R]...);
+    }
+
+    pointer p;
+    Extents e;
+};
+
+// owning array with fully static extents, layout_right
+template <typename T, size_t... E>
+class fixed_array {
+    static_assert(extents<E...>::is_static(), "fixed_array needs static extents");
+
+public:
+    using extents_type = extents<E...>;
+    using view_type = fixed_view<T, extents_type>;
+    using const_view_type = fixed_view<const T, extents_type>;
+    using value_type = T;
+    using indices_type = typename view_type::indices_type;
+
+    static constexpr rank_type rank() { return sizeof...(E); }
+    static constexpr size_t size() { return extents_type().size(); }
+
+    view_type view() { return view_type(d.data()); }
+    const_view_type view() const { return const_view_type(d.data()); }
+
+    template <typename... Is>
+    T& operator()(Is... i) { return view()(i...); }
+    template <typename... Is>
+    const T& operator()(Is... i) const { return view()(i...); }
+    T& operator[](const indices_type& idx) { return view()[idx]; }
+    const T& operator[](const indices_type& idx) const { return view()[idx]; }
+
+    T* data() { return d.data(); }
+    const T* data() const { return d.data(); }
+    T* begin() { return d.data(); }
+    T* end() { return d.data() + d.size(); }
+    const T* begin() const { return d.data(); }
+    const T* end() const { return d.data() + d.size(); }
+
+    void fill(const T& v) { d.fill(v); }
+
+    std::array<T, extents_type().size()> d;
+};
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef FAST_DIVISOR_INCLUDED_3810274956
+#define FAST_DIVISOR_INCLUDED_3810274956
+
+#include <cassert>
+#include <cstdint>
+
+// Division by a runtime-invariant unsigned 64-bit divisor with a multiply and
+// shifts instead of a hardware divide (Granlund-Montgomery, the "round-up"
+// method used by libdivide):
+//
+//     sx::fast_divisor d(extent);   // once, costs one 128-bit division
+//     q = d.quotient(n);            // == n / extent, for all n
+//
+// Without a 128-bit integer type it falls back to plain division.
+
+namespace sx {
+
+class fast_divisor {
+public:
+    fast_divisor()
+        : fast_divisor(1)
+    {
+    }
+    explicit fast_divisor(std::uint64_t d)
+        : d(d)
+    {
+        assert(d > 0);
+#ifdef __SIZEOF_INT128__
+        int l = 0; // l = ceil(log2(d))
+        while (l < 64 && (std::uint64_t(1) << l) < d)
+            ++l;
+        using u128 = unsigned __int128;
+        m = (std::uint64_t)((((u128)1 << l) - d) * ((u128)1 << 64) / d) + 1;
+        sh1 = l > 0 ? 1 : 0;
+        sh2 = l > 0 ? l - 1 : 0;
+#endif
+    }
+
+    std::uint64_t divisor() const { return d; }
+
+    std::uint64_t quotient(std::uint64_t n) const
+    {
+#ifdef __SIZEOF_INT128__
+        const std::uint64_t t = (std::uint64_t)(((unsigned __int128)m * n) >> 64);
+        return (t + ((n - t) >> sh1)) >> sh2;
+#else
+        return n / d;
+#endif
+    }
+
+    // n / d and n % d
+    std::uint64_t divmod(std::uint64_t n, std::uint64_t& r) const
+    {
+        const std::uint64_t q = quotient(n);
+        r = n - q * d;
+        return q;
+    }
+
+private:
+    std::uint64_t d;
+#ifdef __SIZEOF_INT128__
+    std::uint64_t m;
+    int sh1, sh2;
+#endif
+};
+}
+
+#endif
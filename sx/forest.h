@@ -0,0 +1,251 @@
+#ifndef FOREST_INCLUDED_7103958246
+#define FOREST_INCLUDED_7103958246
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "sx/multi_array.h"
+#include "sx/parallel.h"
+#include "sx/quickscorer.h"
+#include "sx/sort.h"
+#include "sx/tree.h"
+
+// Batched inference of tree ensembles
+//
+//     sx::forest<float, double> f(std::move(trees)); // vector<sx::tree<float, double>>
+//     auto P = sx::predict(f, X);         // n_samples x n_outputs, mean of the leaf values
+//     auto y = sx::predict_class(f, X);   // indmax_along(P, 1)
+//
+// The samples are processed in blocks. A block walks a tree in lockstep: every
+// step moves all samples of the block one level down, `depth - 1` steps in
+// total (the leaves of a tree are their own children). In breadth_first trees
+// the step is node = left + (x > threshold), otherwise a compare and a select;
+// no branches either way. The loops have a fixed trip count and no data
+// dependent control flow, the compiler can vectorize them.
+//
+// The blocks are small (the samples stay in L1) when the node arrays of all
+// trees fit in `predict_options::cache_bytes`, then every block visits all
+// trees. Otherwise the blocks are made as large as the cache allows and the
+// trees are visited one by one, so the nodes of one tree are reused by many
+// samples while they are cached. The blocks are distributed over the
+// threads of the executor.
+//
+// QuickScorer (see quickscorer.h) is the other inference mode. Its cost grows
+// with the number of split nodes, it applies each of them to a whole block of
+// samples, while the lockstep walk costs one step per level. In
+// bench/forest.cpp QuickScorer is 10-20% faster for trees of 3 and 4 levels
+// and slower from 5 levels on (2x for 7), so automatic mode picks it up to
+// `predict_options::quickscorer_max_depth` levels, 4 by default. Its model is
+// built on the first use and kept in the forest.
+
+namespace sx {
+
+template <typename T, typename V = T>
+class forest {
+public:
+    using tree_type = tree<T, V>;
+    using const_iterator = typename std::vector<tree_type>::const_iterator;
+
+    forest() = default;
+    explicit forest(std::vector<tree_type> trees)
+        : trees(std::move(trees))
+    {
+        for (auto& t : this->trees)
+            check(t);
+    }
+
+    void push_back(tree_type t)
+    {
+        check(t);
+        trees.push_back(std::move(t));
+        std::atomic_store(&qs, std::shared_ptr<const quickscorer<T, V> >());
+    }
+
+    size_t size() const { return trees.size(); }
+    bool empty() const { return trees.empty(); }
+    const tree_type& operator[](size_t i) const { return trees[i]; }
+    const_iterator begin() const { return trees.begin(); }
+    const_iterator end() const { return trees.end(); }
+
+    size_t n_outputs() const { return trees.empty() ? 0 : trees.front().n_outputs(); }
+    // levels of the deepest tree
+    size_t depth() const
+    {
+        size_t d = 0;
+        for (auto& t : trees)
+            d = std::max(d, t.depth());
+        return d;
+    }
+    // true if all trees have at most 64 leaves
+    bool supports_quickscorer() const
+    {
+        for (auto& t : trees)
+            if (!quickscorer<T, V>::supports(t))
+                return false;
+        return true;
+    }
+    // the QuickScorer model of the trees, built on the first call
+    const quickscorer<T, V>& quickscorer_model() const
+    {
+        assert(supports_quickscorer());
+        auto p = std::atomic_load(&qs);
+        if (!p) {
+            p = std::make_shared<const quickscorer<T, V> >(trees);
+            std::atomic_store(&qs, p);
+        }
+        return *p;
+    }
+    // bytes of the node arrays of all trees, what a sample block walks over
+    size_t node_bytes() const
+    {
+        size_t s = 0;
+        for (auto& t : trees)
+            s += t.size() * (4 * sizeof(typename tree_type::index_type) + sizeof(T));
+        return s;
+    }
+
+private:
+    void check(const tree_type& t) const
+    {
+        assert(!t.empty());
+        assert(trees.empty() || t.n_outputs() == trees.front().n_outputs());
+        (void)t;
+    }
+
+    std::vector<tree_type> trees;
+    mutable std::shared_ptr<const quickscorer<T, V> > qs;
+};
+
+enum class inference {
+    automatic, // quickscorer up to predict_options::quickscorer_max_depth levels, node_walk otherwise
+    node_walk,
+    quickscorer // falls back to node_walk for trees with more than 64 leaves
+};
+
+struct predict_options {
+    // samples per block when the trees fit in the cache
+    size_t block_rows = 64;
+    // the cache size assumed for choosing the traversal order
+    size_t cache_bytes = 1 << 20;
+    // parallel blocks won't be smaller than this
+    size_t min_parallel_rows = 256;
+    inference mode = inference::automatic;
+    // the deepest forest (in levels) evaluated with QuickScorer in automatic
+    // mode, at most 7 (64 leaves), 0: never
+    size_t quickscorer_max_depth = 4;
+};
+
+namespace details {
+    // leaf of each sample of the block after walking `t` in lockstep
+    template <typename T, typename V, typename U>
+    void walk_tree(const tree<T, V>& t, const U* x, std::ptrdiff_t rs, std::ptrdiff_t cs, size_t m,
+        std::int32_t* node)
+    {
+        const std::int32_t* f = t.features().data();
+        const T* thr = t.thresholds().data();
+        const std::int32_t* l = t.children_left().data();
+        const std::int32_t* r = t.children_right().data();
+        std::fill_n(node, m, 0);
+        const std::ptrdiff_t n = (std::ptrdiff_t)m;
+        const bool adjacent = t.layout() == tree_layout::breadth_first;
+        for (size_t d = 1; d < t.depth(); ++d)
+            if (adjacent && cs == 1)
+                for (std::ptrdiff_t s = 0; s < n; ++s) {
+                    const std::int32_t i = node[s];
+                    node[s] = l[i] + (std::int32_t)(x[s * rs + f[i]] > thr[i]);
+                }
+            else if (adjacent)
+                for (std::ptrdiff_t s = 0; s < n; ++s) {
+                    const std::int32_t i = node[s];
+                    node[s] = l[i] + (std::int32_t)(x[s * rs + f[i] * cs] > thr[i]);
+                }
+            else
+                for (std::ptrdiff_t s = 0; s < n; ++s) {
+                    const std::int32_t i = node[s];
+                    node[s] = x[s * rs + f[i] * cs] > thr[i] ? r[i] : l[i];
+                }
+    }
+
+    // acc(s, ..) += values of the leaf node[s], acc is m x n_out, c_order
+    template <typename T, typename V>
+    void add_leaf_values(const tree<T, V>& t, const std::int32_t* node, size_t m, V* acc)
+    {
+        const size_t n_out = t.n_outputs();
+        const std::int32_t* off = t.value_offsets().data();
+        const V* vals = t.values().data();
+        if (n_out == 1)
+            for (size_t s = 0; s < m; ++s)
+                acc[s] += vals[off[node[s]]];
+        else
+            for (size_t s = 0; s < m; ++s) {
+                const V* v = vals + (size_t)off[node[s]] * n_out;
+                V* a = acc + s * n_out;
+                for (size_t o = 0; o < n_out; ++o)
+                    a[o] += v[o];
+            }
+    }
+}
+
+// mean of the leaf values of the trees for each row of X (samples x features)
+template <typename T, typename V, typename U, typename Executor = thread_pool>
+matrix<V> predict(const forest<T, V>& f, const array_view<U, 2>& X,
+    const predict_options& opts = predict_options(), Executor& ex = par::default_executor())
+{
+    const size_t n = X.extents(0), n_out = f.n_outputs();
+    matrix<V> P(typename matrix<V>::extents_type(n, n_out), array_layout::c_order, V());
+    if (n == 0 || f.empty())
+        return P;
+
+    // samples per block, see the comment at the top
+    const size_t row_bytes = std::max<size_t>(1, X.extents(1) * sizeof(U));
+    const bool trees_fit = f.node_bytes() <= opts.cache_bytes;
+    size_t block = trees_fit ? opts.block_rows : std::max(opts.block_rows, opts.cache_bytes / 2 / row_bytes);
+    block = std::max<size_t>(1, std::min(block, n));
+    // tasks of whole blocks, kChunksPerThread per thread unless they'd get too small
+    const size_t k = par::details::kChunksPerThread * ex.concurrency();
+    const size_t blocks_per_task = std::max<size_t>(1,
+        std::max((n + block - 1) / block / k, (opts.min_parallel_rows + block - 1) / block));
+    const size_t task_rows = blocks_per_task * block;
+
+    const std::ptrdiff_t rs = X.strides(0), cs = X.strides(1);
+    const bool use_qs = opts.mode == inference::automatic
+        ? f.depth() <= std::min<size_t>(opts.quickscorer_max_depth, 7)
+        : opts.mode == inference::quickscorer && f.supports_quickscorer();
+    const quickscorer<T, V>* qs = use_qs ? &f.quickscorer_model() : nullptr;
+    ex.parallel_for((n + task_rows - 1) / task_rows, [&](size_t task) {
+        memory::vector<std::int32_t> node(block);
+        typename quickscorer<T, V>::template workspace<std::remove_const_t<U> > qws;
+        const size_t task_end = std::min(n, (task + 1) * task_rows);
+        for (size_t b = task * task_rows; b < task_end; b += block) {
+            const size_t m = std::min(block, task_end - b);
+            const U* x = X.data() + (std::ptrdiff_t)b * rs;
+            V* acc = P.data() + b * n_out;
+            if (qs)
+                qs->add_predictions(x, rs, cs, m, acc, qws);
+            else
+                for (auto& t : f) {
+                    details::walk_tree(t, x, rs, cs, m, node.data());
+                    details::add_leaf_values(t, node.data(), m, acc);
+                }
+            const V scale = V(1) / (V)f.size();
+            for (size_t i = 0; i < m * n_out; ++i)
+                acc[i] *= scale;
+        }
+    });
+    return P;
+}
+
+// the index of the largest mean leaf value (the class) for each row of X
+template <typename T, typename V, typename U, typename Executor = thread_pool>
+multi_array<V, 1> predict_class(const forest<T, V>& f, const array_view<U, 2>& X,
+    const predict_options& opts = predict_options(), Executor& ex = par::default_executor())
+{
+    const auto P = predict(f, X, opts, ex);
+    return indmax_along(P.view(), 1);
+}
+}
+
+#endif
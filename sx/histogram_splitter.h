@@ -0,0 +1,292 @@
+#ifndef HISTOGRAM_SPLITTER_INCLUDED_7281946035
+#define HISTOGRAM_SPLITTER_INCLUDED_7281946035
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sx/array_view.h"
+#include "sx/memory.h"
+#include "sx/parallel.h"
+#include "sx/reduce.h"
+#include "sx/splitter.h"
+
+// Histogram split search for gradient boosting
+//
+//     sx::histogram_splitter sp(Xb);           // Xb: samples x features, uint8 bin codes
+//     auto root = sp.root();
+//     sp.build_histogram(root, g, h);          // gradients and hessians of all samples
+//     auto s = sp.find_split(root);            // s.threshold is a bin: bin > threshold goes right
+//     if (s.is_valid()) {
+//         auto children = sp.apply_split(root, s, g, h); // both children have histograms
+//         ...
+//     }
+//     else
+//         sp.release(root);                    // a leaf, its histogram isn't needed
+//
+// A node's histogram holds the sums of the gradients, the hessians and the
+// sample counts per bin and feature. They're built with the inner loop of
+// par::bincount over the node's samples, the features in parallel. The
+// gradients of the node are gathered first so the loops read them in order.
+//
+// apply_split partitions the samples of the node (a range of the sample
+// permutation), builds the histogram of the smaller child only and gets the
+// larger one by subtracting it from the parent's, in place. So each level of
+// a tree costs at most half of the samples.
+//
+// find_split computes the prefix sums of a feature's histogram and then the
+// gains of all thresholds in one branch-free pass:
+//
+//     gain = GL^2 / (HL + l2) + GR^2 / (HR + l2) - G^2 / (H + l2)
+//
+// With unit hessians and no regularization that's the decrease of the sum of
+// squared errors of presorted_splitter. A threshold which leaves a child
+// with HL + l2 <= 0 (all hessians zero, no regularization) has no gain.
+//
+// The histograms live in a histogram_pool: fixed size slots keyed by node id,
+// released slots are reused by later nodes.
+
+namespace sx {
+
+// fixed size arrays of doubles keyed by an id, reused after release
+class histogram_pool {
+public:
+    explicit histogram_pool(size_t slot_size)
+        : slot_size(slot_size)
+    {
+    }
+
+    // a zeroed slot for `key`, which must not have one
+    double* acquire(size_t key)
+    {
+        assert(!slot_of.count(key));
+        size_t k;
+        if (free_slots.empty()) {
+            k = slots.size();
+            slots.emplace_back(slot_size, 0.0, memory::tracking_allocator<double>("histogram_pool"));
+        }
+        else {
+            k = free_slots.back();
+            free_slots.pop_back();
+            std::fill(slots[k].begin(), slots[k].end(), 0.0);
+        }
+        slot_of[key] = k;
+        return slots[k].data();
+    }
+    // the slot of `key`, nullptr if it has none
+    double* find(size_t key)
+    {
+        auto it = slot_of.find(key);
+        return it == slot_of.end() ? nullptr : slots[it->second].data();
+    }
+    const double* find(size_t key) const { return const_cast<histogram_pool*>(this)->find(key); }
+    // hands the slot of `from` over to `to`
+    void rekey(size_t from, size_t to)
+    {
+        auto it = slot_of.find(from);
+        assert(it != slot_of.end() && !slot_of.count(to));
+        const size_t k = it->second;
+        slot_of.erase(it);
+        slot_of[to] = k;
+    }
+    void release(size_t key)
+    {
+        auto it = slot_of.find(key);
+        if (it == slot_of.end())
+            return;
+        free_slots.push_back(it->second);
+        slot_of.erase(it);
+    }
+
+    size_t size() const { return slot_of.size(); } // slots in use
+    size_t capacity() const { return slots.size(); } // slots allocated
+
+private:
+    size_t slot_size;
+    std::vector<memory::vector<double> > slots;
+    std::vector<size_t> free_slots;
+    std::unordered_map<size_t, size_t> slot_of;
+};
+
+class histogram_splitter {
+public:
+    // samples [begin, end) of the sample permutation
+    struct node {
+        size_t id, begin, end;
+        size_t size() const { return end - begin; }
+    };
+
+    // Xb must outlive the splitter, its bin codes are less than n_bins
+    explicit histogram_splitter(const array_view<const std::uint8_t, 2>& Xb, size_t n_bins = 256)
+        : X(Xb)
+        , nb(n_bins)
+        , rows(Xb.extents(0), 0, memory::tracking_allocator<std::uint32_t>("splitter"))
+        , pool(3 * n_bins * Xb.extents(1))
+    {
+        assert(n_bins >= 1 && n_bins <= 256 && Xb.extents(0) < (size_t)UINT32_MAX);
+        for (size_t i = 0; i < rows.size(); ++i)
+            rows[i] = (std::uint32_t)i;
+    }
+
+    size_t n_samples() const { return X.extents(0); }
+    size_t n_features() const { return X.extents(1); }
+    size_t n_bins() const { return nb; }
+    node root() const { return { 0, 0, n_samples() }; }
+    // the samples of the node, in the order of the partitions
+    array_view<const std::uint32_t> samples(const node& n) const
+    {
+        return array_view<const std::uint32_t>(rows.data() + n.begin, n.size(), 1);
+    }
+    const histogram_pool& histograms() const { return pool; }
+
+    // the per bin sums of feature j in the node's histogram
+    array_view<const double> gradient_histogram(const node& n, size_t j) const { return hist(n, 0, j); }
+    array_view<const double> hessian_histogram(const node& n, size_t j) const { return hist(n, 1, j); }
+    array_view<const double> count_histogram(const node& n, size_t j) const { return hist(n, 2, j); }
+
+    // g, h: the gradients and hessians of all samples
+    template <typename Executor = thread_pool>
+    void build_histogram(const node& n, const array_view<const double>& g, const array_view<const double>& h,
+        Executor& ex = par::default_executor())
+    {
+        assert(g.extents(0) == n_samples() && h.extents(0) == n_samples());
+        double* H = pool.acquire(n.id);
+        const size_t m = n.size();
+        const std::uint32_t* r = rows.data() + n.begin;
+        memory::vector<double> gn(m), hn(m);
+        for (size_t k = 0; k < m; ++k) {
+            gn[k] = g(r[k]);
+            hn[k] = h(r[k]);
+        }
+        const double one = 1;
+        const size_t fs = nb * n_features();
+        ex.parallel_for(n_features(), [&](size_t j) {
+            memory::vector<std::uint8_t> bins(m);
+            for (size_t k = 0; k < m; ++k) {
+                bins[k] = X(r[k], j);
+                assert(bins[k] < nb);
+            }
+            const std::ptrdiff_t e = (std::ptrdiff_t)m;
+            double* Hj = H + j * nb;
+            par::details::add_bincount(Hj, bins.data(), 1, gn.data(), 1, 0, e);
+            par::details::add_bincount(Hj + fs, bins.data(), 1, hn.data(), 1, 0, e);
+            par::details::add_bincount(Hj + 2 * fs, bins.data(), 1, &one, 0, 0, e);
+        });
+    }
+
+    // the split of the node with the largest gain, invalid if no split has
+    // a positive gain, the node must have a histogram
+    // Ties go to the lowest feature and the lowest threshold.
+    template <typename Executor = thread_pool>
+    split<std::uint8_t> find_split(const node& n, const split_options& opts = split_options(),
+        Executor& ex = par::default_executor()) const
+    {
+        const double* H = pool.find(n.id);
+        assert(H);
+        const size_t fs = nb * n_features();
+        if (n_features() == 0 || nb < 2)
+            return split<std::uint8_t>();
+        // the totals of the node, from feature 0
+        double G = 0, HS = 0;
+        for (size_t b = 0; b < nb; ++b) {
+            G += H[b];
+            HS += H[fs + b];
+        }
+        const double N = (double)n.size(), l2 = opts.l2_regularization;
+        if (!(HS + l2 > 0))
+            return split<std::uint8_t>();
+        const double parent = G * G / (HS + l2);
+        const double min_n = (double)std::max<size_t>(1, opts.min_samples_leaf), min_h = opts.min_hessian_leaf;
+
+        memory::vector<split<std::uint8_t> > best(n_features(), split<std::uint8_t>(),
+            memory::tracking_allocator<split<std::uint8_t> >("splitter"));
+        ex.parallel_for(n_features(), [&](size_t j) {
+            // left sums of the thresholds 0 .. nb - 2
+            const size_t t = nb - 1;
+            memory::vector<double> gl(t), hl(t), nl(t), gain(t);
+            std::partial_sum(H + j * nb, H + j * nb + t, gl.begin());
+            std::partial_sum(H + fs + j * nb, H + fs + j * nb + t, hl.begin());
+            std::partial_sum(H + 2 * fs + j * nb, H + 2 * fs + j * nb + t, nl.begin());
+            for (size_t b = 0; b < t; ++b) {
+                const double gr = G - gl[b], hr = HS - hl[b], nr = N - nl[b];
+                const double v = gl[b] * gl[b] / (hl[b] + l2) + gr * gr / (hr + l2) - parent;
+                const bool ok = nl[b] >= min_n && nr >= min_n && hl[b] >= min_h && hr >= min_h
+                    && hl[b] + l2 > 0 && hr + l2 > 0;
+                gain[b] = ok ? v : 0.0;
+            }
+            auto& s = best[j];
+            for (size_t b = 0; b < t; ++b)
+                if (gain[b] > s.gain) {
+                    s.feature = (std::int32_t)j;
+                    s.threshold = (std::uint8_t)b;
+                    s.gain = gain[b];
+                    s.n_left = (size_t)nl[b];
+                }
+        });
+        split<std::uint8_t> r;
+        for (auto& s : best)
+            if (s.gain > r.gain)
+                r = s;
+        return r;
+    }
+
+    // partitions the node by s (a split found for it) and builds the
+    // histograms of the children, the parent's histogram is used up
+    // Returns the left and right children.
+    template <typename Executor = thread_pool>
+    std::pair<node, node> apply_split(const node& n, const split<std::uint8_t>& s,
+        const array_view<const double>& g, const array_view<const double>& h,
+        Executor& ex = par::default_executor())
+    {
+        assert(s.is_valid() && pool.find(n.id));
+        const size_t f = (size_t)s.feature;
+        memory::vector<std::uint32_t> right(memory::tracking_allocator<std::uint32_t>("splitter"));
+        size_t l = n.begin;
+        for (size_t k = n.begin; k < n.end; ++k) {
+            const std::uint32_t i = rows[k];
+            if (X(i, f) > s.threshold)
+                right.push_back(i);
+            else
+                rows[l++] = i;
+        }
+        std::copy(right.begin(), right.end(), rows.begin() + l);
+        assert(l - n.begin == s.n_left);
+
+        const node left_child{ next_id, n.begin, l }, right_child{ next_id + 1, l, n.end };
+        next_id += 2;
+        const bool left_smaller = left_child.size() <= right_child.size();
+        const node& small = left_smaller ? left_child : right_child;
+        const node& large = left_smaller ? right_child : left_child;
+        build_histogram(small, g, h, ex);
+        pool.rekey(n.id, large.id);
+        double* L = pool.find(large.id);
+        const double* S = pool.find(small.id);
+        for (size_t k = 0, e = 3 * nb * n_features(); k < e; ++k)
+            L[k] -= S[k];
+        return { left_child, right_child };
+    }
+
+    // drops the histogram of the node
+    void release(const node& n) { pool.release(n.id); }
+
+private:
+    array_view<const double> hist(const node& n, size_t which, size_t j) const
+    {
+        const double* H = pool.find(n.id);
+        assert(H);
+        return array_view<const double>(H + (which * n_features() + j) * nb, nb, 1);
+    }
+
+    array_view<const std::uint8_t, 2> X;
+    size_t nb;
+    memory::vector<std::uint32_t> rows; // sample permutation, nodes are ranges of it
+    histogram_pool pool; // gradients, hessians, counts: n_features x n_bins each
+    size_t next_id = 1;
+};
+}
+
+#endif
@@ -0,0 +1,355 @@
+#ifndef INDEXING_INCLUDED_4410298374
+#define INDEXING_INCLUDED_4410298374
+
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+#include <iterator>
+
+#include "sx/array_view.h"
+#include "sx/multi_array.h"
+#include "sx/utility.h"
+
+// Indexing an array_view with an index array along one dimension
+// (numpy's fancy indexing, restricted to a single dimension)
+//
+//     auto Xs = sx::take(X, sample_indices);        // rows of X, materialized
+//     auto Xc = sx::take(X, feature_indices, 1);    // columns of X
+//     sx::put(Y, sample_indices, Xs);               // Y[sample_indices[i], :] = Xs[i, :]
+//
+//     auto v = sx::indexed(X, sample_indices);      // lazy, no copy
+//     v(2, 3) == X(sample_indices[2], 3)
+//
+// The indices can be std::vector<I> or array_view<I> (multi_array<I, 1>) of any
+// integral type.
+
+namespace sx {
+
+namespace details {
+    template <typename I>
+    array_view<const I> as_index_view(const array_view<I, 1>& x)
+    {
+        return x;
+    }
+    template <typename I>
+    array_view<const I> as_index_view(const std::vector<I>& x)
+    {
+        return make_array_view(x);
+    }
+
+    // finds out if the dimensions after `dim` can be traversed as a single
+    // strided dimension
+    template <typename T, rank_type Rank>
+    bool flatten_inner(const array_view<T, Rank>& x, rank_type dim, size_t& length, std::ptrdiff_t& stride)
+    {
+        length = 1;
+        stride = dim + 1 < Rank ? x.strides(Rank - 1) : 1;
+        for (rank_type k = dim + 1; k < Rank; ++k)
+            length *= x.extents(k);
+        for (rank_type k = dim + 1; k + 1 < Rank; ++k)
+            if (x.strides(k) != x.strides(k + 1) * (std::ptrdiff_t)x.extents(k + 1))
+                return false;
+        return true;
+    }
+
+    // increments the multi-index `o` over the dimensions [first, last)
+    template <rank_type Rank>
+    bool next_index_in(std::array<size_t, Rank>& o, const std::array<size_t, Rank>& e,
+        rank_type first, rank_type last)
+    {
+        for (rank_type k = last; k-- > first;) {
+            if (++o[k] != e[k])
+                return true;
+            o[k] = 0;
+        }
+        return false;
+    }
+
+    template <rank_type Rank>
+    std::ptrdiff_t offset_of(const std::array<size_t, Rank>& o, const std::array<std::ptrdiff_t, Rank>& strides)
+    {
+        std::ptrdiff_t s = 0;
+        for (rank_type k = 0; k < Rank; ++k)
+            s += (std::ptrdiff_t)o[k] * strides[k];
+        return s;
+    }
+
+    // copies from the `a` side to the `b` side or, if Scatter, the other way round
+    template <bool Scatter>
+    struct indexed_copy_dir {
+        template <typename A, typename B>
+        static void copy(A* a, B* b) { *b = *a; }
+    };
+    template <>
+    struct indexed_copy_dir<true> {
+        template <typename A, typename B>
+        static void copy(A* a, B* b) { *a = *b; }
+    };
+
+    // slices smaller than this (in bytes) are gathered in index order if the
+    // indices are unsorted and the indexed dimension doesn't fit in the cache
+    static const size_t kIndexSortMaxSliceBytes = 64;
+    static const size_t kIndexSortMinCount = 1 << 14;
+    static const size_t kIndexSortMinSpanBytes = 1 << 22;
+    // how many slices ahead to prefetch
+    static const size_t kIndexPrefetchDistance = 16;
+
+    // Scatter == false: b[.., i, ..] = a[.., idx[i], ..]
+    // Scatter == true:  a[.., idx[i], ..] = b[.., i, ..]
+    // where the indexed dimension is `dim`
+    template <bool Scatter, typename A, typename B, typename I, rank_type Rank>
+    void indexed_copy(const array_view<A, Rank>& a, const array_view<const I>& idx, rank_type dim,
+        const array_view<B, Rank>& b)
+    {
+        using dir = indexed_copy_dir<Scatter>;
+        const size_t n = idx.extents(0);
+        assert(dim < Rank && b.extents(dim) == n);
+        for (rank_type k = 0; k < Rank; ++k)
+            assert(k == dim || a.extents(k) == b.extents(k));
+        if (b.empty())
+            return;
+
+        const I* ip = idx.data();
+        const std::ptrdiff_t is = idx.strides(0);
+        auto ix = [ip, is](size_t i) { return (std::ptrdiff_t)ip[(std::ptrdiff_t)i * is]; };
+        for (size_t i = 0; i < n; ++i)
+            assert(0 <= ix(i) && (size_t)ix(i) < a.extents(dim));
+
+        const std::ptrdiff_t ad = a.strides(dim), bd = b.strides(dim);
+        size_t la, lb;
+        std::ptrdiff_t sa, sb;
+        const bool flat = flatten_inner(a, dim, la, sa) && flatten_inner(b, dim, lb, sb);
+
+        // gather/scatter in the order of the indices, packed as (index << 32 | position)
+        std::vector<std::uint64_t> order;
+        if (flat && n >= kIndexSortMinCount && la * sizeof(A) <= kIndexSortMaxSliceBytes
+            && a.extents(dim) * (size_t)std::abs(ad) * sizeof(A) >= kIndexSortMinSpanBytes
+            && n <= UINT32_MAX && a.extents(dim) <= UINT32_MAX) {
+            bool sorted = true;
+            for (size_t i = 1; sorted && i < n; ++i)
+                sorted = ix(i - 1) <= ix(i);
+            if (!sorted) {
+                order.resize(n);
+                for (size_t i = 0; i < n; ++i)
+                    order[i] = (std::uint64_t)ix(i) << 32 | i;
+                std::sort(order.begin(), order.end());
+            }
+        }
+
+        auto copy_slice = [&](A* pa, B* pb) {
+            for (size_t t = 0; t < la; ++t)
+                dir::copy(pa + (std::ptrdiff_t)t * sa, pb + (std::ptrdiff_t)t * sb);
+        };
+
+        std::array<size_t, Rank> o;
+        o.fill(0);
+        do {
+            A* ap = a.data() + offset_of<Rank>(o, a.strides());
+            B* bp = b.data() + offset_of<Rank>(o, b.strides());
+            if (!flat) {
+                for (size_t i = 0; i < n; ++i) {
+                    A* pa = ap + ix(i) * ad;
+                    B* pb = bp + (std::ptrdiff_t)i * bd;
+                    std::array<size_t, Rank> q;
+                    q.fill(0);
+                    do {
+                        dir::copy(pa + offset_of<Rank>(q, a.strides()), pb + offset_of<Rank>(q, b.strides()));
+                    } while (next_index_in<Rank>(q, a.extents(), dim + 1, Rank));
+                }
+            }
+            else if (!order.empty()) {
+                for (auto k : order)
+                    copy_slice(ap + (std::ptrdiff_t)(k >> 32) * ad, bp + (std::ptrdiff_t)(k & 0xffffffffu) * bd);
+            }
+            else if (la == 1) {
+                // single elements: unrolled, with the source of later iterations prefetched
+                size_t i = 0;
+                for (; i + kIndexPrefetchDistance + 4 <= n; i += 4) {
+                    SX_PREFETCH(ap + ix(i + kIndexPrefetchDistance) * ad);
+                    SX_PREFETCH(ap + ix(i + kIndexPrefetchDistance + 1) * ad);
+                    SX_PREFETCH(ap + ix(i + kIndexPrefetchDistance + 2) * ad);
+                    SX_PREFETCH(ap + ix(i + kIndexPrefetchDistance + 3) * ad);
+                    dir::copy(ap + ix(i) * ad, bp + (std::ptrdiff_t)i * bd);
+                    dir::copy(ap + ix(i + 1) * ad, bp + (std::ptrdiff_t)(i + 1) * bd);
+                    dir::copy(ap + ix(i + 2) * ad, bp + (std::ptrdiff_t)(i + 2) * bd);
+                    dir::copy(ap + ix(i + 3) * ad, bp + (std::ptrdiff_t)(i + 3) * bd);
+                }
+                for (; i < n; ++i)
+                    dir::copy(ap + ix(i) * ad, bp + (std::ptrdiff_t)i * bd);
+            }
+            else {
+                for (size_t i = 0; i < n; ++i) {
+                    if (i + kIndexPrefetchDistance < n)
+                        SX_PREFETCH(ap + ix(i + kIndexPrefetchDistance) * ad);
+                    A* pa = ap + ix(i) * ad;
+                    B* pb = bp + (std::ptrdiff_t)i * bd;
+                    if (sa == 1 && sb == 1) {
+                        if (Scatter)
+                            std::copy_n(pb, la, pa);
+                        else
+                            std::copy_n(pa, la, pb);
+                    }
+                    else
+                        copy_slice(pa, pb);
+                }
+            }
+        } while (next_index_in<Rank>(o, a.extents(), 0, dim));
+    }
+}
+
+// out[.., i, ..] = x[.., indices[i], ..] where `i` is along `dim`
+template <typename T, typename U, rank_type Rank, typename Indices,
+    typename = std::enable_if_t<!std::is_const<U>::value> >
+void take(const array_view<T, Rank>& x, const Indices& indices, rank_type dim,
+    const array_view<U, Rank>& out)
+{
+    details::indexed_copy<false>(x, details::as_index_view(indices), dim, out);
+}
+
+// returns the slices of `x` at `indices` along `dim`, like numpy.take
+template <typename T, rank_type Rank, typename Indices>
+multi_array<std::remove_const_t<T>, Rank> take(const array_view<T, Rank>& x, const Indices& indices,
+    rank_type dim = 0, array_layout_t layout = array_layout::c_order)
+{
+    auto idx = details::as_index_view(indices);
+    auto e = x.extents();
+    e[dim] = idx.extents(0);
+    multi_array<std::remove_const_t<T>, Rank> R(e, layout);
+    details::indexed_copy<false>(x, idx, dim, R.view());
+    return R;
+}
+
+// scatter, the inverse of take: dst[.., indices[i], ..] = src[.., i, ..]
+// with repeated indices the last one wins
+template <typename T, typename U, rank_type Rank, typename Indices,
+    typename = std::enable_if_t<!std::is_const<T>::value> >
+void put(const array_view<T, Rank>& dst, const Indices& indices, const array_view<U, Rank>& src,
+    rank_type dim = 0)
+{
+    details::indexed_copy<true>(dst, details::as_index_view(indices), dim, src);
+}
+
+// lazy view of `x` indexed by `indices` along `dim`
+// element access goes through the index array, take() it to materialize
+template <typename T, rank_type Rank, typename I>
+class indexed_view {
+public:
+    using rank_type = ::sx::rank_type;
+    using size_type = ::sx::size_t;
+    using indices_type = details::indices_template<Rank>;
+    using extents_type = details::extents_template<Rank>;
+    using value_type = std::remove_const_t<T>;
+    using pointer = T*;
+    using reference = T&;
+
+    indexed_view() = default;
+    indexed_view(const array_view<T, Rank>& x, const array_view<const I>& indices, rank_type dim = 0)
+        : x(x)
+        , idx(indices)
+        , d(dim)
+    {
+        assert(dim < Rank);
+    }
+
+    constexpr rank_type rank() const { return Rank; }
+    const array_view<T, Rank>& base() const { return x; }
+    const array_view<const I>& indices() const { return idx; }
+    rank_type dim() const { return d; }
+
+    extents_type extents() const
+    {
+        auto e = x.extents();
+        e[d] = idx.extents(0);
+        return e;
+    }
+    size_t extents(rank_type i) const { return i == d ? idx.extents(0) : x.extents(i); }
+    size_type size() const { return x.size() / std::max<size_t>(x.extents(d), 1) * idx.extents(0); }
+    bool empty() const { return x.empty() || idx.empty(); }
+
+    reference operator[](indices_type i) const
+    {
+        assert(i[d] < idx.extents(0));
+        i[d] = idx(i[d]);
+        return x[i];
+    }
+    reference operator()(size_t i) const
+    {
+        static_assert(Rank == 1, "operator() must be called with Rank number of arguments");
+        return x(idx(i));
+    }
+    reference operator()(size_t i, size_t j) const
+    {
+        static_assert(Rank == 2, "operator() must be called with Rank number of arguments");
+        return d == 0 ? x(idx(i), j) : x(i, idx(j));
+    }
+
+    multi_array<value_type, Rank> materialize(array_layout_t layout = array_layout::c_order) const
+    {
+        return take(x, idx, d, layout);
+    }
+
+    // traverses the elements in c_order
+    struct iterator
+        : public std::iterator<std::forward_iterator_tag, value_type, std::ptrdiff_t, pointer, reference> {
+        iterator() = default;
+        iterator(const indexed_view* v, const indices_type& i)
+            : v(v)
+            , i(i)
+        {
+        }
+        reference operator*() const { return (*v)[i]; }
+        pointer operator->() const { return &(*v)[i]; }
+        iterator& operator++()
+        {
+            for (rank_type k = Rank; k-- > 0;) {
+                if (++i[k] != v->extents(k) || k == 0)
+                    break;
+                i[k] = 0;
+            }
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator x(*this);
+            ++*this;
+            return x;
+        }
+        bool operator==(const iterator& x) const { return i == x.i; }
+        bool operator!=(const iterator& x) const { return i != x.i; }
+
+    private:
+        const indexed_view* v = nullptr;
+        indices_type i;
+    };
+
+    iterator begin() const
+    {
+        if (empty())
+            return end();
+        indices_type i;
+        i.fill(0);
+        return iterator(this, i);
+    }
+    iterator end() const
+    {
+        indices_type i;
+        i.fill(0);
+        i[0] = extents(0);
+        return iterator(this, i);
+    }
+
+private:
+    array_view<T, Rank> x;
+    array_view<const I> idx;
+    rank_type d = 0;
+};
+
+template <typename T, rank_type Rank, typename Indices>
+auto indexed(const array_view<T, Rank>& x, const Indices& indices, rank_type dim = 0)
+{
+    auto idx = details::as_index_view(indices);
+    return indexed_view<T, Rank, std::remove_const_t<typename decltype(idx)::value_type> >(x, idx, dim);
+}
+}
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef INSTRUMENT_INCLUDED_4418302957
+#define INSTRUMENT_INCLUDED_4418302957
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Opt-in counters in the hot entry points of sx
+//
+//     #define SX_INSTRUMENT 1 // or -DSX_INSTRUMENT=1, before including sx headers
+//     ...
+//     sx::instrument::write_text(std::cerr, sx::instrument::snapshot());
+//
+// Each instrumented kernel (sortperm, indmax_along, bincount, searchsorted,
+// operator<<=, multi_array allocation) counts its calls, the elements
+// processed, the bytes read and written, the wall time spent in it (including
+// nested kernels) and the number of calls per memory access path:
+//
+// - contiguous: the inner loops run on unit stride
+// - strided: the inner loops run on other strides
+// - fallback: the generic, iterator-based implementation
+//
+// Without SX_INSTRUMENT the hooks compile to nothing and their arguments are
+// not evaluated, snapshot() returns an empty list.
+
+#ifndef SX_INSTRUMENT
+#define SX_INSTRUMENT 0
+#endif
+
+namespace sx {
+namespace instrument {
+
+enum class path {
+    contiguous,
+    strided,
+    fallback
+};
+static const size_t kNumPaths = 3;
+
+struct kernel_stats {
+    std::string kernel;
+    std::uint64_t calls;
+    std::uint64_t elements;
+    std::uint64_t bytes;
+    std::uint64_t nanoseconds;
+    std::array<std::uint64_t, kNumPaths> paths; // calls per path, indexed by `path`
+};
+
+namespace details {
+    struct counters {
+        explicit counters(const char* kernel)
+            : kernel(kernel)
+        {
+            for (auto& p : paths)
+                p = 0;
+        }
+        const char* kernel;
+        std::atomic<std::uint64_t> calls{ 0 }, elements{ 0 }, bytes{ 0 }, nanoseconds{ 0 };
+        std::atomic<std::uint64_t> paths[kNumPaths];
+    };
+
+    struct registry {
+        std::mutex mutex;
+        std::deque<counters> kernels; // stable addresses
+    };
+
+    inline registry& the_registry()
+    {
+        static registry r;
+        return r;
+    }
+
+    // the counters of `kernel`, created on the first call
+    // called once per call site (it initializes a function-local static)
+    inline counters& counters_for(const char* kernel)
+    {
+        auto& r = the_registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& c : r.kernels)
+            if (std::strcmp(c.kernel, kernel) == 0)
+                return c;
+        r.kernels.emplace_back(kernel);
+        return r.kernels.back();
+    }
+
+    inline void count(counters& c, std::uint64_t elements, std::uint64_t bytes)
+    {
+        c.calls.fetch_add(1, std::memory_order_relaxed);
+        c.elements.fetch_add(elements, std::memory_order_relaxed);
+        c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    // counts a call and times it until the end of the scope
+    class scope {
+    public:
+        scope(counters& c, std::uint64_t elements, std::uint64_t bytes)
+            : c(c)
+            , start(clock::now())
+        {
+            count(c, elements, bytes);
+        }
+        ~scope()
+        {
+            const auto d = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+            c.nanoseconds.fetch_add((std::uint64_t)d.count(), std::memory_order_relaxed);
+        }
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+        void take(path p) { c.paths[(size_t)p].fetch_add(1, std::memory_order_relaxed); }
+
+    private:
+        using clock = std::chrono::steady_clock;
+        counters& c;
+        clock::time_point start;
+    };
+}
+
+// the counters of all kernels called so far, in order of their first call
+inline std::vector<kernel_stats> snapshot()
+{
+    auto& r = details::the_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::vector<kernel_stats> v;
+    v.reserve(r.kernels.size());
+    for (auto& c : r.kernels) {
+        kernel_stats s{ c.kernel, c.calls, c.elements, c.bytes, c.nanoseconds, {} };
+        for (size_t i = 0; i < kNumPaths; ++i)
+            s.paths[i] = c.paths[i];
+        v.push_back(s);
+    }
+    return v;
+}
+
+// zeroes all counters
+inline void reset()
+{
+    auto& r = details::the_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto& c : r.kernels) {
+        c.calls = c.elements = c.bytes = c.nanoseconds = 0;
+        for (auto& p : c.paths)
+            p = 0;
+    }
+}
+
+// one line per kernel:
+// <kernel> calls=.. elements=.. bytes=.. ms=.. contiguous=.. strided=.. fallback=..
+inline void write_text(std::ostream& os, const std::vector<kernel_stats>& stats)
+{
+    for (auto& s : stats)
+        os << s.kernel << " calls=" << s.calls << " elements=" << s.elements << " bytes=" << s.bytes
+           << " ms=" << s.nanoseconds * 1e-6 << " contiguous=" << s.paths[(size_t)path::contiguous]
+           << " strided=" << s.paths[(size_t)path::strided]
+           << " fallback=" << s.paths[(size_t)path::fallback] << "\n";
+}
+
+inline std::string to_text(const std::vector<kernel_stats>& stats)
+{
+    std::ostringstream os;
+    write_text(os, stats);
+    return os.str();
+}
+}
+}
+
+// SX_INSTRUMENT_SCOPE("kernel", elements, bytes): counts and times the rest of the scope
+// SX_INSTRUMENT_PATH(p): records the path taken in the current SX_INSTRUMENT_SCOPE
+// SX_INSTRUMENT_COUNT("kernel", elements, bytes): counts without timing
+#if SX_INSTRUMENT
+#define SX_INSTRUMENT_SCOPE(kernel, elements, bytes)                                          \
+    static ::sx::instrument::details::counters& sx_instrument_counters_                      \
+        = ::sx::instrument::details::counters_for(kernel);                                    \
+    ::sx::instrument::details::scope sx_instrument_scope_(sx_instrument_counters_, (elements), \
+        (bytes))
+#define SX_INSTRUMENT_PATH(p) sx_instrument_scope_.take(p)
+#define SX_INSTRUMENT_COUNT(kernel, elements, bytes)                                          \
+    do {                                                                                      \
+        static ::sx::instrument::details::counters& sx_instrument_counters_                  \
+            = ::sx::instrument::details::counters_for(kernel);                                \
+        ::sx::instrument::details::count(sx_instrument_counters_, (elements), (bytes));       \
+    } while (false)
+#else
+#define SX_INSTRUMENT_SCOPE(kernel, elements, bytes) ((void)0)
+#define SX_INSTRUMENT_PATH(p) ((void)0)
+#define SX_INSTRUMENT_COUNT(kernel, elements, bytes) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef MAPPED_FILE_INCLUDED_5203948123
+#define MAPPED_FILE_INCLUDED_5203948123
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sx {
+
+// read-only memory-mapped file
+// On Windows the file is read into memory instead of mapping.
+// Throws std::runtime_error if the file can't be opened or mapped.
+class mapped_file {
+public:
+    mapped_file() = default;
+    explicit mapped_file(const std::string& filename)
+    {
+        open(filename);
+    }
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& x) noexcept
+    {
+        swap(x);
+    }
+    mapped_file& operator=(mapped_file&& x) noexcept
+    {
+        mapped_file y(std::move(x));
+        swap(y);
+        return *this;
+    }
+    ~mapped_file()
+    {
+        close();
+    }
+
+    void open(const std::string& filename)
+    {
+        close();
+#ifdef _WIN32
+        std::ifstream f(filename, std::ios::binary | std::ios::ate);
+        if (!f)
+            throw std::runtime_error("can't open '" + filename + "'");
+        buf.resize((size_t)f.tellg());
+        f.seekg(0);
+        f.read(buf.data(), buf.size());
+        base = buf.data();
+        mapped_size = buf.size();
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("can't open '" + filename + "'");
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("can't stat '" + filename + "'");
+        }
+        mapped_size = (size_t)st.st_size;
+        if (mapped_size == 0) {
+            // mmap fails on empty files, represent them with a non-null empty range
+            ::close(fd);
+            base = "";
+            return;
+        }
+        void* p = ::mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            mapped_size = 0;
+            throw std::runtime_error("can't map '" + filename + "'");
+        }
+        base = static_cast<const char*>(p);
+#endif
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        buf.clear();
+#else
+        if (base && mapped_size > 0)
+            ::munmap(const_cast<char*>(base), mapped_size);
+#endif
+        base = nullptr;
+        mapped_size = 0;
+    }
+
+    bool is_open() const { return base != nullptr; }
+    const char* data() const { return base; }
+    size_t size() const { return mapped_size; }
+    const char* begin() const { return base; }
+    const char* end() const { return base + mapped_size; }
+
+    void swap(mapped_file& x) noexcept
+    {
+        using std::swap;
+        swap(base, x.base);
+        swap(mapped_size, x.mapped_size);
+#ifdef _WIN32
+        swap(buf, x.buf);
+#endif
+    }
+
+private:
+    const char* base = nullptr;
+    size_t mapped_size = 0;
+#ifdef _WIN32
+    std::vector<char> buf;
+#endif
+};
+}
+
+#endif
@@ -0,0 +1,307 @@
+#ifndef MEMORY_INCLUDED_5820316947
+#define MEMORY_INCLUDED_5820316947
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Allocation tracking and an optional memory budget
+//
+//     sx::memory::set_budget(size_t(8) << 30); // allocations over 8 GiB throw
+//     {
+//         sx::memory::site s("fit"); // attributes the allocations of this thread
+//         ...
+//     }
+//     sx::memory::write_text(std::cerr, sx::memory::snapshot());
+//
+// multi_array and the scratch buffers of the algorithms allocate through
+// tracking_allocator, which counts the allocations and the live bytes per
+// call site and in total. The site of an allocator is the innermost
+// `memory::site` of the thread when it's created, or the default given by
+// the container or the algorithm ("multi_array", "scratch", "sortperm"). The
+// algorithms don't open sites of their own, a caller's site sees all their
+// allocations.
+//
+// With a budget set, an allocation which would raise the live bytes above it
+// throws budget_exceeded (a std::bad_alloc) before asking for the memory.
+//
+// Results returned as std::vector (bincount, searchsorted) are checked against
+// the budget and counted but don't contribute to the live bytes since their
+// lifetime is the caller's.
+
+namespace sx {
+namespace memory {
+
+struct stats {
+    std::string site;
+    std::uint64_t count; // number of allocations
+    std::uint64_t total_bytes; // allocated since the last reset
+    std::uint64_t live_bytes; // allocated and not freed yet
+    std::uint64_t peak_bytes; // max of live_bytes since the last reset
+};
+
+class budget_exceeded : public std::bad_alloc {
+public:
+    budget_exceeded(const char* site, size_t bytes, size_t live, size_t budget)
+        : msg(std::string("sx: allocating ") + std::to_string(bytes) + " bytes at '" + site
+              + "' would exceed the memory budget (" + std::to_string(live) + " of "
+              + std::to_string(budget) + " bytes in use)")
+    {
+    }
+    const char* what() const noexcept override { return msg.c_str(); }
+
+private:
+    std::string msg;
+};
+
+namespace details {
+    struct counters {
+        explicit counters(const char* site)
+            : site(site)
+        {
+        }
+        const char* site;
+        std::atomic<std::uint64_t> count{ 0 }, total{ 0 }, live{ 0 }, peak{ 0 };
+
+        void add(size_t bytes)
+        {
+            count.fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(bytes, std::memory_order_relaxed);
+            raise_peak(live.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+        }
+        void raise_peak(std::uint64_t v)
+        {
+            auto p = peak.load(std::memory_order_relaxed);
+            while (p < v && !peak.compare_exchange_weak(p, v, std::memory_order_relaxed)) {
+            }
+        }
+    };
+
+    struct registry {
+        registry()
+            : all("all")
+        {
+        }
+        counters all;
+        std::atomic<size_t> budget{ std::numeric_limits<size_t>::max() };
+        std::mutex mutex;
+        std::deque<counters> sites; // stable addresses
+    };
+
+    inline registry& the_registry()
+    {
+        static registry r;
+        return r;
+    }
+
+    // the counters of `site`, created on the first call
+    inline counters& counters_for(const char* site)
+    {
+        // sites are string literals, mostly the same one again
+        static thread_local const char* last_site = nullptr;
+        static thread_local counters* last = nullptr;
+        if (site == last_site)
+            return *last;
+        auto& r = the_registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& c : r.sites)
+            if (std::strcmp(c.site, site) == 0) {
+                last_site = site;
+                return *(last = &c);
+            }
+        r.sites.emplace_back(site);
+        last_site = site;
+        return *(last = &r.sites.back());
+    }
+
+    // the innermost memory::site of this thread
+    inline counters*& current_site()
+    {
+        static thread_local counters* c = nullptr;
+        return c;
+    }
+
+    // budget check and accounting of a new allocation
+    inline void on_allocate(counters& c, size_t bytes)
+    {
+        auto& r = the_registry();
+        const size_t budget = r.budget.load(std::memory_order_relaxed);
+        const auto live = r.all.live.fetch_add(bytes, std::memory_order_relaxed);
+        if (budget != std::numeric_limits<size_t>::max() && (live + bytes > budget || live + bytes < live)) {
+            r.all.live.fetch_sub(bytes, std::memory_order_relaxed);
+            throw budget_exceeded(c.site, bytes, live, budget);
+        }
+        r.all.count.fetch_add(1, std::memory_order_relaxed);
+        r.all.total.fetch_add(bytes, std::memory_order_relaxed);
+        r.all.raise_peak(live + bytes);
+        c.add(bytes);
+    }
+    inline void on_deallocate(counters& c, size_t bytes)
+    {
+        the_registry().all.live.fetch_sub(bytes, std::memory_order_relaxed);
+        c.live.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    // an allocation handed over to the caller, checked and counted at the
+    // current site (or `default_site`), it's not live for the tracker
+    inline void on_untracked_allocate(const char* default_site, size_t bytes)
+    {
+        auto* s = current_site();
+        auto& c = s ? *s : counters_for(default_site);
+        on_allocate(c, bytes);
+        on_deallocate(c, bytes);
+    }
+}
+
+// limits the live bytes of all tracked allocations, 0: unlimited
+inline void set_budget(size_t bytes)
+{
+    details::the_registry().budget = bytes ? bytes : std::numeric_limits<size_t>::max();
+}
+// 0: unlimited
+inline size_t budget()
+{
+    const size_t b = details::the_registry().budget;
+    return b == std::numeric_limits<size_t>::max() ? 0 : b;
+}
+
+// attributes the tracked allocations made on this thread to `name` while it
+// exists, nested sites take precedence
+class site {
+public:
+    // `name` must outlive the tracker (a string literal)
+    explicit site(const char* name)
+        : prev(details::current_site())
+    {
+        details::current_site() = &details::counters_for(name);
+    }
+    ~site() { details::current_site() = prev; }
+    site(const site&) = delete;
+    site& operator=(const site&) = delete;
+
+private:
+    details::counters* prev;
+};
+
+template <typename T>
+class tracking_allocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    tracking_allocator()
+        : tracking_allocator("scratch")
+    {
+    }
+    // the current site of the thread or `default_site`
+    explicit tracking_allocator(const char* default_site)
+        : c(details::current_site() ? details::current_site() : &details::counters_for(default_site))
+    {
+    }
+    template <typename U>
+    tracking_allocator(const tracking_allocator<U>& x) noexcept
+        : c(x.c)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+            throw std::bad_alloc();
+        details::on_allocate(*c, n * sizeof(T));
+        try {
+            return std::allocator<T>().allocate(n);
+        }
+        catch (...) {
+            details::on_deallocate(*c, n * sizeof(T));
+            throw;
+        }
+    }
+    void deallocate(T* p, size_t n) noexcept
+    {
+        std::allocator<T>().deallocate(p, n);
+        details::on_deallocate(*c, n * sizeof(T));
+    }
+
+    // copies of containers are attributed to the current site, if any
+    tracking_allocator select_on_container_copy_construction() const
+    {
+        return tracking_allocator(details::current_site() ? details::current_site() : c);
+    }
+
+    template <typename U>
+    bool operator==(const tracking_allocator<U>& x) const noexcept { return c == x.c; }
+    template <typename U>
+    bool operator!=(const tracking_allocator<U>& x) const noexcept { return c != x.c; }
+
+private:
+    template <typename U>
+    friend class tracking_allocator;
+
+    explicit tracking_allocator(details::counters* c)
+        : c(c)
+    {
+    }
+
+    details::counters* c;
+};
+
+// a std::vector with tracked allocations, for scratch buffers
+template <typename T>
+using vector = std::vector<T, tracking_allocator<T> >;
+
+// the counters of all tracked allocations
+inline stats totals()
+{
+    auto& c = details::the_registry().all;
+    return { c.site, c.count, c.total, c.live, c.peak };
+}
+
+// the counters per site, in order of their first allocation
+inline std::vector<stats> snapshot()
+{
+    auto& r = details::the_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::vector<stats> v;
+    v.reserve(r.sites.size());
+    for (auto& c : r.sites)
+        v.push_back({ c.site, c.count, c.total, c.live, c.peak });
+    return v;
+}
+
+// zeroes the counts and totals, the peaks restart from the live bytes
+inline void reset()
+{
+    auto& r = details::the_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto reset_one = [](details::counters& c) {
+        c.count = 0;
+        c.total = 0;
+        c.peak = c.live.load();
+    };
+    reset_one(r.all);
+    for (auto& c : r.sites)
+        reset_one(c);
+}
+
+// one line per site:
+// <site> count=.. total_bytes=.. live_bytes=.. peak_bytes=..
+inline void write_text(std::ostream& os, const std::vector<stats>& v)
+{
+    for (auto& s : v)
+        os << s.site << " count=" << s.count << " total_bytes=" << s.total_bytes
+           << " live_bytes=" << s.live_bytes << " peak_bytes=" << s.peak_bytes << "\n";
+}
+}
+}
+
+#endif
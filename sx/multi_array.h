@@ -6,6 +6,7 @@
 
 #include <cassert>
 #include "sx/array_view.h"
+#include "sx/memory.h"
 
 //todo const indices& or by value, is there a difference? 0 or 1
 #define SX_MULTI_ARRAY_PASS_INDICES_BY_VALUE 0
@@ -13,10 +14,10 @@
 namespace sx {
 
 template <typename T, typename U, rank_type Rank>
-constexpr size_type linear_index(details::array_par<T, Rank> x, details::array_par<U, Rank> strides)
+constexpr size_t linear_index(array_par<T, Rank> x, array_par<U, Rank> strides)
 {
-    size_type s = 0;
-    for (int i = 0; i < Rank; ++i)
+    size_t s = 0;
+    for (rank_type i = 0; i < Rank; ++i)
         s += x[i] * strides[i];
     return s;
 }
@@ -24,7 +25,9 @@ constexpr size_type linear_index(details::array_par<T, Rank> x, details::array_p
 template <typename T, rank_type Rank>
 class multi_array : public array_view<T, Rank> {
 private:
-    std::vector<T> d;
+    memory::vector<T> d = memory::vector<T>(allocator());
+
+    static memory::tracking_allocator<T> allocator() { return memory::tracking_allocator<T>("multi_array"); }
 
 protected:
     using base_type = array_view<T, Rank>;
@@ -43,7 +46,13 @@ public:
     using const_reference = const T&;
 
     multi_array() = default;
-    multi_array(const multi_array& x) = default;
+    multi_array(const multi_array& x)
+        : base_type(x)
+        , d(x.d)
+    {
+        SX_INSTRUMENT_COUNT("multi_array allocation", d.size(), d.size() * sizeof(T));
+        update_base();
+    }
     multi_array(multi_array&& x)
         : base_type(x.d.data(), x.extents(), x.strides())
         , d(std::move(x.d))
@@ -52,19 +61,27 @@ public:
     }
     explicit multi_array(const extents_type& e, const T& value = T())
         : base_type(nullptr, e, array_layout::c_order)
-        , d(linear_index(e, base_type::srd), value)
+        , d(base_type::size(), value, allocator())
     {
+        SX_INSTRUMENT_COUNT("multi_array allocation", d.size(), d.size() * sizeof(T));
         update_base();
     }
     explicit multi_array(const extents_type& e, array_layout_t layout, const T& value = T())
         : base_type(nullptr, e, layout)
-        , d(linear_index(e, base_type::srd), value)
+        , d(base_type::size(), value, allocator())
     {
+        SX_INSTRUMENT_COUNT("multi_array allocation", d.size(), d.size() * sizeof(T));
         update_base();
     }
     template <typename U>
     multi_array& operator=(const array_view<U, Rank>& x); //todo
-    multi_array& operator=(multi_array&& x); //todo
+    multi_array& operator=(multi_array&& x)
+    {
+        base_type::operator=(static_cast<const base_type&>(x));
+        d = std::move(x.d);
+        update_base();
+        return *this;
+    }
 
     constexpr operator const array_view<T, Rank>&()
     {
@@ -89,18 +106,40 @@ public:
 
 #if SX_MULTI_ARRAY_PASS_INDICES_BY_VALUE
     //todo op[](size_type ) if rank = 1
-    T& operator[](const indices_type& offset);
-    const T& operator[](const indices_type& offset) const;
+    T& operator[](indices_type offset)
+    {
+        return view()[offset];
+    }
+    const T& operator[](indices_type offset) const
+    {
+        return view()[offset];
+    }
 #else
-    T& operator[](indices_type offset);
-    const T& operator[](indices_type offset) const;
+    T& operator[](const indices_type& offset)
+    {
+        return view()[offset];
+    }
+    const T& operator[](const indices_type& offset) const
+    {
+        return view()[offset];
+    }
 #endif
 
-    //todo: probably this could be solved in a general way with some metaprogramming
-    //with variadic templates
-    //however I'm not sure a variadic template could handle
-    //the case where slice_bounds is initialized with {x, y} which has no
-    //type on its own
+    // element access and slicing, see array_view::operator()
+    template <typename... Args,
+        typename = std::enable_if_t<(Rank > 2) && sizeof...(Args) == Rank
+            && details::are_subscripts<Args...>::value> >
+    constexpr details::subscript_result_t<const T, Args...> operator()(Args... args) const noexcept
+    {
+        return view()(args...);
+    }
+    template <typename... Args,
+        typename = std::enable_if_t<(Rank > 2) && sizeof...(Args) == Rank
+            && details::are_subscripts<Args...>::value> >
+    constexpr details::subscript_result_t<T, Args...> operator()(Args... args) noexcept
+    {
+        return view()(args...);
+    }
     constexpr const_reference operator()(size_t x) const noexcept
     {
         return view()(x);
@@ -0,0 +1,474 @@
+#ifndef NPY_INCLUDED_8120394712
+#define NPY_INCLUDED_8120394712
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "sx/array_view.h"
+#include "sx/multi_array.h"
+#include "sx/mapped_file.h"
+
+// Reading and writing NumPy's .npy format
+// (https://docs.scipy.org/doc/numpy/neps/npy-format.html)
+//
+// The header of an .npy file maps directly onto array_view:
+//
+//     'descr'         -> element type, see npy_dtype<T>
+//     'shape'         -> extents
+//     'fortran_order' -> array_layout::c_order or array_layout::fortran_order
+//
+// Writing streams from any (strided) array_view:
+//
+//     sx::save_npy("X.npy", X);
+//
+// Reading maps the file into memory and returns a view on the mapped data,
+// no copy is made, pages are loaded as they are touched:
+//
+//     sx::mapped_npy f("X.npy");
+//     auto X = f.view<float, 2>(); // array_view<const float, 2>, valid while `f` lives
+//
+// or, when an owning copy is needed:
+//
+//     auto X = sx::load_npy<float, 2>("X.npy"); // multi_array<float, 2>
+//
+// Only native (little-endian) byte order is supported for mapping.
+
+namespace sx {
+
+struct npy_error : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// npy_dtype<T>::descr() returns the numpy type descriptor string of T
+template <typename T>
+struct npy_dtype;
+
+namespace details {
+    template <char Kind, typename T>
+    struct npy_dtype_base {
+        static std::string descr()
+        {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "%c%c%d",
+                sizeof(T) == 1 ? '|' : '<', Kind, (int)sizeof(T));
+            return buf;
+        }
+    };
+
+    inline bool is_little_endian_host()
+    {
+        const std::uint16_t x = 1;
+        unsigned char c;
+        std::memcpy(&c, &x, 1);
+        return c == 1;
+    }
+}
+
+template <>
+struct npy_dtype<bool> : details::npy_dtype_base<'b', bool> {
+};
+template <>
+struct npy_dtype<float> : details::npy_dtype_base<'f', float> {
+};
+template <>
+struct npy_dtype<double> : details::npy_dtype_base<'f', double> {
+};
+template <>
+struct npy_dtype<std::int8_t> : details::npy_dtype_base<'i', std::int8_t> {
+};
+template <>
+struct npy_dtype<std::int16_t> : details::npy_dtype_base<'i', std::int16_t> {
+};
+template <>
+struct npy_dtype<std::int32_t> : details::npy_dtype_base<'i', std::int32_t> {
+};
+template <>
+struct npy_dtype<std::int64_t> : details::npy_dtype_base<'i', std::int64_t> {
+};
+template <>
+struct npy_dtype<std::uint8_t> : details::npy_dtype_base<'u', std::uint8_t> {
+};
+template <>
+struct npy_dtype<std::uint16_t> : details::npy_dtype_base<'u', std::uint16_t> {
+};
+template <>
+struct npy_dtype<std::uint32_t> : details::npy_dtype_base<'u', std::uint32_t> {
+};
+template <>
+struct npy_dtype<std::uint64_t> : details::npy_dtype_base<'u', std::uint64_t> {
+};
+
+// the parsed header of an .npy file
+struct npy_header {
+    std::string descr;
+    bool fortran_order = false;
+    std::vector<size_t> shape;
+    size_t data_offset = 0; // offset of the first element from the beginning of the file
+
+    array_layout_t layout() const
+    {
+        return fortran_order ? array_layout::fortran_order : array_layout::c_order;
+    }
+    size_t size() const
+    {
+        size_t s = 1;
+        for (auto e : shape)
+            s *= e;
+        return s;
+    }
+};
+
+namespace details {
+    static constexpr char npy_magic[] = "\x93NUMPY";
+    static constexpr size_t npy_magic_size = 6;
+    static constexpr size_t npy_header_alignment = 64;
+
+    inline void npy_skip_space(const char*& p, const char* e)
+    {
+        while (p != e && (*p == ' ' || *p == '\t' || *p == '\n' || *p == ','))
+            ++p;
+    }
+
+    inline void npy_expect(const char*& p, const char* e, char c)
+    {
+        npy_skip_space(p, e);
+        if (p == e || *p != c)
+            throw npy_error(std::string("npy: malformed header, expected '") + c + "'");
+        ++p;
+    }
+
+    inline std::string npy_parse_quoted(const char*& p, const char* e)
+    {
+        npy_skip_space(p, e);
+        if (p == e || (*p != '\'' && *p != '"'))
+            throw npy_error("npy: malformed header, expected string");
+        const char q = *p++;
+        auto b = p;
+        while (p != e && *p != q)
+            ++p;
+        if (p == e)
+            throw npy_error("npy: malformed header, unterminated string");
+        return std::string(b, p++);
+    }
+
+    // parses the python dict literal of the header
+    inline void npy_parse_dict(const char* p, const char* e, npy_header& h)
+    {
+        bool has_descr = false, has_order = false, has_shape = false;
+        npy_expect(p, e, '{');
+        for (;;) {
+            npy_skip_space(p, e);
+            if (p != e && *p == '}')
+                break;
+            auto key = npy_parse_quoted(p, e);
+            npy_expect(p, e, ':');
+            npy_skip_space(p, e);
+            if (key == "descr") {
+                h.descr = npy_parse_quoted(p, e);
+                has_descr = true;
+            }
+            else if (key == "fortran_order") {
+                if (e - p >= 4 && std::strncmp(p, "True", 4) == 0) {
+                    h.fortran_order = true;
+                    p += 4;
+                }
+                else if (e - p >= 5 && std::strncmp(p, "False", 5) == 0) {
+                    h.fortran_order = false;
+                    p += 5;
+                }
+                else
+                    throw npy_error("npy: malformed header, bad 'fortran_order'");
+                has_order = true;
+            }
+            else if (key == "shape") {
+                npy_expect(p, e, '(');
+                h.shape.clear();
+                for (;;) {
+                    npy_skip_space(p, e);
+                    if (p != e && *p == ')')
+                        break;
+                    if (p == e || *p < '0' || *p > '9')
+                        throw npy_error("npy: malformed header, bad 'shape'");
+                    size_t v = 0;
+                    for (; p != e && '0' <= *p && *p <= '9'; ++p) {
+                        const size_t d = (size_t)(*p - '0');
+                        if (v > (std::numeric_limits<size_t>::max() - d) / 10)
+                            throw npy_error("npy: malformed header, 'shape' too large");
+                        v = v * 10 + d;
+                    }
+                    h.shape.push_back(v);
+                }
+                ++p;
+                has_shape = true;
+            }
+            else
+                throw npy_error("npy: unknown header key '" + key + "'");
+        }
+        if (!has_descr || !has_order || !has_shape)
+            throw npy_error("npy: incomplete header");
+        // the strides are products of the extents too, zeros don't help
+        size_t n = 1;
+        for (auto x : h.shape)
+            if (x != 0 && n > std::numeric_limits<size_t>::max() / x)
+                throw npy_error("npy: malformed header, 'shape' too large");
+            else if (x != 0)
+                n *= x;
+    }
+
+    inline std::string npy_shape_str(const size_t* shape, size_t rank)
+    {
+        std::string s = "(";
+        for (size_t i = 0; i < rank; ++i) {
+            s += std::to_string(shape[i]);
+            if (rank == 1 || i + 1 < rank)
+                s += ",";
+            if (i + 1 < rank)
+                s += " ";
+        }
+        return s + ")";
+    }
+}
+
+// parses the header from the beginning of an .npy file
+// `size` can be larger than the header
+inline npy_header parse_npy_header(const char* data, size_t size)
+{
+    using namespace details;
+    if (size < npy_magic_size + 4 || std::memcmp(data, npy_magic, npy_magic_size) != 0)
+        throw npy_error("npy: not an .npy file");
+    const unsigned major = (unsigned char)data[npy_magic_size];
+    size_t len_size;
+    if (major == 1)
+        len_size = 2;
+    else if (major == 2 || major == 3)
+        len_size = 4;
+    else
+        throw npy_error("npy: unsupported format version " + std::to_string(major));
+    const size_t prefix = npy_magic_size + 2 + len_size;
+    if (size < prefix)
+        throw npy_error("npy: truncated header");
+    size_t header_len = 0;
+    for (size_t i = len_size; i-- > 0;)
+        header_len = (header_len << 8) | (unsigned char)data[npy_magic_size + 2 + i];
+    if (size < prefix + header_len)
+        throw npy_error("npy: truncated header");
+
+    npy_header h;
+    npy_parse_dict(data + prefix, data + prefix + header_len, h);
+    h.data_offset = prefix + header_len;
+    return h;
+}
+
+// returns the complete header (magic, version, length, dict) of an .npy file,
+// padded so that the data which follows is aligned to 64 bytes
+inline std::string format_npy_header(const std::string& descr, bool fortran_order,
+    const size_t* shape, size_t rank)
+{
+    using namespace details;
+    std::string dict = "{'descr': '" + descr + "', 'fortran_order': "
+        + (fortran_order ? "True" : "False") + ", 'shape': "
+        + npy_shape_str(shape, rank) + ", }";
+
+    // version 1.0 stores the header length in 2 bytes, 2.0 in 4 bytes
+    size_t len_size = 2;
+    char major = 1;
+    if (npy_magic_size + 4 + dict.size() + 1 > 65535) {
+        len_size = 4;
+        major = 2;
+    }
+    const size_t prefix = npy_magic_size + 2 + len_size;
+    const size_t total = (prefix + dict.size() + 1 + npy_header_alignment - 1)
+        / npy_header_alignment * npy_header_alignment;
+    dict.append(total - prefix - dict.size() - 1, ' ');
+    dict += '\n';
+
+    std::string r(npy_magic, npy_magic_size);
+    r += major;
+    r += '\0';
+    size_t header_len = dict.size();
+    for (size_t i = 0; i < len_size; ++i, header_len >>= 8)
+        r += (char)(header_len & 0xff);
+    return r + dict;
+}
+
+namespace details {
+    // calls f(pointer, count) for consecutive memory runs of `x` visited in the
+    // order of `layout` (runs are a single element if the innermost stride is not 1)
+    template <typename T, rank_type Rank, typename F>
+    void for_each_run_in_layout(const array_view<T, Rank>& x, array_layout_t layout, F&& f)
+    {
+        if (x.empty())
+            return;
+        std::array<rank_type, Rank> order; // order[0] is the innermost dimension
+        for (rank_type i = 0; i < Rank; ++i)
+            order[i] = layout == array_layout::c_order ? Rank - 1 - i : i;
+        const auto inner = order[0];
+        const size_t n = x.extents(inner);
+        const bool unit = x.strides(inner) == 1;
+        std::array<size_t, Rank> idx;
+        idx.fill(0);
+        for (;;) {
+            auto p = &x[idx];
+            if (unit)
+                f(p, n);
+            else
+                for (size_t i = 0; i < n; ++i)
+                    f(p + (std::ptrdiff_t)i * x.strides(inner), 1);
+            rank_type k = 1;
+            for (; k < Rank; ++k) {
+                auto d = order[k];
+                if (++idx[d] != x.extents(d))
+                    break;
+                idx[d] = 0;
+            }
+            if (k == Rank)
+                break;
+        }
+    }
+
+    template <typename T, rank_type Rank>
+    bool is_contiguous_in_layout(const array_view<T, Rank>& x, array_layout_t layout)
+    {
+        std::ptrdiff_t s = 1;
+        for (rank_type i = 0; i < Rank; ++i) {
+            auto d = layout == array_layout::c_order ? Rank - 1 - i : i;
+            if (x.extents(d) != 1 && x.strides(d) != s)
+                return false;
+            s *= (std::ptrdiff_t)x.extents(d);
+        }
+        return true;
+    }
+}
+
+// writes `x` in .npy format
+// contiguous views are written with a single write, fortran-contiguous views
+// are written with 'fortran_order': True, any other views are streamed
+// in c_order through a small buffer
+template <typename T, rank_type Rank>
+void save_npy(std::ostream& os, const array_view<T, Rank>& x)
+{
+    using V = std::remove_const_t<T>;
+    if (!details::is_little_endian_host())
+        throw npy_error("npy: big-endian hosts are not supported");
+
+    const bool fortran = !details::is_contiguous_in_layout(x, array_layout::c_order)
+        && details::is_contiguous_in_layout(x, array_layout::fortran_order);
+    const auto layout = fortran ? array_layout::fortran_order : array_layout::c_order;
+    os << format_npy_header(npy_dtype<V>::descr(), fortran, x.extents().data(), Rank);
+
+    if (details::is_contiguous_in_layout(x, layout)) {
+        os.write(reinterpret_cast<const char*>(x.data()), x.size() * sizeof(V));
+    }
+    else {
+        const size_t kBufsize = 65536 / sizeof(V) + 1;
+        std::vector<V> buf;
+        buf.reserve(kBufsize);
+        details::for_each_run_in_layout(x, layout, [&](const V* p, size_t n) {
+            if (buf.size() + n > kBufsize) {
+                os.write(reinterpret_cast<const char*>(buf.data()), buf.size() * sizeof(V));
+                buf.clear();
+            }
+            if (n >= kBufsize)
+                os.write(reinterpret_cast<const char*>(p), n * sizeof(V));
+            else
+                buf.insert(buf.end(), p, p + n);
+        });
+        os.write(reinterpret_cast<const char*>(buf.data()), buf.size() * sizeof(V));
+    }
+    if (!os)
+        throw npy_error("npy: write failed");
+}
+
+template <typename T, rank_type Rank>
+void save_npy(const std::string& filename, const array_view<T, Rank>& x)
+{
+    std::ofstream f(filename, std::ios::binary);
+    if (!f)
+        throw npy_error("npy: can't open '" + filename + "' for writing");
+    save_npy(f, x);
+}
+
+// memory-mapped .npy file
+// the views returned by view() are valid as long as the mapped_npy object lives
+class mapped_npy {
+public:
+    mapped_npy() = default;
+    explicit mapped_npy(const std::string& filename)
+    {
+        open(filename);
+    }
+
+    void open(const std::string& filename)
+    {
+        close();
+        try {
+            file.open(filename);
+            hdr = parse_npy_header(file.data(), file.size());
+        }
+        catch (const npy_error&) {
+            close();
+            throw;
+        }
+        catch (const std::runtime_error& e) {
+            close();
+            throw npy_error(std::string("npy: ") + e.what());
+        }
+    }
+
+    void close()
+    {
+        file.close();
+        hdr = npy_header();
+    }
+
+    bool is_open() const { return file.is_open(); }
+    const npy_header& header() const { return hdr; }
+
+    // returns a zero-copy view of the data
+    // throws if T or Rank don't match the file
+    template <typename T, rank_type Rank>
+    array_view<const T, Rank> view() const
+    {
+        if (!is_open())
+            throw npy_error("npy: no file is open");
+        if (hdr.descr != npy_dtype<T>::descr() || !details::is_little_endian_host())
+            throw npy_error("npy: dtype mismatch, file has '" + hdr.descr
+                + "', requested '" + npy_dtype<T>::descr() + "'");
+        if (hdr.shape.size() != Rank)
+            throw npy_error("npy: rank mismatch");
+        // parse_npy_header checked data_offset <= file.size() and that size() fits
+        if (hdr.size() > (file.size() - hdr.data_offset) / sizeof(T))
+            throw npy_error("npy: truncated file");
+        auto p = file.data() + hdr.data_offset;
+        if (reinterpret_cast<std::uintptr_t>(p) % alignof(T) != 0)
+            throw npy_error("npy: misaligned data");
+        details::extents_template<Rank> e;
+        std::copy_n(hdr.shape.begin(), Rank, e.begin());
+        return array_view<const T, Rank>(reinterpret_cast<const T*>(p), e, hdr.layout());
+    }
+
+private:
+    mapped_file file;
+    npy_header hdr;
+};
+
+// reads an .npy file into a multi_array of the same layout
+template <typename T, rank_type Rank>
+multi_array<T, Rank> load_npy(const std::string& filename)
+{
+    mapped_npy f(filename);
+    auto v = f.view<T, Rank>();
+    multi_array<T, Rank> r(v.extents(), f.header().layout());
+    std::copy_n(v.data(), v.size(), r.data());
+    return r;
+}
+}
+
+#endif
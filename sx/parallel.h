@@ -0,0 +1,291 @@
+#ifndef PARALLEL_INCLUDED_7730291845
+#define PARALLEL_INCLUDED_7730291845
+
+#include <atomic>
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include "sx/array_view.h"
+#include "sx/elementwise.h"
+#include "sx/thread_pool.h"
+
+// Parallel element-wise algorithms over array_views
+//
+//     sx::par::transform(X, X, sx::broadcast_to(mean, X.extents()), std::minus<>());
+//     sx::par::fill(Y, 0.0f);
+//     sx::par::copy(Y, X);
+//     sx::par::for_each(X, [](float& x) { x = std::sqrt(x); });
+//
+// The elements are taken in the loop-nest order of the (destination) view:
+// dimensions by decreasing |stride|, the smallest stride innermost. This order
+// is cut into chunks of about `options::grain_bytes`, rounded to whole runs of
+// the innermost dimension when a run is shorter than a chunk. Each chunk is
+// processed like the sequential kernels do, with the same contiguous inner
+// loops.
+//
+// By default the chunks get smaller for small arrays so all threads have
+// work. With `options::deterministic` the chunk boundaries depend only on the
+// shape and the grain size, never on the number of threads.
+//
+// The executor is the last, optional argument, sx::default_thread_pool() by
+// default. It's anything with
+//
+//     size_t concurrency() const;
+//     template <typename F> void parallel_for(size_t n, F&& f); // f(0) .. f(n - 1)
+//
+// `f` is called concurrently from several threads.
+
+namespace sx {
+namespace par {
+
+// runs the tasks on threads started for each parallel_for call,
+// the tasks are claimed one by one so slow tasks don't hold up the rest
+class thread_executor {
+public:
+    // 0: std::thread::hardware_concurrency()
+    explicit thread_executor(size_t n_threads = 0)
+        : n_threads(n_threads ? n_threads : std::max(1u, std::thread::hardware_concurrency()))
+    {
+    }
+
+    size_t concurrency() const { return n_threads; }
+
+    // calls f(0), ..., f(n - 1), rethrows the first exception
+    template <typename F>
+    void parallel_for(size_t n, F&& f) const
+    {
+        const size_t p = std::min(n, n_threads);
+        if (p <= 1) {
+            for (size_t i = 0; i < n; ++i)
+                f(i);
+            return;
+        }
+        std::atomic<size_t> next(0);
+        std::vector<std::exception_ptr> errors(p);
+        auto work = [&](size_t t) {
+            try {
+                for (size_t i; (i = next++) < n;)
+                    f(i);
+            }
+            catch (...) {
+                errors[t] = std::current_exception();
+                next = n;
+            }
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(p - 1);
+        for (size_t t = 1; t < p; ++t)
+            threads.emplace_back(work, t);
+        work(0);
+        for (auto& t : threads)
+            t.join();
+        for (auto& x : errors)
+            if (x)
+                std::rethrow_exception(x);
+    }
+
+private:
+    size_t n_threads;
+};
+
+// runs the tasks in order on the calling thread
+class sequential_executor {
+public:
+    size_t concurrency() const { return 1; }
+
+    template <typename F>
+    void parallel_for(size_t n, F&& f) const
+    {
+        for (size_t i = 0; i < n; ++i)
+            f(i);
+    }
+};
+
+inline thread_pool& default_executor()
+{
+    return default_thread_pool();
+}
+
+struct options {
+    // target size of a chunk, in bytes of the (destination) elements
+    size_t grain_bytes = 1 << 16;
+    // chunk boundaries independent of the number of threads
+    bool deterministic = false;
+};
+
+namespace details {
+    using namespace ::sx::details;
+
+    // chunks won't be smaller than this (in elements) to make room for threads
+    static const size_t kMinChunkLength = 1 << 12;
+    // chunks per thread when the array is too small for grain-sized chunks
+    static const size_t kChunksPerThread = 4;
+
+    inline size_t chunk_length(size_t n, size_t run, size_t elem_size, size_t concurrency,
+        const options& o)
+    {
+        size_t c = std::max<size_t>(1, o.grain_bytes / elem_size);
+        if (!o.deterministic && concurrency > 1) {
+            const size_t k = kChunksPerThread * concurrency;
+            c = std::min(c, std::max(kMinChunkLength, (n + k - 1) / k));
+        }
+        if (run < c)
+            c = c / run * run;
+        return c;
+    }
+
+    template <rank_type Rank, typename... V>
+    std::tuple<decltype(std::declval<V>().data())...> pointers_at(
+        const std::array<size_t, Rank>& idx, const V&... v)
+    {
+        auto p = std::make_tuple(v.data()...);
+        for (rank_type d = 0; d < Rank; ++d)
+            advance_pointers(p, d, (std::ptrdiff_t)idx[d], std::index_sequence_for<V...>(), v...);
+        return p;
+    }
+
+    // like for_each_run but only for the elements [first, last) of the loop nest
+    template <rank_type Rank, typename F, typename... V>
+    void for_each_run_in(const std::array<size_t, Rank>& e, const std::array<rank_type, Rank>& order,
+        size_t first, size_t last, F&& f, const V&... v)
+    {
+        if (first >= last)
+            return;
+        std::array<size_t, Rank> idx;
+        size_t q = first;
+        for (rank_type k = Rank; k-- > 0;) {
+            const rank_type d = order[k];
+            idx[d] = q % e[d];
+            q /= e[d];
+        }
+        auto p = pointers_at<Rank>(idx, v...);
+        const auto seq = std::index_sequence_for<V...>();
+        const rank_type inner = order[Rank - 1];
+        for (size_t pos = first;;) {
+            const size_t len = std::min(e[inner] - idx[inner], last - pos);
+            call_on_run(f, len, p, inner, seq, v...);
+            pos += len;
+            if (pos == last)
+                return;
+            advance_pointers(p, inner, -(std::ptrdiff_t)idx[inner], seq, v...);
+            idx[inner] = 0;
+            for (int k = (int)Rank - 2; k >= 0; --k) {
+                const rank_type d = order[k];
+                if (++idx[d] < e[d]) {
+                    advance_pointers(p, d, 1, seq, v...);
+                    break;
+                }
+                advance_pointers(p, d, -(std::ptrdiff_t)(e[d] - 1), seq, v...);
+                idx[d] = 0;
+            }
+        }
+    }
+
+    // splits the loop nest of `order` into chunks and runs `kernel` on them
+    template <typename Executor, rank_type Rank, typename Kernel, typename... V>
+    void parallel_runs(Executor& ex, const options& opts, size_t elem_size,
+        const std::array<size_t, Rank>& e, const std::array<rank_type, Rank>& order,
+        const Kernel& kernel, const V&... v)
+    {
+        size_t n = 1;
+        for (auto x : e)
+            n *= x;
+        if (n == 0)
+            return;
+        const size_t c = chunk_length(n, e[order[Rank - 1]], elem_size, ex.concurrency(), opts);
+        const size_t m = (n + c - 1) / c;
+        if (m == 1) {
+            for_each_run<Rank>(e, order, kernel, v...);
+            return;
+        }
+        ex.parallel_for(m, [&](size_t i) {
+            for_each_run_in<Rank>(e, order, i * c, std::min(n, (i + 1) * c), kernel, v...);
+        });
+    }
+
+    template <typename F>
+    struct for_each_run_kernel {
+        F& f;
+        template <typename T>
+        void operator()(size_t n, T* p, std::ptrdiff_t s) const
+        {
+            const std::ptrdiff_t m = (std::ptrdiff_t)n;
+            if (s == 1)
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    f(p[i]);
+            else
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    f(p[i * s]);
+        }
+    };
+
+    template <typename T>
+    struct fill_run {
+        const T& v;
+        template <typename U>
+        void operator()(size_t n, U* p, std::ptrdiff_t s) const
+        {
+            if (s == 1)
+                std::fill_n(p, n, v);
+            else
+                for (std::ptrdiff_t i = 0, m = (std::ptrdiff_t)n; i < m; ++i)
+                    p[i * s] = v;
+        }
+    };
+}
+
+// calls f(x(i..)) for all elements
+template <typename T, rank_type Rank, typename F, typename Executor = thread_pool>
+void for_each(const array_view<T, Rank>& x, F f, const options& opts = options(),
+    Executor& ex = default_executor())
+{
+    details::parallel_runs(ex, opts, sizeof(T), x.extents(), details::loop_order<Rank>(x.strides()),
+        details::for_each_run_kernel<F>{ f }, x);
+}
+
+// dst(i..) = f(x(i..))
+template <typename T, typename U, rank_type Rank, typename F, typename Executor = thread_pool>
+void transform(const array_view<T, Rank>& dst, const array_view<U, Rank>& x, F f,
+    const options& opts = options(), Executor& ex = default_executor())
+{
+    assert(dst.extents() == x.extents());
+    details::parallel_runs(ex, opts, sizeof(T), dst.extents(), details::loop_order<Rank>(dst.strides()),
+        details::transform_run<F>{ f }, dst, x);
+}
+
+// dst(i..) = f(x(i..), y(i..))
+template <typename T, typename U, typename V, rank_type Rank, typename F,
+    typename Executor = thread_pool>
+void transform(const array_view<T, Rank>& dst, const array_view<U, Rank>& x,
+    const array_view<V, Rank>& y, F f, const options& opts = options(),
+    Executor& ex = default_executor())
+{
+    assert(dst.extents() == x.extents() && dst.extents() == y.extents());
+    details::parallel_runs(ex, opts, sizeof(T), dst.extents(), details::loop_order<Rank>(dst.strides()),
+        details::transform2_run<F>{ f }, dst, x, y);
+}
+
+// x(i..) = v
+template <typename T, rank_type Rank, typename Executor = thread_pool>
+void fill(const array_view<T, Rank>& x, const std::remove_const_t<T>& v,
+    const options& opts = options(), Executor& ex = default_executor())
+{
+    details::parallel_runs(ex, opts, sizeof(T), x.extents(), details::loop_order<Rank>(x.strides()),
+        details::fill_run<std::remove_const_t<T> >{ v }, x);
+}
+
+// dst(i..) = src(i..), same as dst <<= src
+template <typename T, typename U, rank_type Rank, typename Executor = thread_pool>
+void copy(const array_view<T, Rank>& dst, const array_view<U, Rank>& src,
+    const options& opts = options(), Executor& ex = default_executor())
+{
+    assert(dst.extents() == src.extents());
+    details::parallel_runs(ex, opts, sizeof(T), dst.extents(), details::loop_order<Rank>(dst.strides()),
+        ::sx::details::copy_run(), dst, src);
+}
+}
+}
+
+#endif
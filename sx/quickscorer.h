@@ -0,0 +1,232 @@
+#ifndef QUICKSCORER_INCLUDED_2259174038
+#define QUICKSCORER_INCLUDED_2259174038
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "sx/memory.h"
+#include "sx/sort.h"
+#include "sx/tree.h"
+
+// QuickScorer: tree ensemble inference without walking the trees
+//
+// The leaves of each tree (at most 64) are numbered from left to right and a
+// sample starts with all bits set in a 64-bit mask per tree. A split node
+// whose test x(feature) > threshold holds removes the leaves of its left
+// subtree from the mask of its tree. After applying all such nodes the exit
+// leaf is the lowest bit left in each mask.
+//
+// The trees are split into blocks of 32, the split nodes of a block are
+// grouped by feature and sorted by threshold (sortperm). Samples go in
+// blocks of 64 whose features are transposed first. The masks of a tree
+// block for a sample block (16 KB) stay in L1 while the nodes are applied
+// feature by feature, each node to all samples at once: a compare and an
+// and per sample, vectorized, no branches on the path of a sample. The nodes
+// whose test holds for a sample are a prefix of its feature's list, so a
+// feature is done at the first threshold not below the block's largest value.
+//
+// Built from a forest by sx::predict when the trees are shallow, see forest.h.
+
+namespace sx {
+
+namespace details {
+    inline unsigned lowest_bit(std::uint64_t x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return (unsigned)__builtin_ctzll(x);
+#else
+        unsigned i = 0;
+        while (!(x & 1)) {
+            x >>= 1;
+            ++i;
+        }
+        return i;
+#endif
+    }
+}
+
+template <typename T, typename V>
+class quickscorer {
+public:
+    static const size_t kMaxLeaves = 64;
+
+    static bool supports(const tree<T, V>& t) { return t.n_leaves() <= kMaxLeaves; }
+
+    // trees: a range of tree<T, V>, all supported
+    template <typename Trees>
+    explicit quickscorer(const Trees& trees)
+    {
+        // the split nodes of the current tree block by feature, in node order
+        std::vector<std::vector<T> > thr;
+        std::vector<std::vector<std::uint32_t> > tree_of;
+        std::vector<std::vector<std::uint64_t> > mask_of;
+        for (auto& t : trees) {
+            assert(supports(t));
+            const size_t k = leaf_base.size();
+            if (k == 0)
+                n_out = t.n_outputs();
+            assert(t.n_outputs() == n_out);
+            if (k % kTreeBlock == 0) {
+                if (k > 0)
+                    add_block(k - kTreeBlock, kTreeBlock, thr, tree_of, mask_of);
+                thr.clear();
+                tree_of.clear();
+                mask_of.clear();
+            }
+            leaf_base.push_back(leaf_values.size() / std::max<size_t>(1, n_out));
+            // depth-first, left to right: leaf numbers and the leaf range of each subtree
+            std::vector<std::pair<std::int32_t, bool> > stack{ { 0, false } };
+            std::vector<unsigned> first_leaf(t.size());
+            unsigned n_leaves = 0;
+            while (!stack.empty()) {
+                const auto i = stack.back().first;
+                const bool left_done = stack.back().second;
+                stack.pop_back();
+                if (t.is_leaf(i)) {
+                    auto v = t.value(i);
+                    leaf_values.insert(leaf_values.end(), v.begin(), v.end());
+                    ++n_leaves;
+                }
+                else if (!left_done) {
+                    first_leaf[i] = n_leaves;
+                    stack.push_back({ i, true });
+                    stack.push_back({ t.left(i), false });
+                }
+                else {
+                    // left subtree: leaves [first_leaf[i], n_leaves)
+                    const unsigned b = first_leaf[i], e = n_leaves;
+                    const std::uint64_t left_bits = (e - b == 64 ? ~std::uint64_t(0) : ((std::uint64_t(1) << (e - b)) - 1)) << b;
+                    const size_t f = (size_t)t.feature(i);
+                    if (f >= thr.size()) {
+                        thr.resize(f + 1);
+                        tree_of.resize(f + 1);
+                        mask_of.resize(f + 1);
+                    }
+                    n_feat = std::max(n_feat, f + 1);
+                    thr[f].push_back(t.threshold(i));
+                    tree_of[f].push_back((std::uint32_t)(k % kTreeBlock));
+                    mask_of[f].push_back(~left_bits);
+                    stack.push_back({ t.right(i), false });
+                }
+            }
+        }
+        const size_t nt = leaf_base.size();
+        if (nt > 0) {
+            const size_t first = (nt - 1) / kTreeBlock * kTreeBlock;
+            add_block(first, nt - first, thr, tree_of, mask_of);
+        }
+    }
+
+    size_t n_trees() const { return leaf_base.size(); }
+    size_t n_outputs() const { return n_out; }
+
+    // buffers of add_predictions, reused by the calls with the same workspace
+    template <typename U>
+    struct workspace {
+        memory::vector<std::uint64_t> bits;
+        memory::vector<U> x;
+    };
+
+    // acc(s, ..) += the sum of the leaf values of the trees for the m samples
+    // x[s * rs + feature * cs], acc is m x n_outputs, c_order
+    template <typename U>
+    void add_predictions(const U* x, std::ptrdiff_t rs, std::ptrdiff_t cs, size_t m, V* acc,
+        workspace<U>& ws) const
+    {
+        const size_t sb = kSampleBlock;
+        ws.bits.resize(kTreeBlock * sb);
+        ws.x.resize(n_feat * sb + n_feat);
+        U* xt = ws.x.data();
+        U* xm = xt + n_feat * sb;
+        std::uint64_t* bits = ws.bits.data();
+        for (size_t b = 0; b < m; b += sb) {
+            const size_t len = std::min(sb, m - b);
+            // the features of the sample block, transposed: xt[f * sb + s],
+            // and their largest values
+            for (size_t s = 0; s < len; ++s)
+                for (size_t f = 0; f < n_feat; ++f)
+                    xt[f * sb + s] = x[(std::ptrdiff_t)(b + s) * rs + (std::ptrdiff_t)f * cs];
+            for (size_t f = 0; f < n_feat; ++f) {
+                U x_max = std::numeric_limits<U>::lowest();
+                for (size_t s = 0; s < len; ++s)
+                    x_max = xt[f * sb + s] > x_max ? xt[f * sb + s] : x_max;
+                xm[f] = x_max;
+            }
+            for (auto& tb : blocks) {
+                std::fill_n(bits, tb.n_trees * sb, ~std::uint64_t(0));
+                for (size_t g = 0; g < tb.features.size(); ++g) {
+                    const size_t f = tb.features[g];
+                    const U* xs = xt + f * sb;
+                    // feature-major: a node's test for all samples of the block,
+                    // no later node's test holds for any of them once x_max fails
+                    for (size_t j = tb.begin[g]; j < tb.begin[g + 1] && xm[f] > tb.thresholds[j]; ++j) {
+                        const T th = tb.thresholds[j];
+                        const std::uint64_t mk = tb.masks[j];
+                        std::uint64_t* bt = bits + (size_t)tb.trees[j] * sb;
+                        for (size_t s = 0; s < len; ++s)
+                            bt[s] &= mk | ((std::uint64_t)(xs[s] > th) - 1);
+                    }
+                }
+                for (size_t t = 0; t < tb.n_trees; ++t) {
+                    const std::uint64_t* bt = bits + t * sb;
+                    const V* lv = leaf_values.data() + leaf_base[tb.first + t] * n_out;
+                    V* a = acc + b * n_out;
+                    for (size_t s = 0; s < len; ++s) {
+                        const V* v = lv + details::lowest_bit(bt[s]) * n_out;
+                        for (size_t o = 0; o < n_out; ++o)
+                            a[s * n_out + o] += v[o];
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    // the masks of a block of trees for a block of samples fill 16 KB
+    static const size_t kTreeBlock = 32;
+    static const size_t kSampleBlock = 64;
+
+    // the split nodes of kTreeBlock trees, by feature, ascending thresholds
+    struct tree_block {
+        size_t first = 0, n_trees = 0;
+        std::vector<std::uint32_t> features; // the features with nodes
+        std::vector<size_t> begin; // nodes of features[g]: [begin[g], begin[g + 1])
+        std::vector<T> thresholds;
+        std::vector<std::uint32_t> trees; // in the block
+        std::vector<std::uint64_t> masks; // clears the left subtree
+    };
+
+    void add_block(size_t first, size_t n, const std::vector<std::vector<T> >& thr,
+        const std::vector<std::vector<std::uint32_t> >& tree_of,
+        const std::vector<std::vector<std::uint64_t> >& mask_of)
+    {
+        tree_block tb;
+        tb.first = first;
+        tb.n_trees = n;
+        tb.begin.push_back(0);
+        for (size_t f = 0; f < thr.size(); ++f) {
+            if (thr[f].empty())
+                continue;
+            auto p = sortperm<std::int32_t>(make_array_view(thr[f]));
+            for (size_t j = 0; j < p.size(); ++j) {
+                tb.thresholds.push_back(thr[f][p(j)]);
+                tb.trees.push_back(tree_of[f][p(j)]);
+                tb.masks.push_back(mask_of[f][p(j)]);
+            }
+            tb.features.push_back((std::uint32_t)f);
+            tb.begin.push_back(tb.thresholds.size());
+        }
+        blocks.push_back(std::move(tb));
+    }
+
+    std::vector<tree_block> blocks;
+    std::vector<V> leaf_values; // tree by tree, leaves left to right
+    std::vector<size_t> leaf_base; // first leaf row of each tree
+    size_t n_out = 0;
+    size_t n_feat = 0; // 1 + the largest feature of a split
+};
+}
+
+#endif
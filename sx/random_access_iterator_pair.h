@@ -187,7 +187,7 @@ struct random_access_iterator_pair {
     I2 it2;
 
     random_access_iterator_pair() = default;
-    random_access_iterator_pair(const this_type& x) = default;
+    random_access_iterator_pair(const random_access_iterator_pair& x) = default;
     random_access_iterator_pair(this_type&& x)
         : it1(std::move(x.it1))
         , it2(std::move(x.it2))
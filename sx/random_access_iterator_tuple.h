@@ -0,0 +1,319 @@
+#ifndef RANDOM_ACCESS_ITERATOR_TUPLE_INCLUDED_5520193847
+#define RANDOM_ACCESS_ITERATOR_TUPLE_INCLUDED_5520193847
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+namespace sx {
+
+// defines:
+
+// template<typename... Is>
+// struct random_access_iterator_tuple;
+
+// the N-way version of random_access_iterator_pair, constructed with
+
+// template<typename... Is>
+// random_access_iterator_tuple<Is...> make_random_access_iterator_tuple(Is... its);
+
+// It zips N random access iterators into a single RandomAccess + Output
+// iterator so N parallel arrays can be sorted or partitioned together:
+
+// auto b = make_random_access_iterator_tuple(x.begin(), idx.begin(), w.begin());
+// auto e = make_random_access_iterator_tuple(x.end(), idx.end(), w.end());
+// std::sort(b, e, less_by<0>());
+
+// The first iterator leads the operations, the others only follow.
+// Dereferencing gives a proxy holding a tuple of references, comparing two
+// proxies with less_by<I...> does not construct value_type temporaries.
+// Use sx::get<I>(r) (or `using std::get; get<I>(r)`) to access the members
+// of both the proxy and the value_type.
+
+template <size_t... I>
+struct less_by;
+
+namespace details {
+    template <typename... Is>
+    struct is_good_for_random_access_iterator_tuple;
+
+    template <>
+    struct is_good_for_random_access_iterator_tuple<> : std::true_type {
+    };
+
+    template <typename I, typename... Is>
+    struct is_good_for_random_access_iterator_tuple<I, Is...> {
+        static const bool value = std::is_base_of<std::random_access_iterator_tag,
+                                      typename std::iterator_traits<I>::iterator_category>::value
+            && is_good_for_random_access_iterator_tuple<Is...>::value;
+    };
+
+    template <typename F, typename Tuple, size_t... I>
+    void for_each_in_tuple(F&& f, Tuple&& t, std::index_sequence<I...>)
+    {
+        (void)std::initializer_list<int>{ (f(std::get<I>(t)), 0)... };
+    }
+
+    template <typename F, typename T1, typename T2, size_t... I>
+    void for_each_in_tuples(F&& f, T1&& t1, T2&& t2, std::index_sequence<I...>)
+    {
+        (void)std::initializer_list<int>{ (f(std::get<I>(t1), std::get<I>(t2)), 0)... };
+    }
+}
+
+template <typename... Is>
+struct random_access_iterator_tuple_reference;
+
+// proxy for 'reference', models std::tuple<Is::reference...>
+template <typename... Is>
+struct random_access_iterator_tuple_reference {
+    using value_type = std::tuple<typename std::iterator_traits<Is>::value_type...>;
+    using references = std::tuple<typename std::iterator_traits<Is>::reference...>;
+    using this_type = random_access_iterator_tuple_reference;
+    using indices = std::index_sequence_for<Is...>;
+
+    references refs;
+
+    random_access_iterator_tuple_reference(const this_type&) = default;
+    explicit random_access_iterator_tuple_reference(typename std::iterator_traits<Is>::reference... r)
+        : refs(r...)
+    {
+    }
+
+    // assignments write through the references
+    this_type& operator=(const this_type& x)
+    {
+        details::for_each_in_tuples([](auto& a, auto& b) { a = b; }, refs, x.refs, indices());
+        return *this;
+    }
+    this_type& operator=(this_type&& x)
+    {
+        details::for_each_in_tuples([](auto& a, auto& b) { a = std::move(b); }, refs, x.refs, indices());
+        return *this;
+    }
+    this_type& operator=(const value_type& x)
+    {
+        details::for_each_in_tuples([](auto& a, auto& b) { a = b; }, refs, x, indices());
+        return *this;
+    }
+    this_type& operator=(value_type&& x)
+    {
+        details::for_each_in_tuples([](auto& a, auto& b) { a = std::move(b); }, refs, x, indices());
+        return *this;
+    }
+
+    operator value_type() const &
+    {
+        return to_value(indices());
+    }
+    // std::sort moves out of *it into a temporary: move the members too
+    operator value_type() &&
+    {
+        return move_to_value(indices());
+    }
+
+    // swaps the referred values, the proxies are like pointers: const
+    // proxies can still modify the values
+    void swap(const this_type& x) const
+    {
+        references a = refs, b = x.refs;
+        details::for_each_in_tuples([](auto& u, auto& v) {
+            using std::swap;
+            swap(u, v);
+        },
+            a, b, indices());
+    }
+
+private:
+    template <size_t... I>
+    value_type to_value(std::index_sequence<I...>) const
+    {
+        return value_type(std::get<I>(refs)...);
+    }
+    template <size_t... I>
+    value_type move_to_value(std::index_sequence<I...>)
+    {
+        return value_type(std::move(std::get<I>(refs))...);
+    }
+};
+
+template <size_t I, typename... Is>
+auto get(const random_access_iterator_tuple_reference<Is...>& x) -> decltype(std::get<I>(x.refs))
+{
+    return std::get<I>(x.refs);
+}
+
+// swap the referred values, for lvalue and rvalue proxies alike
+// (the non-const overload hides std::swap which would swap the proxies)
+template <typename... Is>
+void swap(const random_access_iterator_tuple_reference<Is...>& x, const random_access_iterator_tuple_reference<Is...>& y)
+{
+    x.swap(y);
+}
+template <typename... Is>
+void swap(random_access_iterator_tuple_reference<Is...>& x, random_access_iterator_tuple_reference<Is...>& y)
+{
+    x.swap(y);
+}
+
+// proxy for 'pointer'
+template <typename... Is>
+struct random_access_iterator_tuple_pointer {
+    using reference = random_access_iterator_tuple_reference<Is...>;
+
+    reference r;
+
+    explicit random_access_iterator_tuple_pointer(const reference& r)
+        : r(r)
+    {
+    }
+
+    const reference* operator->() const { return &r; }
+    reference operator*() const { return r; }
+};
+
+// the actual iterator tuple, models random access + input + output iterator
+template <typename... Is>
+struct random_access_iterator_tuple {
+    static_assert(sizeof...(Is) > 0, "at least one iterator is needed");
+    static_assert(details::is_good_for_random_access_iterator_tuple<Is...>::value,
+        "all iterators must be random access");
+
+    using value_type = std::tuple<typename std::iterator_traits<Is>::value_type...>;
+    using reference = random_access_iterator_tuple_reference<Is...>;
+    using pointer = random_access_iterator_tuple_pointer<Is...>;
+    using difference_type = typename std::iterator_traits<
+        typename std::tuple_element<0, std::tuple<Is...> >::type>::difference_type;
+    using iterator_category = std::random_access_iterator_tag;
+
+    using this_type = random_access_iterator_tuple;
+    using indices = std::index_sequence_for<Is...>;
+
+    std::tuple<Is...> its;
+
+    random_access_iterator_tuple() = default;
+    explicit random_access_iterator_tuple(Is... its)
+        : its(std::move(its)...)
+    {
+    }
+
+    reference operator*() const { return deref(indices(), 0); }
+    pointer operator->() const { return pointer(**this); }
+    reference operator[](difference_type d) const { return deref(indices(), d); }
+
+    this_type& operator++()
+    {
+        details::for_each_in_tuple([](auto& it) { ++it; }, its, indices());
+        return *this;
+    }
+    this_type operator++(int)
+    {
+        this_type r(*this);
+        ++*this;
+        return r;
+    }
+    this_type& operator--()
+    {
+        details::for_each_in_tuple([](auto& it) { --it; }, its, indices());
+        return *this;
+    }
+    this_type operator--(int)
+    {
+        this_type r(*this);
+        --*this;
+        return r;
+    }
+    this_type& operator+=(difference_type d)
+    {
+        details::for_each_in_tuple([d](auto& it) { it += d; }, its, indices());
+        return *this;
+    }
+    this_type& operator-=(difference_type d)
+    {
+        return *this += -d;
+    }
+    this_type operator+(difference_type d) const
+    {
+        this_type r(*this);
+        return r += d;
+    }
+    this_type operator-(difference_type d) const
+    {
+        this_type r(*this);
+        return r -= d;
+    }
+    difference_type operator-(const this_type& x) const
+    {
+        return std::get<0>(its) - std::get<0>(x.its);
+    }
+
+    bool operator==(const this_type& x) const { return std::get<0>(its) == std::get<0>(x.its); }
+    bool operator!=(const this_type& x) const { return !(*this == x); }
+    bool operator<(const this_type& x) const { return std::get<0>(its) < std::get<0>(x.its); }
+    bool operator<=(const this_type& x) const { return std::get<0>(its) <= std::get<0>(x.its); }
+    bool operator>(const this_type& x) const { return std::get<0>(its) > std::get<0>(x.its); }
+    bool operator>=(const this_type& x) const { return std::get<0>(its) >= std::get<0>(x.its); }
+
+private:
+    template <size_t... I>
+    reference deref(std::index_sequence<I...>, difference_type d) const
+    {
+        return reference(std::get<I>(its)[d]...);
+    }
+};
+
+template <typename... Is>
+random_access_iterator_tuple<Is...> operator+(
+    typename random_access_iterator_tuple<Is...>::difference_type d,
+    const random_access_iterator_tuple<Is...>& x)
+{
+    return x + d;
+}
+
+template <typename... Is>
+void swap(random_access_iterator_tuple<Is...>& x, random_access_iterator_tuple<Is...>& y)
+{
+    std::swap(x.its, y.its);
+}
+
+//create random_access_iterator_tuple
+template <typename... Is>
+random_access_iterator_tuple<Is...> make_random_access_iterator_tuple(Is... its)
+{
+    return random_access_iterator_tuple<Is...>(std::move(its)...);
+}
+
+//helper classes for sort
+
+// lexicographical compare by the I-th members, like less_by_first for
+// random_access_iterator_pair: less_by<0>, less_by<2, 0>
+// works for the proxy references and value_type (std::tuple) as well
+template <size_t I, size_t... Rest>
+struct less_by<I, Rest...> {
+    template <typename X, typename Y>
+    bool operator()(const X& x, const Y& y) const
+    {
+        using std::get;
+        if (get<I>(x) < get<I>(y))
+            return true;
+        if (get<I>(y) < get<I>(x))
+            return false;
+        return less_by<Rest...>()(x, y);
+    }
+};
+
+template <size_t I>
+struct less_by<I> {
+    template <typename X, typename Y>
+    bool operator()(const X& x, const Y& y) const
+    {
+        using std::get;
+        return get<I>(x) < get<I>(y);
+    }
+};
+}
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef REDUCE_INCLUDED_6029184735
+#define REDUCE_INCLUDED_6029184735
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "sx/multi_array.h"
+#include "sx/parallel.h"
+
+// Parallel reductions over array_views
+//
+//     double s = sx::par::sum(X);
+//     auto col_sums = sx::par::reduce_along(X, 0, 0.0, std::plus<>());
+//     auto w = sx::par::bincount(y, sample_weight);
+//
+// The elements are cut into blocks like in parallel.h, each block is folded
+// sequentially in memory order and the partial results of the blocks are
+// combined along a pairwise tree whose shape depends only on the number of
+// blocks. With `options::deterministic` the blocks depend only on the shape
+// and the grain size, so floating-point results are bitwise identical across
+// runs, thread counts and executors. Without it the blocks get smaller for
+// small arrays to keep all threads busy, the rest is the same.
+//
+// `identity` is the identity element of `op` (0 for sums), it's the initial
+// value of every block.
+
+namespace sx {
+namespace par {
+
+namespace details {
+    // combine(i, j) does partial[i] = op(partial[i], partial[j]),
+    // leaves the result in partial[0]
+    template <typename Combine>
+    void pairwise_combine(size_t m, Combine&& combine)
+    {
+        for (size_t step = 1; step < m; step *= 2)
+            for (size_t i = 0; i + step < m; i += 2 * step)
+                combine(i, i + step);
+    }
+
+    // h[x[k * xs]] += w[k * ws] for k in [b, e), the inner loop of bincount
+    template <typename R, typename I, typename V>
+    void add_bincount(R* h, const I* x, std::ptrdiff_t xs, const V* w, std::ptrdiff_t ws, std::ptrdiff_t b,
+        std::ptrdiff_t e)
+    {
+        for (std::ptrdiff_t k = b; k < e; ++k)
+            h[(size_t)x[k * xs]] += w[k * ws];
+    }
+
+    // number of blocks for splitting `n` items, `item_bytes` each
+    inline size_t block_length(size_t n, size_t item_bytes, size_t concurrency, const options& o)
+    {
+        size_t c = std::max<size_t>(1, o.grain_bytes / std::max<size_t>(1, item_bytes));
+        if (!o.deterministic && concurrency > 1) {
+            const size_t k = kChunksPerThread * concurrency;
+            c = std::min(c, std::max<size_t>(1, (n + k - 1) / k));
+        }
+        return c;
+    }
+
+    // x with dimension d restricted to [b, e)
+    template <typename T, rank_type Rank>
+    array_view<T, Rank> restrict_dim(const array_view<T, Rank>& x, rank_type d, size_t b, size_t e)
+    {
+        auto ext = x.extents();
+        ext[d] = e - b;
+        return { x.data() + (std::ptrdiff_t)b * x.strides(d), ext, x.strides() };
+    }
+
+    // o[i * os] = op(o[i * os], a[i * as]), os == 0 for a run along the reduced dimension
+    template <typename Op>
+    struct reduce_run {
+        Op& op;
+        template <typename Acc, typename T>
+        void operator()(size_t n, Acc* o, T* a, std::ptrdiff_t os, std::ptrdiff_t as) const
+        {
+            const std::ptrdiff_t m = (std::ptrdiff_t)n;
+            if (os == 0) {
+                Acc acc = *o;
+                if (as == 1)
+                    for (std::ptrdiff_t i = 0; i < m; ++i)
+                        acc = op(acc, a[i]);
+                else
+                    for (std::ptrdiff_t i = 0; i < m; ++i)
+                        acc = op(acc, a[i * as]);
+                *o = acc;
+            }
+            else if (os == 1 && as == 1)
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    o[i] = op(o[i], a[i]);
+            else
+                for (std::ptrdiff_t i = 0; i < m; ++i)
+                    o[i * os] = op(o[i * os], a[i * as]);
+        }
+    };
+
+    // folds x into the same-shape view o which has zero stride along the
+    // reduced dimension, in the memory order of x
+    template <typename Acc, typename T, rank_type Rank, typename Op>
+    void reduce_into(const array_view<Acc, Rank>& o, const array_view<T, Rank>& x,
+        const std::array<rank_type, Rank>& order, Op& op)
+    {
+        for_each_run<Rank>(x.extents(), order, reduce_run<Op>{ op }, o, x);
+    }
+}
+
+// folds all elements with op
+template <typename T, rank_type Rank, typename Acc, typename Op, typename Executor = thread_pool>
+Acc reduce(const array_view<T, Rank>& x, Acc identity, Op op, const options& opts = options(),
+    Executor& ex = default_executor())
+{
+    const size_t n = x.size();
+    if (n == 0)
+        return identity;
+    const auto order = details::loop_order<Rank>(x.strides());
+    const size_t c = details::chunk_length(n, x.extents(order[Rank - 1]), sizeof(T), ex.concurrency(), opts);
+    const size_t m = (n + c - 1) / c;
+    memory::vector<Acc> partial(m, identity);
+    ex.parallel_for(m, [&](size_t i) {
+        details::for_each_run_in<Rank>(x.extents(), order, i * c, std::min(n, (i + 1) * c),
+            details::accumulate_run<Acc, Op>{ partial[i], op }, x);
+    });
+    details::pairwise_combine(m, [&](size_t i, size_t j) { partial[i] = op(partial[i], partial[j]); });
+    return partial[0];
+}
+
+template <typename T, rank_type Rank, typename Executor = thread_pool>
+std::remove_const_t<T> sum(const array_view<T, Rank>& x, const options& opts = options(),
+    Executor& ex = default_executor())
+{
+    return reduce(x, std::remove_const_t<T>(), std::plus<>(), opts, ex);
+}
+
+template <typename T, rank_type Rank, typename Executor = thread_pool>
+std::remove_const_t<T> mean(const array_view<T, Rank>& x, const options& opts = options(),
+    Executor& ex = default_executor())
+{
+    assert(!x.empty());
+    return static_cast<std::remove_const_t<T> >(sum(x, opts, ex) / x.size());
+}
+
+// folds along `dim`: R(.., i, j, ..) = op(..op(op(identity, X(.., i, 0, j, ..)), X(.., i, 1, j, ..))..)
+// where `dim` is removed from the extents, the layout of R follows X
+//
+// If the result is large, the other dimensions are split among the threads
+// and every result element is folded in the order of the index along `dim`,
+// exactly as the sequential loop would do. If it's small (fits in a grain),
+// `dim` is split into blocks and their partial results are combined pairwise.
+template <typename T, rank_type Rank, typename Acc, typename Op, typename Executor = thread_pool,
+    typename = std::enable_if_t<(Rank > 1)> >
+multi_array<Acc, Rank - 1> reduce_along(const array_view<T, Rank>& x, rank_type dim, Acc identity, Op op,
+    const options& opts = options(), Executor& ex = default_executor())
+{
+    assert(dim < Rank);
+    std::array<size_t, Rank - 1> re;
+    for (rank_type i = 0, k = 0; i < Rank; ++i)
+        if (i != dim)
+            re[k++] = x.extents(i);
+    const auto layout = std::abs(x.strides().front()) >= std::abs(x.strides().back())
+        ? array_layout::c_order
+        : array_layout::fortran_order;
+    multi_array<Acc, Rank - 1> R(re, layout, identity);
+    const size_t rn = R.size();
+    if (rn == 0 || x.extents(dim) == 0)
+        return R;
+
+    const auto order = details::loop_order<Rank>(x.strides());
+    auto target = [&](Acc* p) {
+        return broadcast_to(expand_dims(array_view<Acc, Rank - 1>(p, re, layout), dim), x.extents());
+    };
+
+    if (rn * sizeof(Acc) >= opts.grain_bytes || x.extents(dim) == 1) {
+        // split the outermost other dimension, each task owns its part of R
+        const rank_type s = order[0] != dim ? order[0] : order[1];
+        const size_t es = x.extents(s);
+        const size_t c = details::block_length(es, sizeof(T) * (x.size() / es), ex.concurrency(), opts);
+        const auto o = target(R.data());
+        ex.parallel_for((es + c - 1) / c, [&](size_t i) {
+            const size_t b = i * c, e = std::min(es, b + c);
+            details::reduce_into(details::restrict_dim(o, s, b, e), details::restrict_dim(x, s, b, e),
+                order, op);
+        });
+    }
+    else {
+        // blocks along dim with a partial result each
+        const size_t ed = x.extents(dim);
+        const size_t c = details::block_length(ed, sizeof(T) * rn, ex.concurrency(), opts);
+        const size_t m = (ed + c - 1) / c;
+        memory::vector<Acc> partial(m * rn, identity);
+        ex.parallel_for(m, [&](size_t i) {
+            const size_t b = i * c, e = std::min(ed, b + c);
+            details::reduce_into(details::restrict_dim(target(partial.data() + i * rn), dim, b, e),
+                details::restrict_dim(x, dim, b, e), order, op);
+        });
+        details::pairwise_combine(m, [&](size_t i, size_t j) {
+            Acc* pi = partial.data() + i * rn;
+            const Acc* pj = partial.data() + j * rn;
+            for (size_t k = 0; k < rn; ++k)
+                pi[k] = op(pi[k], pj[k]);
+        });
+        std::copy_n(partial.begin(), rn, R.data());
+    }
+    return R;
+}
+
+// like numpy.bincount(x, weights, minlength):
+// result[k] is the sum of weights[i] where x[i] == k
+// the length of the result is max(max(x) + 1, min_length)
+template <typename W = void, typename I, typename V, typename Executor = thread_pool,
+    typename R = std::conditional_t<std::is_void<W>::value, std::remove_const_t<V>, W> >
+std::vector<R> bincount(const array_view<I>& x, const array_view<V>& weights, size_t min_length = 0,
+    const options& opts = options(), Executor& ex = default_executor())
+{
+    static_assert(std::is_integral<std::remove_const_t<I> >::value, "bincount needs integral x");
+    assert(x.extents() == weights.extents());
+    const size_t n = x.size();
+    SX_INSTRUMENT_SCOPE("par::bincount", n, n * (sizeof(I) + (weights.strides(0) ? sizeof(V) : 0)));
+    SX_INSTRUMENT_PATH(x.strides(0) == 1 && (weights.strides(0) == 1 || weights.strides(0) == 0)
+            ? ::sx::instrument::path::contiguous
+            : ::sx::instrument::path::strided);
+    if (n == 0)
+        return std::vector<R>(min_length);
+    const auto mx = reduce(x, std::remove_const_t<I>(0),
+        [](std::remove_const_t<I> a, std::remove_const_t<I> b) {
+            assert(b >= 0);
+            return std::max(a, b);
+        },
+        opts, ex);
+    const size_t nb = std::max<size_t>(min_length, (size_t)mx + 1);
+
+    // a histogram per block, blocks are never shorter than the histogram
+    // The first block's is the result, the others are scratch.
+    const size_t c = std::max(nb, details::block_length(n, sizeof(I), ex.concurrency(), opts));
+    const size_t m = (n + c - 1) / c;
+    memory::details::on_untracked_allocate("par::bincount", nb * sizeof(R));
+    std::vector<R> r(nb, R());
+    memory::vector<R> h((m - 1) * nb, R(), memory::tracking_allocator<R>("par::bincount"));
+    auto block = [&](size_t i) { return i == 0 ? r.data() : h.data() + (i - 1) * nb; };
+    ex.parallel_for(m, [&](size_t i) {
+        details::add_bincount(block(i), x.data(), x.strides(0), weights.data(), weights.strides(0),
+            (std::ptrdiff_t)(i * c), (std::ptrdiff_t)std::min(n, (i + 1) * c));
+    });
+    details::pairwise_combine(m, [&](size_t i, size_t j) {
+        R* hi = block(i);
+        const R* hj = block(j);
+        for (size_t k = 0; k < nb; ++k)
+            hi[k] += hj[k];
+    });
+    return r;
+}
+
+// counts, like numpy.bincount(x, minlength=min_length)
+template <typename T = size_t, typename I, typename Executor = thread_pool>
+std::vector<T> bincount(const array_view<I>& x, size_t min_length = 0,
+    const options& opts = options(), Executor& ex = default_executor())
+{
+    const T one = 1;
+    return bincount<T>(x, broadcast_to(array_view<const T>(&one, 1), x.extents()), min_length, opts, ex);
+}
+}
+}
+
+#endif
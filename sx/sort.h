@@ -1,8 +1,19 @@
 #ifndef SORT_INCLUDED_273409823434
 #define SORT_INCLUDED_273409823434
 
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "sx/abbrev.h"
 #include "sx/array_view.h"
+#include "sx/memory.h"
 #include "sx/multi_array.h"
+#include "sx/utility.h"
 
 namespace sx {
 
@@ -24,25 +35,180 @@ bool next_variation(
     return false;
 }
 
+namespace details {
+    // element access by index for the ranges of sort_zipped
+    // strided 1-D array_views are accessed directly, everything else through
+    // its random access iterator
+    template <typename T>
+    std::true_type is_1d_array_view_test(const array_view<T, 1>*);
+    std::false_type is_1d_array_view_test(...);
+    // true for array_view<T, 1> and the classes derived from it
+    template <typename Rng>
+    using is_1d_array_view = decltype(is_1d_array_view_test(std::declval<std::decay_t<Rng>*>()));
+
+    template <typename Rng, typename = std::enable_if_t<is_1d_array_view<Rng>::value> >
+    auto element_access(const Rng& v)
+    {
+        using T = std::remove_pointer_t<decltype(v.data())>;
+        return [p = v.data(), s = v.strides(0)](size_t i) -> T& { return p[(std::ptrdiff_t)i * s]; };
+    }
+    template <typename Rng, typename = std::enable_if_t<!is_1d_array_view<Rng>::value>, typename = void>
+    auto element_access(Rng& r)
+    {
+        auto b = ranges::begin(r);
+        return [b](size_t i) -> decltype(b[i]) { return b[i]; };
+    }
+
+    // keys which can be mapped to 32 bits preserving their order are sorted
+    // packed with their index into a single uint64_t
+    template <typename K>
+    struct is_packable_sort_key {
+        static const bool value = std::is_arithmetic<K>::value && !std::is_same<K, bool>::value
+            && sizeof(K) <= 4;
+    };
+
+    template <typename K>
+    std::enable_if_t<std::is_floating_point<K>::value, std::uint32_t> sort_key_bits(K k)
+    {
+        float f = (float)k;
+        f = f + 0.0f; // -0 as +0, they're equal keys
+        std::uint32_t u;
+        std::memcpy(&u, &f, 4);
+        return u & 0x80000000u ? ~u : u | 0x80000000u;
+    }
+    template <typename K>
+    std::enable_if_t<std::is_integral<K>::value && std::is_signed<K>::value, std::uint32_t> sort_key_bits(K k)
+    {
+        return (std::uint32_t)(std::int32_t)k ^ 0x80000000u;
+    }
+    template <typename K>
+    std::enable_if_t<std::is_integral<K>::value && std::is_unsigned<K>::value, std::uint32_t> sort_key_bits(K k)
+    {
+        return (std::uint32_t)k;
+    }
+
+    // perm[i] = index of the i-th smallest of keys(0) .. keys(n - 1), stable
+    // The scratch buffers are attributed to `site` unless a memory::site is
+    // active.
+    template <typename Keys, typename Perm>
+    void sort_permutation_packed(Keys keys, size_t n, Perm perm, const char* site, std::true_type)
+    {
+        memory::vector<std::uint64_t> v(n, 0, memory::tracking_allocator<std::uint64_t>(site));
+        for (size_t i = 0; i < n; ++i)
+            v[i] = (std::uint64_t)sort_key_bits(keys(i)) << 32 | i;
+        std::sort(v.begin(), v.end());
+        for (size_t i = 0; i < n; ++i)
+            perm(i) = (std::uint32_t)v[i];
+    }
+    template <typename Keys, typename Perm>
+    void sort_permutation_packed(Keys keys, size_t n, Perm perm, const char* site, std::false_type)
+    {
+        using K = std::decay_t<decltype(keys(0))>;
+        memory::vector<std::pair<K, size_t> > v(n, std::pair<K, size_t>(),
+            memory::tracking_allocator<std::pair<K, size_t> >(site));
+        for (size_t i = 0; i < n; ++i)
+            v[i] = { keys(i), i };
+        std::sort(v.begin(), v.end());
+        for (size_t i = 0; i < n; ++i)
+            perm(i) = v[i].second;
+    }
+    template <typename Keys, typename Perm>
+    void sort_permutation(Keys keys, size_t n, Perm perm, const char* site)
+    {
+        using K = std::decay_t<decltype(keys(0))>;
+        if (n <= UINT32_MAX)
+            sort_permutation_packed(keys, n, perm, site,
+                std::integral_constant<bool, is_packable_sort_key<K>::value>());
+        else
+            sort_permutation_packed(keys, n, perm, site, std::false_type());
+    }
+
+    // x(i) = x(perm[i]) for each x
+    // the permutation is applied in blocks: a block of `perm` is used for all
+    // the arrays while it is in the cache, the sources are prefetched ahead
+    static const size_t kPermuteBlockSize = 4096;
+    static const size_t kPermutePrefetchDistance = 16;
+
+    template <typename X, typename Tmp>
+    void gather_permuted_block(X x, Tmp& tmp, const memory::vector<size_t>& perm, size_t b, size_t e)
+    {
+        for (size_t i = b; i < e; ++i) {
+            if (i + kPermutePrefetchDistance < e)
+                SX_PREFETCH(&x(perm[i + kPermutePrefetchDistance]));
+            tmp[i] = std::move(x(perm[i]));
+        }
+    }
+
+    template <typename... Xs, size_t... I>
+    void apply_permutation(const memory::vector<size_t>& perm, std::tuple<Xs...> xs, std::index_sequence<I...>,
+        const char* site)
+    {
+        const size_t n = perm.size();
+        std::tuple<memory::vector<std::decay_t<decltype(std::get<I>(xs)(0))> >...> tmp{
+            memory::tracking_allocator<std::decay_t<decltype(std::get<I>(xs)(0))> >(site)...
+        };
+        (void)std::initializer_list<int>{ (std::get<I>(tmp).resize(n), 0)... };
+        for (size_t b = 0; b < n; b += kPermuteBlockSize) {
+            const size_t e = std::min(n, b + kPermuteBlockSize);
+            (void)std::initializer_list<int>{ (gather_permuted_block(std::get<I>(xs), std::get<I>(tmp), perm, b, e), 0)... };
+        }
+        (void)std::initializer_list<int>{ ([](auto x, auto& t) {
+            for (size_t i = 0; i < t.size(); ++i)
+                x(i) = std::move(t[i]);
+        }(std::get<I>(xs), std::get<I>(tmp)),
+            0)... };
+    }
+}
+
+// sorts `keys` (stable) and permutes the `payload` ranges the same way
+// keys and payloads are std::vectors, 1-D array_views or other random access
+// ranges of the same size
+// Instead of sorting through zipped iterators it sorts (key, index) pairs,
+// packed into 64 bits for keys of at most 32 bits, then applies the
+// permutation to all the ranges.
+template <typename Keys, typename... Payloads>
+void sort_zipped(Keys&& keys, Payloads&&... payload)
+{
+    const size_t n = ranges::end(keys) - ranges::begin(keys);
+    const size_t sizes[] = { n, (size_t)(ranges::end(payload) - ranges::begin(payload))... };
+    for (size_t s : sizes)
+        assert(s == n);
+    (void)sizes;
+    if (n < 2)
+        return;
+    auto k = details::element_access(keys);
+    memory::vector<size_t> perm(n, 0, memory::tracking_allocator<size_t>("sort_zipped"));
+    details::sort_permutation(k, n, [&perm](size_t i) -> size_t& { return perm[i]; }, "sort_zipped");
+    details::apply_permutation(perm, std::make_tuple(k, details::element_access(payload)...),
+        std::make_index_sequence<1 + sizeof...(Payloads)>(), "sort_zipped");
+}
+
+// sorts along 'dim' dimension in place
 template <typename R, rank_type Rank,
     typename = std::enable_if_t<!std::is_const<R>::value> >
-void sortperm_inplace(array_view<R, Rank> X, rank_type dim = 0)
+void sort_inplace(array_view<R, Rank> X, rank_type dim = 0)
 {
-    using ResultArray = array_view<R, Rank>;
-
-    // iterate over X, leaving out the 'dim' dimension
-    std::array<typename ResultArray::size_type, Rank> lower_bounds, it, e;
+    // iterate over X, fixing it[dim] to 0
+    std::array<size_t, Rank> lower_bounds, it, e;
     lower_bounds.fill(0);
     it.fill(0);
     std::copy_n(X.extents().begin(), Rank, e.begin());
     e[dim] = 1;
 
+    memory::vector<R> w(X.extents(dim), R(), memory::tracking_allocator<R>("sort"));
     for (;;) {
-        auto vbegin = &X[it];
-        auto vend = vbegin + X.extents[dim] * X.strides(dim);
-        std::sort(vbegin, vend);
+        auto xv = make_array_view<1>(&X[it], X.extents(dim), X.strides(dim));
+        if (xv.strides(0) == 1)
+            std::sort(xv.data(), xv.data() + xv.extents(0));
+        else {
+            for (size_t i = 0; i < w.size(); ++i)
+                w[i] = xv(i);
+            std::sort(BEGINEND(w));
+            for (size_t i = 0; i < w.size(); ++i)
+                xv(i) = w[i];
+        }
 
-        if (!next_variation(lower_bounds.begin(), it.begin(), e.begin()))
+        if (!next_variation(lower_bounds.begin(), it.begin(), e.begin(), Rank))
             break;
     }
 }
@@ -55,20 +221,21 @@ sort(array_view<T, Rank> X, rank_type dim = 0)
     using ResultArray = multi_array<V, Rank>;
 
     ResultArray R(X.extents());
-    sort_inplace(R, dim);
+    R.view() <<= X;
+    sort_inplace(R.view(), dim);
     return R;
 }
 
 // like Julia's sortperm
-// sorts along 'dim' dimension
+// sorts along 'dim' dimension, stable
 template <typename T, typename U, rank_type Rank>
 multi_array<T, Rank> sortperm(array_view<U, Rank> X, int dim = 0)
 {
     using ResultArray = multi_array<T, Rank>;
+    SX_INSTRUMENT_SCOPE("sortperm", X.size(), X.size() * (sizeof(U) + sizeof(T)));
+    SX_INSTRUMENT_PATH(std::abs(X.strides(dim)) == 1 ? instrument::path::contiguous : instrument::path::strided);
     ResultArray R(X.extents(), X.strides().front() > X.strides().back() ? array_layout::c_order : array_layout::fortran_order);
 
-    std::vector<T> w(X.extents(dim));
-
     // iterate over X, fixing it[dim] to 0
     std::array<size_t, Rank> lower_bounds, it, e;
     lower_bounds.fill(0);
@@ -77,18 +244,10 @@ multi_array<T, Rank> sortperm(array_view<U, Rank> X, int dim = 0)
     e[dim] = 1;
 
     for (;;) {
-        auto rbegin = &R[it];
-        auto rend = rbegin + R.extents(dim) * R.strides(dim);
-        std::iota(rbegin, rend, 0);
         auto xv = make_array_view<1>(&X[it], X.extents(dim), X.strides(dim));
-        std::copy(BEGINEND(xv), w.begin());
-        std::sort(
-            make_random_access_iterator_pair(w.begin(), rbegin),
-            make_random_access_iterator_pair(w.end(), rend));
-
-        assert(R.extents(dim) == w.size());
-        std::copy(BEGINEND(w),
-            make_array_view<1>(&R[it], R.extents(dim), R.strides(dim)).begin());
+        auto rv = make_array_view<1>(&R[it], R.extents(dim), R.strides(dim));
+        details::sort_permutation(details::element_access(xv), xv.extents(0),
+            [&rv](size_t i) -> T& { return rv(i); }, "sortperm");
 
         if (!next_variation(lower_bounds.begin(), it.begin(), e.begin(), Rank))
             break;
@@ -102,6 +261,8 @@ template <typename T, rank_type Rank,
 multi_array<std::remove_const_t<T>, Rank - 1>
 indmax_along(array_view<T, Rank> X, rank_type dim, array_layout_t layout)
 {
+    SX_INSTRUMENT_SCOPE("indmax_along", X.size(), X.size() * sizeof(T));
+    SX_INSTRUMENT_PATH(std::abs(X.strides(dim)) == 1 ? instrument::path::contiguous : instrument::path::strided);
 
     auto extents = X.extents();
     std::array<size_t, Rank - 1> extents_dim;
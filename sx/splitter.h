@@ -0,0 +1,188 @@
+#ifndef SPLITTER_INCLUDED_4095127386
+#define SPLITTER_INCLUDED_4095127386
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+#include "sx/array_view.h"
+#include "sx/memory.h"
+#include "sx/multi_array.h"
+#include "sx/parallel.h"
+#include "sx/sort.h"
+
+// Exact split search for growing regression trees
+//
+//     sx::presorted_splitter<float> sp(X);  // X: samples x features, no NaNs
+//     auto root = sp.root();
+//     auto s = sp.find_split(root, y);      // best feature and threshold for y
+//     if (s.is_valid()) {
+//         auto children = sp.apply_split(root, s);
+//         ...                               // recurse into children.first, .second
+//     }
+//
+// The samples of every feature are sorted once, with sortperm, into the
+// columns of a column-major n_samples x n_features index matrix. A node is a
+// range of rows: each column holds the same samples, sorted by the column's
+// feature. find_split scans the columns of a node with running sums of y, an
+// O(n) pass per feature instead of sorting at every node.
+//
+// apply_split marks the samples going right in a bitmask (one bit per sample)
+// and stably partitions each column of the node around it, so both children
+// stay sorted, O(n) per feature. The features are processed in parallel in
+// both steps.
+//
+// The split rule is the one of sx::tree: x(feature) > threshold goes right.
+// The gain of a split is the decrease of the sum of squared errors of y.
+
+namespace sx {
+
+template <typename T>
+struct split {
+    std::int32_t feature = -1; // -1: no split
+    T threshold = T();
+    double gain = 0;
+    size_t n_left = 0;
+
+    bool is_valid() const { return feature >= 0; }
+};
+
+struct split_options {
+    // children won't have fewer samples than this
+    size_t min_samples_leaf = 1;
+    // histogram_splitter only: children won't have a smaller sum of hessians
+    double min_hessian_leaf = 0;
+    // histogram_splitter only: added to the sums of hessians in the gain
+    double l2_regularization = 0;
+};
+
+template <typename T>
+class presorted_splitter {
+public:
+    // rows [begin, end) of the index matrix
+    struct node_range {
+        size_t begin, end;
+        size_t size() const { return end - begin; }
+    };
+
+    // X must outlive the splitter
+    template <typename Executor = thread_pool>
+    explicit presorted_splitter(const array_view<const T, 2>& X, Executor& ex = par::default_executor())
+        : X(X)
+        , idx(typename multi_array<std::uint32_t, 2>::extents_type(X.extents(0), X.extents(1)),
+              array_layout::fortran_order)
+        , right_bits((X.extents(0) + 63) / 64, 0, memory::tracking_allocator<std::uint64_t>("splitter"))
+    {
+        assert(X.extents(0) < (size_t)UINT32_MAX);
+        ex.parallel_for(n_features(), [&](size_t j) {
+            idx(sx::all, j) <<= sortperm<std::uint32_t>(X(sx::all, j));
+        });
+    }
+
+    size_t n_samples() const { return idx.extents(0); }
+    size_t n_features() const { return idx.extents(1); }
+    node_range root() const { return { 0, n_samples() }; }
+
+    // the samples of the node, sorted by feature j
+    array_view<const std::uint32_t> samples(const node_range& node, size_t j) const
+    {
+        return idx({ node.begin, sx::length = node.size() }, j);
+    }
+
+    // the split of the node with the largest gain, invalid if no split has
+    // a positive gain, y: the targets of all samples
+    // Ties go to the lowest feature and the lowest threshold.
+    template <typename Executor = thread_pool>
+    split<T> find_split(const node_range& node, const array_view<const double>& y,
+        const split_options& opts = split_options(), Executor& ex = par::default_executor()) const
+    {
+        assert(y.extents(0) == n_samples());
+        const size_t min_leaf = std::max<size_t>(1, opts.min_samples_leaf);
+        if (node.size() < 2 * min_leaf)
+            return split<T>();
+        memory::vector<split<T> > best(n_features(), split<T>(),
+            memory::tracking_allocator<split<T> >("splitter"));
+        double sum = 0;
+        for (auto i : samples(node, 0))
+            sum += y(i);
+        const double n = (double)node.size();
+        const double parent = sum * sum / n;
+        ex.parallel_for(n_features(), [&](size_t j) {
+            const std::uint32_t* s = idx.data() + node.begin + j * n_samples();
+            auto& b = best[j];
+            double left = 0;
+            for (size_t k = 1; k < node.size(); ++k) {
+                left += y(s[k - 1]);
+                if (k < min_leaf || node.size() - k < min_leaf)
+                    continue;
+                const T a = X(s[k - 1], j), c = X(s[k], j);
+                if (!(a < c))
+                    continue;
+                const double right = sum - left;
+                const double gain = left * left / (double)k + right * right / (n - (double)k) - parent;
+                if (gain > b.gain) {
+                    b.feature = (std::int32_t)j;
+                    b.threshold = midpoint(a, c);
+                    b.gain = gain;
+                    b.n_left = k;
+                }
+            }
+        });
+        split<T> r;
+        for (auto& b : best)
+            if (b.gain > r.gain)
+                r = b;
+        return r;
+    }
+
+    // partitions the node by s (a split found for it), returns the left and
+    // right children
+    // Not to be called concurrently, the bitmask is shared.
+    template <typename Executor = thread_pool>
+    std::pair<node_range, node_range> apply_split(const node_range& node, const split<T>& s,
+        Executor& ex = par::default_executor())
+    {
+        assert(s.is_valid() && s.n_left > 0 && s.n_left < node.size());
+        const size_t mid = node.begin + s.n_left;
+        const size_t f = (size_t)s.feature;
+        // the column of the split feature is already partitioned
+        for (auto i : idx({ mid, node.end }, f))
+            right_bits[i / 64] |= std::uint64_t(1) << (i % 64);
+        ex.parallel_for(n_features(), [&](size_t j) {
+            if (j == f)
+                return;
+            std::uint32_t* c = idx.data() + j * n_samples();
+            memory::vector<std::uint32_t> right(memory::tracking_allocator<std::uint32_t>("splitter"));
+            right.reserve(node.end - mid);
+            size_t l = node.begin;
+            for (size_t k = node.begin; k < node.end; ++k) {
+                const std::uint32_t i = c[k];
+                if (right_bits[i / 64] >> (i % 64) & 1)
+                    right.push_back(i);
+                else
+                    c[l++] = i;
+            }
+            assert(l == mid);
+            std::copy(right.begin(), right.end(), c + mid);
+        });
+        for (auto i : idx({ mid, node.end }, f))
+            right_bits[i / 64] = 0;
+        return { { node.begin, mid }, { mid, node.end } };
+    }
+
+private:
+    // a threshold t with a <= t < c
+    static T midpoint(T a, T c)
+    {
+        const T t = a + (c - a) / 2;
+        return t < c ? t : a;
+    }
+
+    array_view<const T, 2> X;
+    multi_array<std::uint32_t, 2> idx; // fortran_order
+    memory::vector<std::uint64_t> right_bits; // all zero between apply_split calls
+};
+}
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef THREAD_POOL_INCLUDED_5517390264
+#define THREAD_POOL_INCLUDED_5517390264
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Work-stealing thread pool
+//
+//     sx::thread_pool pool(8);              // 7 workers + the thread that waits
+//     sx::task_group g(pool);
+//     g.run([&] { build_tree(0); });
+//     g.run([&] { build_tree(1); });
+//     g.wait();                             // runs tasks too, rethrows
+//
+//     pool.parallel_for(0, n, grain, [&](size_t b, size_t e) { ... });
+//
+// Each worker has its own deque: it pushes and pops its tasks at the back,
+// idle workers steal from the front of the others, where the older, bigger
+// tasks are. Threads that are not workers push to a shared queue.
+//
+// A thread waiting for a task group executes queued tasks until the group is
+// done, so nested parallelism (parallel_for inside a task) doesn't block
+// workers or start new threads. While there's nothing to run it sleeps until
+// a task is queued or the group finishes.
+//
+// thread_pool is an executor for the sx::par algorithms (see parallel.h).
+
+namespace sx {
+
+class thread_pool {
+public:
+    struct config {
+        // 0: std::thread::hardware_concurrency()
+        size_t n_threads = 0;
+        // if not empty, worker i is pinned to cpus[i % cpus.size()]
+        // (Linux only, best effort)
+        std::vector<int> cpus;
+    };
+
+    explicit thread_pool(size_t n_threads = 0)
+        : thread_pool(config{ n_threads, {} })
+    {
+    }
+    // the thread calling wait() counts as one of the n_threads so
+    // n_threads - 1 workers are started
+    explicit thread_pool(const config& c)
+    {
+        const size_t n = c.n_threads ? c.n_threads : std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < n; ++i)
+            queues.emplace_back(new queue);
+        threads.reserve(n - 1);
+        for (size_t i = 0; i + 1 < n; ++i) {
+            threads.emplace_back([this, i]() { worker_loop(i); });
+#ifdef __linux__
+            if (!c.cpus.empty()) {
+                cpu_set_t s;
+                CPU_ZERO(&s);
+                CPU_SET(c.cpus[i % c.cpus.size()], &s);
+                pthread_setaffinity_np(threads.back().native_handle(), sizeof(s), &s);
+            }
+#endif
+        }
+    }
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool()
+    {
+        stop = true;
+        wake(true);
+        for (auto& t : threads)
+            t.join();
+    }
+
+    size_t concurrency() const { return queues.size(); }
+
+    // calls f(b, e) for subranges of [first, last) no longer than `grain`
+    // the range is halved recursively, idle threads steal the halves
+    // grain == 0: a few times more subranges than threads
+    template <typename F>
+    void parallel_for(size_t first, size_t last, size_t grain, F&& f);
+
+    // executor interface: calls f(0), ..., f(n - 1), rethrows the first exception
+    template <typename F>
+    void parallel_for(size_t n, F&& f)
+    {
+        parallel_for(0, n, 1, [&f](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i)
+                f(i);
+        });
+    }
+
+private:
+    friend class task_group;
+    using task = std::function<void()>;
+
+    struct queue {
+        std::mutex m;
+        std::deque<task> tasks;
+    };
+
+    // the pool and the queue index of the current thread
+    static std::pair<const thread_pool*, size_t>& current()
+    {
+        static thread_local std::pair<const thread_pool*, size_t> c(nullptr, 0);
+        return c;
+    }
+    // a worker's own queue, the last (shared) one for other threads
+    size_t my_queue() const
+    {
+        auto& c = current();
+        return c.first == this ? c.second : queues.size() - 1;
+    }
+
+    void push(task t)
+    {
+        auto& q = *queues[my_queue()];
+        {
+            // counted before it's visible, so that it's never taken before
+            std::lock_guard<std::mutex> lock(q.m);
+            ++n_queued;
+            q.tasks.push_back(std::move(t));
+        }
+        wake(false);
+    }
+
+    void wake(bool all)
+    {
+        // taking the mutex orders this with a worker about to sleep
+        {
+            std::lock_guard<std::mutex> lock(sleep_m);
+        }
+        if (all)
+            sleep_cv.notify_all();
+        else
+            sleep_cv.notify_one();
+    }
+
+    // runs a queued task if there's any: the newest of the own queue or
+    // the oldest of another one
+    bool run_one()
+    {
+        const size_t n = queues.size(), self = my_queue();
+        task t;
+        {
+            auto& q = *queues[self];
+            std::lock_guard<std::mutex> lock(q.m);
+            if (!q.tasks.empty()) {
+                t = std::move(q.tasks.back());
+                q.tasks.pop_back();
+                --n_queued;
+            }
+        }
+        for (size_t k = 1; !t && k < n; ++k) {
+            auto& q = *queues[(self + k) % n];
+            std::lock_guard<std::mutex> lock(q.m);
+            if (!q.tasks.empty()) {
+                t = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                --n_queued;
+            }
+        }
+        if (!t)
+            return false;
+        t();
+        return true;
+    }
+
+    void worker_loop(size_t i)
+    {
+        current() = std::make_pair(this, i);
+        while (!stop) {
+            if (run_one())
+                continue;
+            std::unique_lock<std::mutex> lock(sleep_m);
+            sleep_cv.wait(lock, [this]() { return stop || n_queued > 0; });
+        }
+    }
+
+    std::vector<std::unique_ptr<queue> > queues; // one per worker + the shared one
+    std::vector<std::thread> threads;
+    std::atomic<size_t> n_queued{ 0 };
+    std::atomic<bool> stop{ false };
+    std::mutex sleep_m;
+    std::condition_variable sleep_cv;
+};
+
+// tasks run on a thread_pool, wait() returns when all of them finished
+class task_group {
+public:
+    explicit task_group(thread_pool& pool)
+        : pool(pool)
+    {
+    }
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+    ~task_group()
+    {
+        // the tasks refer to this object
+        join();
+    }
+
+    template <typename F>
+    void run(F&& f)
+    {
+        ++pending;
+        pool.push([this, &p = pool, f = std::forward<F>(f)]() mutable {
+            try {
+                f();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(error_m);
+                if (!error)
+                    error = std::current_exception();
+            }
+            // the group may be gone as soon as pending is 0
+            if (--pending == 0)
+                p.wake(true);
+        });
+    }
+
+    // runs queued tasks (of any group) until this group is done,
+    // then rethrows the first exception thrown by the tasks
+    void wait()
+    {
+        join();
+        if (error) {
+            auto e = error;
+            error = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+private:
+    // runs queued tasks until pending is 0, sleeps on the pool's condition
+    // variable while there's none: push and the last task of the group wake it
+    void join()
+    {
+        while (pending > 0) {
+            if (pool.run_one())
+                continue;
+            std::unique_lock<std::mutex> lock(pool.sleep_m);
+            pool.sleep_cv.wait(lock, [this]() { return pending == 0 || pool.n_queued > 0; });
+        }
+    }
+
+    thread_pool& pool;
+    std::atomic<size_t> pending{ 0 };
+    std::mutex error_m;
+    std::exception_ptr error;
+};
+
+namespace details {
+    // subranges per thread for parallel_for with automatic grain
+    static const size_t kSplitsPerThread = 8;
+
+    template <typename F>
+    void split_range(task_group& g, size_t b, size_t e, size_t grain, const F& f)
+    {
+        while (e - b > grain) {
+            const size_t m = b + (e - b) / 2;
+            g.run([&g, &f, m, e, grain]() { split_range(g, m, e, grain, f); });
+            e = m;
+        }
+        f(b, e);
+    }
+}
+
+template <typename F>
+void thread_pool::parallel_for(size_t first, size_t last, size_t grain, F&& f)
+{
+    if (last <= first)
+        return;
+    if (grain == 0)
+        grain = std::max<size_t>(1, (last - first) / (details::kSplitsPerThread * concurrency()));
+    task_group g(*this);
+    details::split_range(g, first, last, grain, f);
+    g.wait();
+}
+
+// used by the sx::par algorithms if no executor is given
+inline thread_pool& default_thread_pool()
+{
+    static thread_pool pool;
+    return pool;
+}
+}
+
+#endif
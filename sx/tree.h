@@ -0,0 +1,286 @@
+#ifndef TREE_INCLUDED_3386120574
+#define TREE_INCLUDED_3386120574
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "sx/array_view.h"
+#include "sx/multi_array.h"
+
+// Flattened binary decision tree
+//
+//     // arrays like scikit-learn's tree_.children_left, .children_right,
+//     // .feature, .threshold and .value (one row per node)
+//     sx::tree<float, double> t(left, right, feature, threshold, value);
+//     auto leaf = t.leaf_of(x);               // x: array_view<const float>
+//     auto y = t.value(leaf);                 // array_view<const double>
+//
+// The nodes are stored as a structure of arrays (feature index, threshold,
+// left and right child, row of the leaf value) in multi_arrays. A split node
+// sends x to the right if x(feature) > threshold, to the left otherwise (also
+// if it's NaN). A leaf is its own left and right child with feature 0 and an
+// infinite threshold, so walking a sample `depth() - 1` steps always ends in
+// its leaf, without testing for leaves. A split node has -1 as its leaf value
+// row. The root is node 0, children come after their parents.
+//
+// The node order is chosen when the tree is built:
+//
+// - breadth_first: level by level, the nodes near the root, visited by every
+//   sample, are packed together. The right child is next to the left one,
+//   right(i) == left(i) + 1 for split nodes.
+// - van_emde_boas: the top half of the levels is laid out recursively, followed
+//   by each of the subtrees hanging from it, also recursively. A root-to-leaf
+//   path touches O(log_B n) cache lines for any line size B.
+//
+// The leaf values are the rows of a contiguous c_order matrix, in the order of
+// the leaves in the node arrays.
+
+namespace sx {
+
+enum class tree_layout {
+    breadth_first,
+    van_emde_boas
+};
+
+namespace details {
+    inline size_t tree_levels(const std::vector<std::int32_t>& l, const std::vector<std::int32_t>& r)
+    {
+        size_t levels = 0;
+        std::vector<std::int32_t> level{ 0 }, next;
+        while (!level.empty()) {
+            ++levels;
+            next.clear();
+            for (auto i : level)
+                if (l[i] >= 0) {
+                    next.push_back(l[i]);
+                    next.push_back(r[i]);
+                }
+            level.swap(next);
+        }
+        return levels;
+    }
+
+    inline std::vector<std::int32_t> breadth_first_order(const std::vector<std::int32_t>& l,
+        const std::vector<std::int32_t>& r)
+    {
+        std::vector<std::int32_t> order{ 0 };
+        order.reserve(l.size());
+        for (size_t k = 0; k < order.size(); ++k) {
+            const auto i = order[k];
+            if (l[i] >= 0) {
+                order.push_back(l[i]);
+                order.push_back(r[i]);
+            }
+        }
+        return order;
+    }
+
+    // appends the nodes of the subtree of `root` which are less than `levels`
+    // deep, the top floor(levels / 2) levels first, then the subtrees below
+    // them, from left to right
+    inline void van_emde_boas_order(const std::vector<std::int32_t>& l, const std::vector<std::int32_t>& r,
+        std::int32_t root, size_t levels, std::vector<std::int32_t>& order)
+    {
+        if (levels == 1 || l[root] < 0) {
+            order.push_back(root);
+            return;
+        }
+        const size_t top = levels / 2;
+        van_emde_boas_order(l, r, root, top, order);
+        // the nodes `top` levels below root
+        std::vector<std::int32_t> level{ root }, next;
+        for (size_t d = 0; d < top; ++d) {
+            next.clear();
+            for (auto i : level)
+                if (l[i] >= 0) {
+                    next.push_back(l[i]);
+                    next.push_back(r[i]);
+                }
+            level.swap(next);
+        }
+        for (auto i : level)
+            van_emde_boas_order(l, r, i, levels - top, order);
+    }
+
+    inline std::vector<std::int32_t> van_emde_boas_order(const std::vector<std::int32_t>& l,
+        const std::vector<std::int32_t>& r)
+    {
+        std::vector<std::int32_t> order;
+        order.reserve(l.size());
+        van_emde_boas_order(l, r, 0, tree_levels(l, r), order);
+        return order;
+    }
+
+    // the largest T not above the threshold t, so that x > result <=> x > t
+    // for every x of type T (a plain conversion may round up)
+    template <typename T, typename U>
+    T narrow_threshold(U t, std::true_type /*floating point*/)
+    {
+        T r = (T)t;
+        if (r > t)
+            r = std::nextafter(r, -std::numeric_limits<T>::infinity());
+        return r;
+    }
+    template <typename T, typename U>
+    T narrow_threshold(U t, std::false_type)
+    {
+        T r = (T)t;
+        if (r > t)
+            --r;
+        return r;
+    }
+    template <typename T, typename U>
+    T narrow_threshold(U t)
+    {
+        return narrow_threshold<T>(t, std::is_floating_point<T>());
+    }
+}
+
+template <typename T, typename V = T>
+class tree {
+public:
+    using index_type = std::int32_t;
+    using threshold_type = T;
+    using value_type = V;
+
+    tree() = default;
+
+    // builds from per-node arrays in any order, the root is node 0:
+    // left(i), right(i): children of node i, negative or i for leaves
+    // feature(i), threshold(i): split of node i, ignored for leaves
+    // values(i, ..): output values of node i, only read for leaves
+    template <typename I, typename U, typename W>
+    tree(const array_view<I>& left, const array_view<I>& right, const array_view<I>& feature,
+        const array_view<U>& threshold, const array_view<W, 2>& values,
+        tree_layout layout = tree_layout::breadth_first)
+    {
+        const size_t n = left.extents(0);
+        assert(n > 0 && n < (size_t)INT32_MAX);
+        assert(right.extents(0) == n && feature.extents(0) == n && threshold.extents(0) == n
+            && values.extents(0) == n);
+        std::vector<index_type> l(n), r(n);
+        for (size_t i = 0; i < n; ++i) {
+            l[i] = (index_type)left(i) == (index_type)i ? -1 : (index_type)left(i);
+            r[i] = (index_type)right(i) == (index_type)i ? -1 : (index_type)right(i);
+            assert((l[i] < 0) == (r[i] < 0));
+        }
+        const auto order = layout == tree_layout::breadth_first
+            ? details::breadth_first_order(l, r)
+            : details::van_emde_boas_order(l, r);
+        assert(order.size() == n); // all nodes reachable from the root
+
+        std::vector<index_type> pos(n);
+        size_t n_leaves = 0;
+        for (size_t k = 0; k < n; ++k) {
+            pos[order[k]] = (index_type)k;
+            n_leaves += l[order[k]] < 0;
+        }
+
+        const size_t n_out = values.extents(1);
+        feat = multi_array<index_type, 1>(n);
+        thr = multi_array<T, 1>(n);
+        left_child = multi_array<index_type, 1>(n);
+        right_child = multi_array<index_type, 1>(n);
+        leaf_offset = multi_array<index_type, 1>(n);
+        leaf_vals = matrix<V>(typename matrix<V>::extents_type(n_leaves, n_out));
+        size_t leaf = 0;
+        for (size_t k = 0; k < n; ++k) {
+            const index_type i = order[k];
+            if (l[i] < 0) {
+                feat(k) = 0;
+                left_child(k) = right_child(k) = (index_type)k;
+                thr(k) = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+                                                              : std::numeric_limits<T>::max();
+                leaf_offset(k) = (index_type)leaf;
+                leaf_vals(leaf, sx::all) <<= values(i, sx::all);
+                ++leaf;
+            }
+            else {
+                feat(k) = (index_type)feature(i);
+                thr(k) = details::narrow_threshold<T>(threshold(i));
+                left_child(k) = pos[l[i]];
+                right_child(k) = pos[r[i]];
+                leaf_offset(k) = -1;
+            }
+        }
+        node_layout = layout;
+        n_levels = details::tree_levels(l, r);
+    }
+
+    // the same tree in another layout
+    tree(const tree& x, tree_layout layout)
+        : tree(x.left_child.view(), x.right_child.view(), x.feat.view(), x.thr.view(),
+              x.expanded_values().view(), layout)
+    {
+    }
+
+    size_t size() const { return feat.size(); }
+    bool empty() const { return feat.empty(); }
+    size_t n_leaves() const { return leaf_vals.extents(0); }
+    size_t n_outputs() const { return leaf_vals.extents(1); }
+    // number of levels, 1 for a single leaf
+    size_t depth() const { return n_levels; }
+    tree_layout layout() const { return node_layout; }
+
+    bool is_leaf(index_type i) const { return left_child(i) == i; }
+    index_type feature(index_type i) const { return feat(i); }
+    T threshold(index_type i) const { return thr(i); }
+    index_type left(index_type i) const { return left_child(i); }
+    index_type right(index_type i) const { return right_child(i); }
+    index_type value_offset(index_type i) const { return leaf_offset(i); }
+    // the output values of leaf i
+    array_view<const V> value(index_type i) const
+    {
+        assert(is_leaf(i));
+        return leaf_vals(leaf_offset(i), sx::all);
+    }
+
+    // the node arrays
+    array_view<const index_type> features() const { return feat.view(); }
+    array_view<const T> thresholds() const { return thr.view(); }
+    array_view<const index_type> children_left() const { return left_child.view(); }
+    array_view<const index_type> children_right() const { return right_child.view(); }
+    array_view<const index_type> value_offsets() const { return leaf_offset.view(); }
+    // n_leaves x n_outputs, c_order
+    array_view<const V, 2> values() const { return leaf_vals.view(); }
+
+    // the leaf reached by the sample x (a row of features)
+    template <typename U>
+    index_type leaf_of(const array_view<U>& x) const
+    {
+        const index_type* f = feat.data();
+        const T* t = thr.data();
+        const index_type* l = left_child.data();
+        const index_type* r = right_child.data();
+        index_type i = 0;
+        while (l[i] != i)
+            i = x(f[i]) > t[i] ? r[i] : l[i];
+        return i;
+    }
+
+private:
+    // values with a row for every node (zeros for split nodes)
+    matrix<V> expanded_values() const
+    {
+        matrix<V> R(typename matrix<V>::extents_type(size(), n_outputs()));
+        for (size_t i = 0; i < size(); ++i)
+            if (leaf_offset(i) >= 0)
+                R(i, sx::all) <<= leaf_vals(leaf_offset(i), sx::all);
+        return R;
+    }
+
+    multi_array<index_type, 1> feat, left_child, right_child, leaf_offset;
+    multi_array<T, 1> thr;
+    matrix<V> leaf_vals;
+    size_t n_levels = 0;
+    tree_layout node_layout = tree_layout::breadth_first;
+};
+
+}
+
+#endif
@@ -4,6 +4,14 @@
 #include <vector>
 #include "range/range_traits.hpp"
 
+// SX_PREFETCH(p): hint to fetch the cache line at `p` for reading
+// no-op on compilers without __builtin_prefetch
+#if defined(__GNUC__) || defined(__clang__)
+#define SX_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define SX_PREFETCH(p) ((void)(p))
+#endif
+
 namespace sx {
 
 template <typename T, typename Rng>
@@ -153,6 +153,10 @@ int main()
             auto it = std::lower_bound(a.begin(), a.end(), v[i]);
             CHECK((it - a.begin()) == r[i]);
         }
+
+        std::vector<unsigned> r2(v.size() + 1, 99);
+        auto e = sx::searchsorted(a, v, r2.begin());
+        CHECK((e == r2.end() - 1 && r2.back() == 99 && std::equal(r.begin(), r.end(), r2.begin())));
     }
 
     {
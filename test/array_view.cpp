@@ -1,4 +1,5 @@
 #include "sx/array_view.h"
+#include "sx/multi_array.h"
 #include "simple_test.hpp"
 
 int main(int argc, const char* argv[])
@@ -104,6 +105,87 @@ int main(int argc, const char* argv[])
             CHECK(x->empty() == false);
         }
     }
+    {
+        // slicing rank 1 and 2
+        std::array<int, 6> ab = { { 1, 2, 3, 4, 5, 6 } };
+        array_view<int> a(ab.data(), 6);
+        auto s = a({ 2, sx::end });
+        CHECK(s.extents(0) == 4);
+        CHECK(s(0) == 3);
+        array_view<int, 2> m(ab.data(), { 2, 3 }, sx::array_layout::c_order);
+        auto r = m(1, { 1, sx::end });
+        CHECK((r.extents(0) == 2 && r(0) == 5 && r(1) == 6));
+        auto c = m(sx::all, 2);
+        CHECK((c.extents(0) == 2 && c(1) == 6));
+    }
+    {
+        // any rank, mixing indices and slices
+        std::array<int, 24> ab;
+        for (int i = 0; i < 24; ++i)
+            ab[i] = i;
+        array_view<int, 3> t(ab.data(), { 2, 3, 4 }, sx::array_layout::c_order);
+        CHECK(t(1, 2, 3) == 23);
+        t(0, 1, 1) = 100;
+        CHECK(ab[5] == 100);
+        auto plane = t(1, sx::all, sx::all);
+        CHECK((plane.rank() == 2 && plane.extents(0) == 3 && plane.extents(1) == 4));
+        CHECK(plane(2, 0) == 20);
+        auto row = t(sx::all, 2, sx::slice_bounds{ 1, sx::length = 2 });
+        CHECK((row.extents(0) == 2 && row.extents(1) == 2));
+        CHECK((row(0, 0) == 9 && row(1, 1) == 22));
+        auto line = t(1, sx::slice_bounds{ 1, sx::end }, 3);
+        CHECK((line.rank() == 1 && line.extents(0) == 2 && line(1) == 23));
+        array_view<const int, 3> ct = t;
+        static_assert(std::is_same<decltype(ct(0, 0, 0)), const int&>::value, "");
+        CHECK(ct(1, 0, 0) == 12);
+
+        sx::multi_array<int, 3> ma(sx::multi_array<int, 3>::extents_type(2, 3, 4));
+        ma.view() <<= t;
+        CHECK(ma(1, 2, 3) == 23);
+        CHECK(ma(0, sx::all, 1)(1) == 100);
+        const auto& cma = ma;
+        CHECK(cma(sx::all, 0, 0)(1) == 12);
+    }
+    {
+        // slices with step
+        std::array<int, 6> ab = { { 1, 2, 3, 4, 5, 6 } };
+        array_view<int> a(ab.data(), 6);
+        auto ev = a({ 1, sx::end, 2 });
+        CHECK((ev.extents(0) == 3 && ev.strides(0) == 2 && ev(0) == 2 && ev(2) == 6));
+        auto rev = a({ 0, sx::end, -1 });
+        CHECK((rev.extents(0) == 6 && rev.strides(0) == -1 && rev(0) == 6 && rev(5) == 1));
+        auto odd_rev = a({ 0, sx::end, -2 });
+        CHECK((odd_rev.extents(0) == 3 && odd_rev(0) == 6 && odd_rev(2) == 2));
+        auto mid_rev = a({ 1, 5, -3 }); // indices 4, 1
+        CHECK((mid_rev.extents(0) == 2 && mid_rev(0) == 5 && mid_rev(1) == 2));
+        auto l = a({ 0, sx::length = 5, 3 });
+        CHECK((l.extents(0) == 2 && l(1) == 4));
+        auto rr = rev({ 0, sx::end, -1 });
+        CHECK((rr(0) == 1 && rr(5) == 6));
+        int sum = 0, first = 0;
+        for (auto x : rev) {
+            if (sum == 0)
+                first = x;
+            sum += x;
+        }
+        CHECK((sum == 21 && first == 6));
+
+        // copying from and to negative-strided views
+        std::array<int, 6> bb;
+        array_view<int> b(bb.data(), 6);
+        b <<= rev;
+        CHECK((bb == std::array<int, 6>{ { 6, 5, 4, 3, 2, 1 } }));
+        b({ 1, sx::end, -2 }) <<= ev;
+        CHECK((bb == std::array<int, 6>{ { 6, 6, 4, 4, 2, 2 } }));
+
+        array_view<int, 2> m(ab.data(), { 2, 3 }, sx::array_layout::c_order);
+        auto mr = m({ 0, sx::end, -1 }, { 0, sx::end, 2 });
+        CHECK((mr.extents(0) == 2 && mr.extents(1) == 2));
+        CHECK((mr(0, 0) == 4 && mr(0, 1) == 6 && mr(1, 0) == 1 && mr(1, 1) == 3));
+        sx::multi_array<int, 2> mc(sx::multi_array<int, 2>::extents_type(2, 2));
+        mc.view() <<= mr;
+        CHECK((mc(0, 0) == 4 && mc(1, 1) == 3));
+    }
     printf("\n");
     return test_result();
 }
@@ -0,0 +1,100 @@
+#include "sx/codegen.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <vector>
+#include "random_tree.h"
+#include "simple_test.hpp"
+
+// test-codegen --emit <header>: writes the test model (built into a module by CMake)
+// test-codegen <module>: checks the module against sx::predict
+
+static sx::forest<float, double> test_forest()
+{
+    std::mt19937 rng(5);
+    sx::forest<float, double> f;
+    for (int t = 0; t < 20; ++t)
+        f.push_back(random_tree(rng, 8, 5, 2));
+    return f;
+}
+
+int main(int argc, char* argv[])
+{
+    const auto f = test_forest();
+    if (argc == 3 && std::strcmp(argv[1], "--emit") == 0) {
+        std::ofstream os(argv[2]);
+        sx::write_compiled_forest(os, f, "codegen_test");
+        return os ? 0 : 1;
+    }
+
+    {
+        std::ostringstream os;
+        sx::write_compiled_forest(os, f, "m");
+        const auto s = os.str();
+        CHECK(s.find("namespace m {") != std::string::npos);
+        CHECK(s.find("constexpr std::size_t n_trees = 20;") != std::string::npos);
+        CHECK(s.find("inline void tree_19(") != std::string::npos);
+        CHECK(s.find("sx_compiled_forest()") != std::string::npos);
+    }
+    {
+        std::ostringstream os;
+        sx::details::write_literal(os, 1.0f);
+        os << " ";
+        sx::details::write_literal(os, 0.1);
+        os << " ";
+        sx::details::write_literal(os, -std::numeric_limits<double>::infinity());
+        CHECK(os.str() == "1.00000000f 0.10000000000000001 -std::numeric_limits<double>::infinity()");
+    }
+
+    bool threw = false;
+    try {
+        sx::compiled_forest m("no-such-module.so");
+    }
+    catch (std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    if (argc < 2)
+        return test_result();
+
+    sx::compiled_forest m(argv[1]);
+    CHECK((m.is_open() && m.n_trees() == 20 && m.n_outputs() == 2 && m.n_features() <= 5));
+
+    using E2 = sx::matrix<float>::extents_type;
+    const size_t n = 2000;
+    std::mt19937 rng(17);
+    sx::matrix<float> X(E2(n, 5), sx::array_layout::c_order);
+    sx::matrix<float> XF(E2(n, 5), sx::array_layout::fortran_order);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < 5; ++j)
+            XF(i, j) = X(i, j) = i == 0 ? std::numeric_limits<float>::quiet_NaN()
+                : i < 100 ? f[i % 20].threshold((std::int32_t)(rng() % f[i % 20].size()))
+                          : (float)(rng() % 110) / 10;
+
+    sx::par::sequential_executor seq;
+    sx::predict_options walk;
+    walk.mode = sx::inference::node_walk;
+    const auto E = sx::predict(f, X.view(), walk, seq);
+    auto same = [&](const sx::matrix<double>& P) {
+        bool ok = P.extents(0) == n && P.extents(1) == 2;
+        for (size_t i = 0; ok && i < n; ++i)
+            for (size_t o = 0; o < 2; ++o)
+                ok = ok && P(i, o) == E(i, o);
+        return ok;
+    };
+    CHECK(same(m.predict(X.view())));
+    CHECK(same(m.predict(XF.view())));
+
+    sx::compiled_forest m2(std::move(m));
+    CHECK((!m.is_open() && m2.is_open()));
+    std::vector<double> out(2);
+    m2.predict(X({ 7, sx::length = 1 }, sx::all), out.data());
+    CHECK((out[0] == E(7, 0) && out[1] == E(7, 1)));
+
+    return test_result();
+}
@@ -0,0 +1,146 @@
+#include "sx/column_store.h"
+
+#include <cstdio>
+#include <cmath>
+#include <sstream>
+#include <fstream>
+#include "simple_test.hpp"
+
+template <typename T>
+bool roundtrip(const std::vector<T>& x)
+{
+    std::vector<std::uint8_t> bytes;
+    sx::codec::encode_block(x.data(), x.size(), bytes);
+    std::vector<T> y(x.size());
+    auto p = sx::codec::decode_block(bytes.data(), y.size(), y.data());
+    return p == bytes.data() + bytes.size() && std::memcmp(x.data(), y.data(), x.size() * sizeof(T)) == 0;
+}
+
+int main()
+{
+    using sx::matrix;
+
+    // codecs
+    {
+        CHECK(roundtrip(std::vector<int>{}));
+        CHECK(roundtrip(std::vector<int>{ 5 }));
+        std::vector<std::int64_t> a;
+        for (int i = 0; i < 1000; ++i)
+            a.push_back(1000000 + i * 3 - (i % 7));
+        CHECK(roundtrip(a));
+        a[500] = INT64_MIN;
+        a[501] = INT64_MAX;
+        CHECK(roundtrip(a));
+
+        std::vector<std::uint8_t> bins;
+        for (int i = 0; i < 10000; ++i)
+            bins.push_back((std::uint8_t)((i * 7919) % 13));
+        CHECK(roundtrip(bins));
+        std::vector<std::uint8_t> bytes;
+        sx::codec::encode_block(bins.data(), bins.size(), bytes);
+        CHECK(bytes.size() <= bins.size() / 2 + 16); // 4 bits per value
+
+        std::vector<double> d;
+        for (int i = 0; i < 5000; ++i)
+            d.push_back(std::floor(std::sin(i * 0.01) * 100) / 4);
+        CHECK(roundtrip(d));
+        bytes.clear();
+        sx::codec::encode_block(d.data(), d.size(), bytes);
+        CHECK(bytes.size() < d.size() * sizeof(double));
+
+        std::vector<float> r;
+        unsigned s = 1;
+        for (int i = 0; i < 3000; ++i) {
+            s = s * 1103515245 + 12345;
+            r.push_back((float)s);
+        }
+        CHECK(roundtrip(r));
+        CHECK(roundtrip(std::vector<char>{ 1, 0, -1 }));
+    }
+
+    const size_t N = 1000, M = 5;
+    matrix<std::uint16_t> X(matrix<std::uint16_t>::extents_type(N, M), sx::array_layout::c_order);
+    for (size_t i = 0; i < N; ++i)
+        for (size_t j = 0; j < M; ++j)
+            X(i, j) = (std::uint16_t)((i / 3) * (j + 1) % 251);
+
+    auto check_equal = [&](const sx::column_store<std::uint16_t>& cs) {
+        bool ok = cs.rows() == N && cs.cols() == M;
+        for (size_t j = 0; ok && j < M; ++j) {
+            size_t rows = 0;
+            for (auto& blk : cs.column(j)) {
+                ok = ok && blk.first_row() == rows;
+                auto v = blk.view();
+                for (size_t i = 0; i < v.extents(0); ++i)
+                    ok = ok && v(i) == X(rows + i, j);
+                rows += blk.size();
+            }
+            ok = ok && rows == N;
+        }
+        return ok;
+    };
+
+    // in memory
+    {
+        sx::column_store<std::uint16_t> cs(X.view(), 128);
+        CHECK(cs.n_blocks() == 8);
+        CHECK(cs.block_size(7) == N - 7 * 128);
+        CHECK(check_equal(cs));
+        CHECK(cs.compressed_size() < N * M * sizeof(std::uint16_t));
+
+        cs.set_cache_size(2);
+        auto b0 = cs.block(1, 3);
+        auto b1 = cs.block(1, 3);
+        CHECK(b0.begin() == b1.begin());
+        cs.block(2, 0);
+        cs.block(2, 1);
+        cs.block(2, 2);
+        CHECK(b0.view()(5) == X(3 * 128 + 5, 1)); // still alive after eviction
+
+        std::vector<std::uint16_t> col(2 * N);
+        cs.decompress_column(4, sx::array_view<std::uint16_t>(col.data(), { N }, sx::array_view<std::uint16_t>::strides_type{ 2 }));
+        bool ok = true;
+        for (size_t i = 0; i < N; ++i)
+            ok = ok && col[2 * i] == X(i, 4);
+        CHECK(ok);
+    }
+
+    // save and open
+    {
+        const char* fn = "test-column-store-tmp.sxc";
+        sx::column_store<std::uint16_t>(X.view(), 100).save(fn);
+        sx::column_store<std::uint16_t> cs(fn);
+        CHECK(cs.block_rows() == 100);
+        CHECK(check_equal(cs));
+
+        bool thrown = false;
+        try {
+            sx::column_store<float> wrong(fn);
+        }
+        catch (const sx::column_store_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+        std::remove(fn);
+    }
+
+    // writer, appending blocks of different size
+    {
+        const char* fn = "test-column-store-tmp2.sxc";
+        {
+            std::ofstream f(fn, std::ios::binary);
+            sx::column_store_writer<std::uint16_t> w(f, M, 64);
+            for (size_t r = 0; r < N; r += 300) {
+                size_t n = std::min<size_t>(300, N - r);
+                w.append(sx::array_view<const std::uint16_t, 2>(&X(r, 0), { n, M }, { M, 1 }));
+            }
+            w.finish();
+        }
+        sx::column_store<std::uint16_t> cs(fn);
+        CHECK(cs.block_rows() == 64);
+        CHECK(check_equal(cs));
+        std::remove(fn);
+    }
+
+    return test_result();
+}
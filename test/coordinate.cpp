@@ -0,0 +1,69 @@
+#include "sx/coordinate.h"
+
+#include <vector>
+#include "sx/array_view.h"
+#include "simple_test.hpp"
+
+int main()
+{
+    using sx::bounds;
+    using sx::index;
+
+    // bounds_iterator: increments, jumps and end
+    {
+        bounds<3> b{ 3, 4, 5 };
+        std::vector<index<3> > all;
+        for (auto it = b.begin(); it != b.end(); ++it)
+            all.push_back(*it);
+        CHECK(all.size() == 60);
+        CHECK((all[7] == index<3>{ 0, 1, 2 }));
+
+        bool ok = true;
+        auto first = b.begin();
+        for (int i = 0; i <= 60; ++i)
+            for (int j = 0; j <= 60; ++j) {
+                auto it = first + i;
+                ok = ok && it - first == i && (i == 60 ? it == b.end() : *it == all[i]);
+                it += j - i;
+                ok = ok && it - first == j && (j == 60 ? it == b.end() : *it == all[j]);
+                ok = ok && ((first + i) < (first + j)) == (i < j);
+            }
+        CHECK(ok);
+        auto last = b.end();
+        --last;
+        CHECK((*last == index<3>{ 2, 3, 4 }));
+        CHECK((b.begin()[59] == index<3>{ 2, 3, 4 }));
+    }
+
+    // for_each_index visits the same indices as the iterator
+    {
+        bounds<3> b{ 2, 3, 4 };
+        std::vector<index<3> > v;
+        sx::for_each_index(b, [&v](const index<3>& i) { v.push_back(i); });
+        CHECK((v == std::vector<index<3> >(b.begin(), b.end())));
+        int n = 0;
+        sx::for_each_index(bounds<2>{ 3, 0 }, [&n](const index<2>&) { ++n; });
+        CHECK(n == 0);
+    }
+
+    // random access on array_view::iterator
+    {
+        std::vector<int> d(24);
+        for (int i = 0; i < 24; ++i)
+            d[i] = i;
+        sx::array_view<int, 3> x(d.data(), { 2, 3, 4 }, sx::array_layout::fortran_order);
+        auto b = x.begin();
+        bool ok = true;
+        for (int i = 0; i < 24; ++i)
+            for (int j = 0; j < 24; ++j) {
+                auto it = b + i;
+                ok = ok && *it == i && b[j] == j;
+                it += j - i;
+                ok = ok && *it == j && it - b == j;
+            }
+        CHECK(ok);
+        CHECK((b + 24 == x.end()));
+    }
+
+    return test_result();
+}
@@ -0,0 +1,149 @@
+#include "sx/criterion.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include "simple_test.hpp"
+
+using E2 = sx::matrix<double>::extents_type;
+
+static bool close(double a, double b)
+{
+    return std::abs(a - b) <= 1e-11 * std::max(1.0, std::abs(b));
+}
+
+int main()
+{
+    // log_positive
+    {
+        bool ok = true;
+        std::mt19937_64 rng(1);
+        for (int k = 0; k < 100000; ++k) {
+            const double x = std::ldexp(1 + (double)(rng() >> 11) / 9007199254740992.0, (int)(rng() % 2000) - 1000);
+            const double a = sx::details::log_positive(x), b = std::log(x);
+            ok = ok && std::abs(a - b) <= 4 * std::numeric_limits<double>::epsilon() * std::max(1.0, std::abs(b));
+        }
+        for (double x : { 1.0, 2.0, 0.5, 1e-300, 1e300, std::sqrt(0.5), std::sqrt(2.0) })
+            ok = ok && std::abs(sx::details::log_positive(x) - std::log(x)) <= 1e-15 * std::max(1.0, std::abs(std::log(x)));
+        CHECK(ok);
+        CHECK(sx::details::log_positive(1.0) == 0);
+        CHECK((sx::details::xlogx(0) == 0 && std::abs(sx::details::xlogx(-1e-13)) < 1e-9));
+    }
+
+    // cumulative class counts of a node with 4 classes, 300 candidates
+    std::mt19937 rng(2);
+    const size_t m = 300, nc = 4;
+    sx::matrix<double> L(E2(m, nc), sx::array_layout::c_order);
+    std::vector<double> total(nc);
+    for (size_t i = 0; i < m; ++i) {
+        const size_t c = i == 0 ? 0 : rng() % nc;
+        for (size_t k = 0; k < nc; ++k)
+            L(i, k) = total[k] + (k == c ? (double)(1 + rng() % 3) : 0.0);
+        for (size_t k = 0; k < nc; ++k)
+            total[k] = L(i, k);
+    }
+    for (size_t k = 0; k < nc; ++k)
+        total[k] += 1; // every candidate has samples on the right
+    for (size_t k = 0; k < nc; ++k)
+        L(0, k) = 0; // but not always on the left
+    const sx::array_view<const double, 2> Lv(L.view());
+    const auto tv = sx::make_array_view(total);
+    double n = 0;
+    for (auto t : total)
+        n += t;
+
+    sx::thread_pool pool(3);
+    sx::par::sequential_executor seq;
+    {
+        auto p = sx::gini_proxy(Lv, tv, seq);
+        auto q = sx::gini_proxy(Lv, tv, pool);
+        bool ok = p.size() == m && q.size() == m;
+        for (size_t i = 0; ok && i < m; ++i) {
+            double nl = 0, sl = 0, sr = 0;
+            for (size_t k = 0; k < nc; ++k) {
+                nl += L(i, k);
+                sl += L(i, k) * L(i, k);
+                sr += (total[k] - L(i, k)) * (total[k] - L(i, k));
+            }
+            const double e = (nl > 0 ? sl / nl : 0) + sr / (n - nl);
+            ok = close(p(i), e) && p(i) == q(i);
+        }
+        CHECK(ok);
+        // L in fortran_order, the same values
+        sx::matrix<double> Lf(E2(m, nc), sx::array_layout::fortran_order);
+        Lf.view() <<= L.view();
+        auto f = sx::gini_proxy(sx::array_view<const double, 2>(Lf.view()), tv, seq);
+        for (size_t i = 0; i < m; ++i)
+            ok = ok && f(i) == p(i);
+        CHECK(ok);
+    }
+    {
+        auto p = sx::entropy_proxy(Lv, tv, seq);
+        auto q = sx::entropy_proxy(Lv, tv, pool);
+        auto xlx = [](double x) { return x > 0 ? x * std::log(x) : 0.0; };
+        bool ok = p.size() == m;
+        for (size_t i = 0; ok && i < m; ++i) {
+            double nl = 0, s = 0;
+            for (size_t k = 0; k < nc; ++k) {
+                nl += L(i, k);
+                s += xlx(L(i, k)) + xlx(total[k] - L(i, k));
+            }
+            ok = close(p(i), s - xlx(nl) - xlx(n - nl)) && p(i) == q(i);
+        }
+        CHECK(ok);
+    }
+    // the proxies rank like the impurity decrease
+    {
+        auto p = sx::gini_proxy(Lv, tv);
+        auto gini = [](const double* c, size_t k, double w) {
+            double s = 0;
+            for (size_t j = 0; j < k; ++j)
+                s += (c[j] / w) * (c[j] / w);
+            return 1 - s;
+        };
+        size_t best_p = 1, best_d = 1;
+        double best_dv = -std::numeric_limits<double>::infinity();
+        for (size_t i = 1; i < m; ++i) {
+            double nl = 0, r[nc];
+            for (size_t k = 0; k < nc; ++k) {
+                nl += L(i, k);
+                r[k] = total[k] - L(i, k);
+            }
+            const double d = -(nl * gini(&L(i, 0), nc, nl) + (n - nl) * gini(r, nc, n - nl));
+            if (d > best_dv + 1e-9) {
+                best_dv = d;
+                best_d = i;
+            }
+            if (p(i) > p(best_p) + 1e-9)
+                best_p = i;
+        }
+        CHECK(best_p == best_d);
+    }
+    // regression, 2 outputs
+    {
+        sx::matrix<double> S(E2(m, 2), sx::array_layout::fortran_order);
+        std::vector<double> nl(m), t(2);
+        double w = 0;
+        for (size_t i = 0; i < m; ++i) {
+            w += 1;
+            for (size_t o = 0; o < 2; ++o)
+                S(i, o) = t[o] += (double)(rng() % 100) / 10 - 5;
+            nl[i] = w;
+        }
+        t[0] += 1;
+        t[1] -= 2;
+        auto p = sx::mse_proxy(sx::array_view<const double, 2>(S.view()), sx::make_array_view(nl),
+            sx::make_array_view(t), w + 1, pool);
+        bool ok = p.size() == m;
+        for (size_t i = 0; ok && i < m; ++i) {
+            double e = 0;
+            for (size_t o = 0; o < 2; ++o)
+                e += S(i, o) * S(i, o) / nl[i] + (t[o] - S(i, o)) * (t[o] - S(i, o)) / (w + 1 - nl[i]);
+            ok = close(p(i), e);
+        }
+        CHECK(ok);
+    }
+
+    return test_result();
+}
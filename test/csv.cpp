@@ -0,0 +1,181 @@
+#include "sx/csv.h"
+
+#include <cstdio>
+#include <cmath>
+#include <sstream>
+#include <fstream>
+#include "simple_test.hpp"
+
+int main()
+{
+    using sx::matrix;
+
+    // number parsing, fast and slow path
+    {
+        const char* cases[] = { "0", "-1", "+2.5", "3.", ".25", "1e3", "1.5E-3", "-0.001",
+            "123456789012345678901234", "1e300", "2.2250738585072014e-308",
+            "0.1", "7.0e22", "9007199254740993" };
+        for (auto c : cases) {
+            const char* p = c;
+            const char* e = c + strlen(c);
+            double d = 0;
+            CHECK(sx::details::parse_number(p, e, d));
+            CHECK(p == e);
+            CHECK(d == strtod(c, nullptr));
+        }
+        const char* p = "nan";
+        double d = 0;
+        CHECK(sx::details::parse_number(p, p + 3, d));
+        CHECK(std::isnan(d));
+        p = "x1";
+        CHECK(!sx::details::parse_number(p, p + 2, d));
+        int i = 0;
+        p = "-42";
+        CHECK(sx::details::parse_number(p, p + 3, i));
+        CHECK(i == -42);
+    }
+
+    const std::string text = "a,b,c\n"
+                             "1,2,3\n"
+                             "\n"
+                             "# comment\n"
+                             "4, 5.5 ,6\r\n"
+                             "-7,8e1,9";
+
+    // parse into a new matrix
+    {
+        sx::csv_options opts;
+        opts.skip_rows = 1;
+        auto m = sx::parse_csv<double>(text.data(), text.data() + text.size(), opts);
+        CHECK(m.extents(0) == 3);
+        CHECK(m.extents(1) == 3);
+        CHECK(m.strides(1) == 1);
+        CHECK(m(0, 0) == 1.0);
+        CHECK(m(1, 1) == 5.5);
+        CHECK(m(2, 0) == -7.0);
+        CHECK(m(2, 1) == 80.0);
+        CHECK(m(2, 2) == 9.0);
+
+        opts.layout = sx::array_layout::fortran_order;
+        auto f = sx::parse_csv<float>(text.data(), text.data() + text.size(), opts);
+        CHECK(f.strides(0) == 1);
+        CHECK(f(1, 1) == 5.5f);
+        CHECK(f(2, 2) == 9.0f);
+    }
+
+    // errors
+    {
+        sx::csv_options opts;
+        bool thrown = false;
+        try {
+            sx::parse_csv<double>(text.data(), text.data() + text.size(), opts);
+        }
+        catch (const sx::csv_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+
+        // integers out of range
+        for (const std::string big : { "99999999999999999999\n", "2147483648\n", "-2147483649\n" }) {
+            thrown = false;
+            try {
+                sx::parse_csv<int>(big.data(), big.data() + big.size());
+            }
+            catch (const sx::csv_error&) {
+                thrown = true;
+            }
+            CHECK(thrown);
+        }
+        const std::string lim = "2147483647,-2147483648\n";
+        auto li = sx::parse_csv<int>(lim.data(), lim.data() + lim.size());
+        CHECK((li(0, 0) == 2147483647 && li(0, 1) == -2147483647 - 1));
+        const std::string u = "18446744073709551615\n";
+        CHECK(sx::parse_csv<std::uint64_t>(u.data(), u.data() + u.size())(0, 0) == UINT64_MAX);
+
+        const std::string bad = "1,2\n3\n";
+        thrown = false;
+        try {
+            sx::parse_csv<double>(bad.data(), bad.data() + bad.size());
+        }
+        catch (const sx::csv_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+
+    // floats just above and below the midpoint of 1 and the next float,
+    // the nearest double is the midpoint itself
+    {
+        const std::string t = "1.0000000596046447753906250001,1.0000000596046447753906249999,"
+                              "1.000000059604644775390625,1e-40\n";
+        auto f = sx::parse_csv<float>(t.data(), t.data() + t.size());
+        CHECK((f(0, 0) == std::nextafter(1.0f, 2.0f) && f(0, 1) == 1.0f && f(0, 2) == 1.0f));
+        CHECK(f(0, 3) == std::strtof("1e-40", nullptr));
+    }
+
+    // tab and whitespace delimiters
+    {
+        const std::string tsv = "1\t2\n3\t4\n";
+        sx::csv_options opts;
+        opts.delimiter = '\t';
+        auto m = sx::parse_csv<int>(tsv.data(), tsv.data() + tsv.size(), opts);
+        CHECK(m.extents(0) == 2);
+        CHECK(m(1, 1) == 4);
+
+        const std::string ws = "  1   2\n3 4  \n";
+        opts.delimiter = ' ';
+        m = sx::parse_csv<int>(ws.data(), ws.data() + ws.size(), opts);
+        CHECK(m.extents(1) == 2);
+        CHECK(m(0, 1) == 2);
+        CHECK(m(1, 0) == 3);
+    }
+
+    // large file, parallel, into a pre-sized matrix
+    {
+        const size_t N = 50000, M = 7;
+        const char* fn = "test-csv-tmp.csv";
+        {
+            std::ofstream f(fn);
+            f.precision(17);
+            for (size_t i = 0; i < N; ++i) {
+                for (size_t j = 0; j < M; ++j)
+                    f << (j ? "," : "") << (double)(i * M + j) / 8;
+                f << "\n";
+            }
+        }
+        sx::thread_pool pool(4);
+        matrix<double> m({ N, M }, sx::array_layout::fortran_order);
+        sx::load_csv(fn, m.view(), sx::csv_options(), pool);
+        bool ok = true;
+        for (size_t i = 0; i < N; ++i)
+            for (size_t j = 0; j < M; ++j)
+                ok = ok && m(i, j) == (double)(i * M + j) / 8;
+        CHECK(ok);
+
+        sx::par::sequential_executor seq;
+        auto m2 = sx::load_csv<double>(fn, sx::csv_options(), seq);
+        CHECK(m2.extents(0) == N);
+        CHECK(m2(N - 1, M - 1) == m(N - 1, M - 1));
+        std::remove(fn);
+    }
+
+    // streaming
+    {
+        std::istringstream is(text);
+        sx::csv_options opts;
+        opts.skip_rows = 1;
+        sx::csv_reader<double> r(is, 2, opts);
+        sx::matrix_view<const double> block;
+        CHECK(r.next(block));
+        CHECK(block.extents(0) == 2);
+        CHECK(block.extents(1) == 3);
+        CHECK(block(1, 2) == 6.0);
+        CHECK(r.next(block));
+        CHECK(block.extents(0) == 1);
+        CHECK(block(0, 1) == 80.0);
+        CHECK(!r.next(block));
+        CHECK(r.rows_so_far() == 3);
+    }
+
+    return test_result();
+}
@@ -0,0 +1,75 @@
+#include "sx/elementwise.h"
+
+#include <functional>
+#include "sx/multi_array.h"
+#include "simple_test.hpp"
+
+int main()
+{
+    using sx::array_view;
+    using sx::matrix;
+    using E2 = matrix<float>::extents_type;
+
+    // broadcast_to, expand_dims
+    {
+        std::vector<float> mean = { 1, 2, 3 };
+        auto m = sx::make_array_view(mean);
+        auto b = sx::broadcast_to(m, E2(4, 3));
+        CHECK((b.extents(0) == 4 && b.extents(1) == 3 && b.strides(0) == 0 && b.strides(1) == 1));
+        CHECK((b(3, 2) == 3 && b(0, 1) == 2));
+        auto c = sx::expand_dims(m, 1);
+        CHECK((c.extents(0) == 3 && c.extents(1) == 1));
+        auto bc = sx::broadcast_to(c, E2(3, 5));
+        CHECK((bc.strides(1) == 0 && bc(2, 4) == 3 && bc(1, 0) == 2));
+        auto r = sx::expand_dims(m, 0);
+        CHECK((r.extents(0) == 1 && r.extents(1) == 3 && r(0, 2) == 3));
+        int n = 0;
+        for (auto x : b)
+            n += (int)x;
+        CHECK(n == 24);
+
+        // materializing a broadcast view
+        matrix<float> M(E2(4, 3), sx::array_layout::fortran_order);
+        M.view() <<= b;
+        CHECK((M(0, 0) == 1 && M(3, 2) == 3 && M(2, 1) == 2));
+    }
+
+    // centering and scaling the columns, in both layouts
+    for (auto layout : { sx::array_layout::c_order, sx::array_layout::fortran_order }) {
+        matrix<float> X(E2(5, 3), layout);
+        for (size_t i = 0; i < 5; ++i)
+            for (size_t j = 0; j < 3; ++j)
+                X(i, j) = (float)(i * 10 + j);
+        std::vector<float> mean = { 20, 21, 22 }, scale = { 2, 4, 8 };
+        auto mv = sx::broadcast_to(sx::make_array_view(mean), X.extents());
+        auto sv = sx::broadcast_to(sx::make_array_view(scale), X.extents());
+        sx::transform(X.view(), X.view(), mv, std::minus<>());
+        sx::transform(X.view(), X.view(), sv, std::divides<>());
+        CHECK((X(0, 0) == -10 && X(4, 1) == 5 && X(2, 2) == 0 && X(3, 2) == 1.25f));
+
+        auto sum = sx::accumulate(X.view(), 0.0, std::plus<>());
+        CHECK(sum == 0);
+
+        matrix<float> Y(E2(5, 3));
+        sx::transform(Y.view(), X.view(), [](float x) { return x * x; });
+        CHECK(Y(0, 0) == 100);
+        sx::transform(Y.view(), sv, [](float x) { return -x; });
+        CHECK((Y(4, 0) == -2 && Y(0, 2) == -8));
+        sx::transform(Y.view(), mv, sv, std::plus<>());
+        CHECK((Y(1, 0) == 22 && Y(3, 2) == 30));
+    }
+
+    // accumulate over broadcast and negative-strided views
+    {
+        std::vector<int> v = { 1, 2, 3, 4 };
+        auto a = sx::make_array_view(v);
+        CHECK(sx::accumulate(a({ 0, sx::end, -1 }), 0, std::plus<>()) == 10);
+        auto b = sx::broadcast_to(a, sx::details::extents_template<3>(2, 3, 4));
+        CHECK(sx::accumulate(b, 0, std::plus<>()) == 60);
+        int x = 7;
+        auto s = sx::broadcast_to(array_view<int>(&x, 1), sx::details::extents_template<2>(3, 4));
+        CHECK(sx::accumulate(s, 0, std::plus<>()) == 84);
+    }
+
+    return test_result();
+}
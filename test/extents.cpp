@@ -0,0 +1,87 @@
+#include "sx/extents.h"
+
+#include <vector>
+#include "simple_test.hpp"
+
+int main()
+{
+    using sx::dynamic;
+    using sx::extents;
+
+    // extents
+    {
+        using E = extents<3, dynamic, 4>;
+        static_assert(E::rank() == 3, "");
+        static_assert(E::rank_dynamic() == 1, "");
+        static_assert(E::static_extent(0) == 3, "");
+        static_assert(sizeof(extents<3, 3>) == sizeof(size_t), "");
+        constexpr extents<2, 5> s;
+        static_assert(s.size() == 10, "");
+        static_assert(s.extent<1>() == 5, "");
+
+        E e(7);
+        CHECK(e.extent(1) == 7);
+        CHECK(e.extent<2>() == 4);
+        CHECK(e.size() == 84);
+        CHECK(e == E(std::array<size_t, 3>{ { 3, 7, 4 } }));
+        CHECK(e != E(6));
+    }
+
+    // views, layouts
+    {
+        std::vector<int> buf(3 * 5);
+        for (size_t i = 0; i < buf.size(); ++i)
+            buf[i] = (int)i;
+        sx::fixed_view<int, extents<3, dynamic> > r(buf.data(), 5);
+        CHECK(r.extents(1) == 5);
+        CHECK(r.strides(0) == 5);
+        CHECK(r(2, 1) == 11);
+        sx::fixed_view<int, extents<dynamic, 3>, sx::layout_left> l(buf.data(), 5);
+        CHECK(l.strides(1) == 5);
+        CHECK(l(1, 2) == 11);
+        CHECK((l[{ { 4, 0 } }] == 4));
+
+        std::vector<size_t> order;
+        l.for_each([&](int x) { order.push_back((size_t)x); });
+        bool ok = order.size() == 15;
+        for (size_t i = 0; i < order.size(); ++i)
+            ok = ok && order[i] == i;
+        CHECK(ok);
+
+        // conversion to and from array_view
+        sx::array_view<int, 2> av = r;
+        CHECK(av.strides(0) == 5);
+        CHECK(av(2, 4) == 14);
+        sx::array_view<const int, 2> cav = av;
+        sx::fixed_view<const int, extents<3, 5> > fv(cav);
+        CHECK(fv(1, 1) == 6);
+    }
+
+    // fixed_array, copies
+    {
+        sx::fixed_array<double, 3, 3> A{};
+        CHECK(A.size() == 9);
+        A.fill(1.0);
+        A(1, 2) = 5.0;
+        sx::fixed_array<double, 3, 3> B{};
+        sx::fixed_view<double, extents<3, 3>, sx::layout_left> Bt(B.data());
+        Bt <<= A.view();
+        CHECK(B(2, 1) == 5.0);
+        CHECK(B(0, 0) == 1.0);
+        double s = 0;
+        B.view().for_each([&s](double x) { s += x; });
+        CHECK(s == 13.0);
+
+        sx::fixed_array<float, 2, 20> C{};
+        C.view().fill(2.0f);
+        CHECK((C(1, 19) == 2.0f && C(0, 0) == 2.0f));
+
+        int n = 0;
+        sx::for_each_index(extents<2, dynamic, 2>(3), [&n](const std::array<size_t, 3>& i) {
+            n += (int)(i[0] * 100 + i[1] * 10 + i[2]);
+        });
+        CHECK(n == 600 + 120 + 6);
+    }
+
+    return test_result();
+}
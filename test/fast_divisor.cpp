@@ -0,0 +1,39 @@
+#include "sx/fast_divisor.h"
+
+#include <cstdint>
+#include <random>
+#include "simple_test.hpp"
+
+int main()
+{
+    std::mt19937_64 rng(5);
+    const std::uint64_t special[] = { 0, 1, 2, 3, 7, 1000, UINT32_MAX, (std::uint64_t)UINT32_MAX + 1,
+        UINT64_MAX / 2, UINT64_MAX / 2 + 1, UINT64_MAX - 1, UINT64_MAX };
+    bool ok = true;
+    auto check = [&](std::uint64_t d) {
+        sx::fast_divisor f(d);
+        ok = ok && f.divisor() == d;
+        for (auto n : special) {
+            std::uint64_t r;
+            ok = ok && f.quotient(n) == n / d && f.divmod(n, r) == n / d && r == n % d;
+        }
+        for (int i = 0; i < 100; ++i) {
+            auto n = rng() >> (rng() % 64);
+            ok = ok && f.quotient(n) == n / d;
+        }
+    };
+    for (std::uint64_t d = 1; d < 2000; ++d)
+        check(d);
+    for (auto d : special)
+        if (d > 0)
+            check(d);
+    for (int i = 0; i < 2000; ++i) {
+        auto d = rng() >> (rng() % 64);
+        if (d > 0)
+            check(d);
+    }
+    CHECK(ok);
+    CHECK(sx::fast_divisor().quotient(12345) == 12345);
+
+    return test_result();
+}
@@ -0,0 +1,128 @@
+#include "sx/forest.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "random_tree.h"
+#include "simple_test.hpp"
+
+using tree_t = sx::tree<float, double>;
+
+int main()
+{
+    std::mt19937 rng(11);
+    std::vector<tree_t> trees;
+    for (int t = 0; t < 12; ++t)
+        trees.push_back(random_tree(rng, 10, 6, 3, t % 2 ? sx::tree_layout::van_emde_boas : sx::tree_layout::breadth_first));
+    sx::forest<float, double> f(std::move(trees));
+    f.push_back(random_tree(rng, 0, 6, 3, sx::tree_layout::breadth_first)); // a single leaf
+    CHECK((f.size() == 13 && f.n_outputs() == 3 && f.node_bytes() > 0));
+
+    using E2 = sx::matrix<float>::extents_type;
+    const size_t n = 1000;
+    sx::matrix<float> X(E2(n, 6), sx::array_layout::c_order);
+    sx::matrix<float> XF(E2(n, 6), sx::array_layout::fortran_order);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < 6; ++j)
+            XF(i, j) = X(i, j) = (float)(rng() % 110) / 10;
+
+    // per-sample reference
+    sx::matrix<double> E(E2(n, 3), 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        auto x = X(i, sx::all);
+        for (auto& t : f) {
+            auto v = t.value(t.leaf_of(x));
+            for (size_t o = 0; o < 3; ++o)
+                E(i, o) += v(o) / f.size();
+        }
+    }
+    auto close = [&](const sx::matrix<double>& P) {
+        bool ok = P.extents(0) == n && P.extents(1) == 3;
+        for (size_t i = 0; ok && i < n; ++i)
+            for (size_t o = 0; o < 3; ++o)
+                ok = ok && std::abs(P(i, o) - E(i, o)) < 1e-12;
+        return ok;
+    };
+
+    sx::thread_pool pool(3);
+    sx::par::sequential_executor seq;
+    sx::predict_options tiny; // trees don't fit, tree-by-tree in large blocks
+    tiny.cache_bytes = 4096;
+    tiny.block_rows = 7;
+    CHECK(close(sx::predict(f, X.view())));
+    CHECK(close(sx::predict(f, XF.view(), sx::predict_options(), pool)));
+    CHECK(close(sx::predict(f, X.view(), tiny, seq)));
+    CHECK(close(sx::predict(f, XF.view(), tiny, pool)));
+    CHECK(close(sx::predict(f, X({ 0, sx::end }, { 0, sx::end }), tiny, pool)));
+
+    auto y = sx::predict_class(f, X.view());
+    bool ok = y.extents(0) == n;
+    for (size_t i = 0; i < n; ++i) {
+        size_t best = 0;
+        for (size_t o = 1; o < 3; ++o)
+            if (E(i, o) > E(i, best))
+                best = o;
+        ok = ok && y(i) == best;
+    }
+    CHECK(ok);
+
+    // shallow trees, QuickScorer: 3 blocks of trees
+    {
+        sx::forest<float, double> g;
+        for (int t = 0; t < 70; ++t)
+            g.push_back(random_tree(rng, t == 0 ? 6 : t % 6, 6, 3, t % 2 ? sx::tree_layout::van_emde_boas : sx::tree_layout::breadth_first));
+        CHECK((g.depth() <= 7 && g.supports_quickscorer()));
+        sx::matrix<double> EG(E2(n, 3), 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            auto x = XF(i, sx::all);
+            for (auto& t : g) {
+                auto v = t.value(t.leaf_of(x));
+                for (size_t o = 0; o < 3; ++o)
+                    EG(i, o) += v(o) / g.size();
+            }
+        }
+        auto close_g = [&](const sx::matrix<double>& P) {
+            bool ok = P.extents(0) == n && P.extents(1) == 3;
+            for (size_t i = 0; ok && i < n; ++i)
+                for (size_t o = 0; o < 3; ++o)
+                    ok = ok && std::abs(P(i, o) - EG(i, o)) < 1e-12;
+            return ok;
+        };
+        sx::predict_options walk, qs, qs_rows, automatic;
+        automatic.quickscorer_max_depth = 7;
+        walk.mode = sx::inference::node_walk;
+        qs.mode = sx::inference::quickscorer;
+        qs.block_rows = 5;
+        qs_rows.mode = sx::inference::quickscorer;
+        qs_rows.block_rows = 300; // several blocks of samples
+        CHECK(close_g(sx::predict(g, X.view())));
+        CHECK(close_g(sx::predict(g, X.view(), automatic)));
+        CHECK(close_g(sx::predict(g, XF.view(), walk, seq)));
+        CHECK(close_g(sx::predict(g, XF.view(), qs, pool)));
+        CHECK(close_g(sx::predict(g, sx::array_view<const float, 2>(X.view()), qs_rows, seq)));
+        CHECK(g.quickscorer_model().n_trees() == 70);
+
+        // thresholds equal to x, NaN goes left
+        std::vector<float> xs = { 5.0f, std::nanf(""), 0, 10, 2.5f, 7.5f };
+        for (size_t j = 0; j < 6; ++j)
+            xs[j] = g[0].thresholds()(0);
+        xs[1] = std::nanf("");
+        sx::array_view<float, 2> x1(xs.data(), { 1, 6 }, sx::array_layout::c_order);
+        auto p1 = sx::predict(g, x1, walk), p2 = sx::predict(g, x1, qs);
+        CHECK((p1(0, 0) == p2(0, 0) && p1(0, 2) == p2(0, 2)));
+
+        // model rebuilt after push_back, qs mode falls back for deep trees
+        tree_t deep;
+        do
+            deep = random_tree(rng, 12, 6, 3, sx::tree_layout::breadth_first);
+        while (deep.n_leaves() <= 64);
+        g.push_back(std::move(deep));
+        CHECK(!g.supports_quickscorer());
+        CHECK(sx::predict(g, X.view(), qs).extents(0) == n);
+    }
+
+    CHECK(sx::predict(f, X({ 0, sx::length = 0 }, sx::all)).extents(0) == 0);
+    CHECK(sx::predict(sx::forest<float, double>(), X.view()).extents(1) == 0);
+
+    return test_result();
+}
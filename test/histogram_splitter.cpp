@@ -0,0 +1,184 @@
+#include "sx/histogram_splitter.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "simple_test.hpp"
+
+using E2 = sx::matrix<std::uint8_t>::extents_type;
+using node_t = sx::histogram_splitter::node;
+
+static const size_t n_bins = 16;
+
+// the histogram of the node computed directly
+static bool same_histograms(const sx::histogram_splitter& sp, const node_t& n, const sx::matrix<std::uint8_t>& Xb,
+    const std::vector<double>& g, const std::vector<double>& h)
+{
+    bool ok = true;
+    for (size_t j = 0; j < sp.n_features(); ++j) {
+        std::vector<double> G(n_bins), H(n_bins), N(n_bins);
+        for (auto i : sp.samples(n)) {
+            G[Xb(i, j)] += g[i];
+            H[Xb(i, j)] += h[i];
+            N[Xb(i, j)] += 1;
+        }
+        auto g2 = sp.gradient_histogram(n, j), h2 = sp.hessian_histogram(n, j), n2 = sp.count_histogram(n, j);
+        for (size_t b = 0; b < n_bins; ++b)
+            ok = ok && std::abs(g2(b) - G[b]) < 1e-9 && std::abs(h2(b) - H[b]) < 1e-9 && n2(b) == N[b];
+    }
+    return ok;
+}
+
+// the best split by trying all thresholds, same tie-breaking
+static sx::split<std::uint8_t> reference_split(const sx::histogram_splitter& sp, const node_t& n,
+    const sx::matrix<std::uint8_t>& Xb, const std::vector<double>& g, const std::vector<double>& h,
+    const sx::split_options& opts)
+{
+    sx::split<std::uint8_t> r;
+    double G = 0, H = 0;
+    for (auto i : sp.samples(n)) {
+        G += g[i];
+        H += h[i];
+    }
+    const double l2 = opts.l2_regularization;
+    for (size_t j = 0; j < sp.n_features(); ++j)
+        for (size_t t = 0; t + 1 < n_bins; ++t) {
+            double gl = 0, hl = 0;
+            size_t nl = 0;
+            for (auto i : sp.samples(n))
+                if (Xb(i, j) <= t) {
+                    gl += g[i];
+                    hl += h[i];
+                    ++nl;
+                }
+            const size_t nr = n.size() - nl;
+            if (nl < opts.min_samples_leaf || nr < opts.min_samples_leaf || hl < opts.min_hessian_leaf
+                || H - hl < opts.min_hessian_leaf || !(hl + l2 > 0) || !(H - hl + l2 > 0))
+                continue;
+            const double gain = gl * gl / (hl + l2) + (G - gl) * (G - gl) / (H - hl + l2) - G * G / (H + l2);
+            if (gain > r.gain + 1e-9) {
+                r.feature = (std::int32_t)j;
+                r.threshold = (std::uint8_t)t;
+                r.gain = gain;
+                r.n_left = nl;
+            }
+        }
+    return r;
+}
+
+template <typename Executor>
+static bool grow(sx::histogram_splitter& sp, const node_t& n, const sx::matrix<std::uint8_t>& Xb,
+    const std::vector<double>& g, const std::vector<double>& h, const sx::split_options& opts, int depth,
+    Executor& ex, int& n_nodes)
+{
+    ++n_nodes;
+    bool ok = same_histograms(sp, n, Xb, g, h);
+    auto s = sp.find_split(n, opts, ex);
+    if (depth == 0 || !s.is_valid()) {
+        sp.release(n);
+        return ok;
+    }
+    auto e = reference_split(sp, n, Xb, g, h, opts);
+    ok = ok && s.feature == e.feature && s.threshold == e.threshold && s.n_left == e.n_left
+        && std::abs(s.gain - e.gain) < 1e-6;
+    auto c = sp.apply_split(n, s, sx::make_array_view(g), sx::make_array_view(h), ex);
+    for (auto i : sp.samples(c.first))
+        ok = ok && Xb(i, s.feature) <= s.threshold;
+    for (auto i : sp.samples(c.second))
+        ok = ok && Xb(i, s.feature) > s.threshold;
+    ok = ok && grow(sp, c.first, Xb, g, h, opts, depth - 1, ex, n_nodes);
+    ok = ok && grow(sp, c.second, Xb, g, h, opts, depth - 1, ex, n_nodes);
+    return ok;
+}
+
+int main()
+{
+    std::mt19937 rng(9);
+    const size_t n = 3000;
+    sx::matrix<std::uint8_t> Xb(E2(n, 5), sx::array_layout::c_order);
+    std::vector<double> g(n), h(n), ones(n, 1.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < 5; ++j)
+            Xb(i, j) = (std::uint8_t)(j == 4 ? 3 : rng() % n_bins); // feature 4 is constant
+        g[i] = (Xb(i, 1) > 7 ? 2.0 : -2.0) + (Xb(i, 0) > 4 ? 1.0 : 0.0) + (Xb(i, 2) > 10 ? 0.5 : 0.0)
+            + (double)(rng() % 100) / 100 - 0.5;
+        h[i] = 0.25 + (double)(rng() % 100) / 400;
+    }
+    const sx::array_view<const std::uint8_t, 2> Xv(Xb.view());
+
+    sx::thread_pool pool(3);
+    sx::par::sequential_executor seq;
+    sx::split_options opts;
+    opts.min_samples_leaf = 20;
+    opts.min_hessian_leaf = 5;
+    opts.l2_regularization = 1;
+    {
+        sx::histogram_splitter sp(Xv, n_bins);
+        auto root = sp.root();
+        sp.build_histogram(root, sx::make_array_view(g), sx::make_array_view(h), seq);
+        int n_nodes = 0;
+        CHECK(grow(sp, root, Xb, g, h, opts, 5, seq, n_nodes));
+        CHECK(n_nodes > 10);
+        // every node released, the slots were reused
+        CHECK((sp.histograms().size() == 0 && sp.histograms().capacity() <= 7));
+    }
+    {
+        sx::histogram_splitter sp(Xv, n_bins);
+        auto root = sp.root();
+        sp.build_histogram(root, sx::make_array_view(g), sx::make_array_view(h), pool);
+        auto s = sp.find_split(root, opts, pool);
+        CHECK((s.feature == 1 && s.threshold == 7));
+        int n_nodes = 0;
+        CHECK(grow(sp, root, Xb, g, h, opts, 4, pool, n_nodes));
+    }
+
+    // unit hessians, no regularization: the gains of presorted_splitter
+    {
+        sx::matrix<float> X(sx::matrix<float>::extents_type(n, 5), sx::array_layout::c_order);
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j < 5; ++j)
+                X(i, j) = Xb(i, j);
+        sx::presorted_splitter<float> ps(sx::array_view<const float, 2>(X.view()));
+        sx::histogram_splitter sp(Xv, n_bins);
+        sp.build_histogram(sp.root(), sx::make_array_view(g), sx::make_array_view(ones));
+        auto a = ps.find_split(ps.root(), sx::make_array_view(g));
+        auto b = sp.find_split(sp.root());
+        CHECK((a.feature == b.feature && a.n_left == b.n_left && std::abs(a.gain - b.gain) < 1e-6));
+        CHECK((a.threshold > b.threshold && a.threshold < b.threshold + 1));
+    }
+
+    // zero hessians and no regularization: thresholds leaving a child without
+    // hessian would have an infinite gain, they aren't candidates
+    {
+        std::vector<double> hz(n);
+        for (size_t i = 0; i < n; ++i)
+            hz[i] = Xb(i, 1) <= 2 ? 0.0 : h[i];
+        sx::histogram_splitter sp(Xv, n_bins);
+        sp.build_histogram(sp.root(), sx::make_array_view(g), sx::make_array_view(hz));
+        auto s = sp.find_split(sp.root(), sx::split_options(), seq);
+        CHECK((s.is_valid() && std::isfinite(s.gain)));
+        CHECK(!(s.feature == 1 && s.threshold <= 2));
+        auto e = reference_split(sp, sp.root(), Xb, g, hz, sx::split_options());
+        CHECK((s.feature == e.feature && s.threshold == e.threshold && std::abs(s.gain - e.gain) < 1e-6));
+
+        std::vector<double> zeros(n);
+        sp.release(sp.root());
+        sp.build_histogram(sp.root(), sx::make_array_view(g), sx::make_array_view(zeros));
+        CHECK(!sp.find_split(sp.root()).is_valid());
+    }
+
+    // histogram_pool
+    {
+        sx::histogram_pool hp(4);
+        double* a = hp.acquire(1);
+        a[0] = 5;
+        CHECK((hp.find(1) == a && hp.find(2) == nullptr));
+        hp.rekey(1, 2);
+        CHECK((hp.find(1) == nullptr && hp.find(2) == a && hp.find(2)[0] == 5));
+        hp.release(2);
+        double* b = hp.acquire(3);
+        CHECK((b == a && b[0] == 0 && hp.size() == 1 && hp.capacity() == 1));
+    }
+
+    return test_result();
+}
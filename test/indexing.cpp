@@ -0,0 +1,132 @@
+#include "sx/indexing.h"
+
+#include <vector>
+#include "simple_test.hpp"
+
+int main()
+{
+    using sx::matrix;
+    using sx::multi_array;
+    using E2 = matrix<int>::extents_type;
+
+    matrix<int> X(E2(5, 4));
+    for (size_t i = 0; i < 5; ++i)
+        for (size_t j = 0; j < 4; ++j)
+            X(i, j) = (int)(10 * i + j);
+
+    // rows and columns
+    {
+        std::vector<int> rows = { 4, 0, 2, 2 };
+        auto R = sx::take(X, rows);
+        CHECK(R.extents(0) == 4);
+        CHECK(R.extents(1) == 4);
+        CHECK(R(0, 3) == 43);
+        CHECK(R(1, 1) == 1);
+        CHECK(R(3, 2) == 22);
+
+        std::vector<size_t> cols = { 3, 1 };
+        auto C = sx::take(X, cols, 1, sx::array_layout::fortran_order);
+        CHECK(C.extents(0) == 5);
+        CHECK(C.extents(1) == 2);
+        CHECK(C(2, 0) == 23);
+        CHECK(C(4, 1) == 41);
+
+        // from a strided (transposed) source
+        matrix<int> Xt(E2(4, 5), sx::array_layout::fortran_order);
+        for (size_t i = 0; i < 5; ++i)
+            for (size_t j = 0; j < 4; ++j)
+                Xt(j, i) = X(i, j);
+        auto T = sx::take(Xt, rows, 1);
+        CHECK((T(3, 0) == 43 && T(2, 3) == 22));
+
+        std::vector<int> none;
+        auto Z = sx::take(X, none);
+        CHECK((Z.extents(0) == 0 && Z.extents(1) == 4));
+    }
+
+    // 1-D and 3-D
+    {
+        std::vector<double> v(1000);
+        for (size_t i = 0; i < v.size(); ++i)
+            v[i] = (double)i / 2;
+        std::vector<unsigned> idx;
+        for (unsigned i = 0; i < 101; ++i)
+            idx.push_back((i * 37) % 1000);
+        auto t = sx::take(sx::make_array_view(v), idx);
+        bool ok = t.extents(0) == idx.size();
+        for (size_t i = 0; i < idx.size(); ++i)
+            ok = ok && t(i) == v[idx[i]];
+        CHECK(ok);
+
+        multi_array<int, 3> A(multi_array<int, 3>::extents_type(2, 3, 4));
+        int c = 0;
+        for (auto& a : A)
+            a = c++;
+        std::vector<int> mid = { 2, 0 };
+        auto B = sx::take(A, mid, 1);
+        CHECK(B.extents(1) == 2);
+        CHECK((B[{ 1, 0, 3 }] == A[{ 1, 2, 3 }]));
+        CHECK((B[{ 0, 1, 2 }] == A[{ 0, 0, 2 }]));
+    }
+
+    // large unsorted gather (takes the sorted-order path) and scatter back
+    {
+        const size_t N = 1 << 20;
+        std::vector<float> v(N);
+        for (size_t i = 0; i < N; ++i)
+            v[i] = (float)i;
+        std::vector<std::uint32_t> idx(N / 8);
+        std::uint32_t s = 1;
+        for (auto& i : idx) {
+            s = s * 1664525u + 1013904223u;
+            i = s % N;
+        }
+        auto g = sx::take(sx::make_array_view(v), idx);
+        bool ok = true;
+        for (size_t i = 0; i < idx.size(); ++i)
+            ok = ok && g(i) == (float)idx[i];
+        CHECK(ok);
+
+        std::vector<float> w(N, -1.0f);
+        sx::put(sx::make_array_view(w), idx, g.view());
+        ok = true;
+        for (size_t i = 0; i < idx.size(); ++i)
+            ok = ok && w[idx[i]] == (float)idx[i];
+        CHECK(ok);
+    }
+
+    // put rows, last one wins
+    {
+        matrix<int> Y(E2(3, 4), 0);
+        std::vector<int> rows = { 2, 0, 2 };
+        auto S = sx::take(X, std::vector<int>{ 1, 3, 4 });
+        sx::put(Y, rows, S);
+        CHECK(Y(0, 2) == 32);
+        CHECK(Y(2, 1) == 41);
+        CHECK(Y(1, 1) == 0);
+    }
+
+    // lazy view
+    {
+        std::vector<int> rows = { 3, 1 };
+        auto v = sx::indexed(X, rows);
+        CHECK((v.extents(0) == 2 && v.extents(1) == 4));
+        CHECK(v.size() == 8);
+        CHECK(v(1, 2) == 12);
+        v(0, 0) = 99;
+        CHECK(X(3, 0) == 99);
+        X(3, 0) = 30;
+
+        std::vector<int> flat(v.begin(), v.end());
+        CHECK(flat.size() == 8);
+        CHECK((flat[0] == 30 && flat[3] == 33 && flat[4] == 10 && flat[7] == 13));
+
+        auto m = v.materialize();
+        CHECK(m(1, 3) == 13);
+
+        auto c = sx::indexed(X, rows, 1);
+        CHECK((c.extents(0) == 5 && c(4, 0) == 43));
+    }
+
+    return test_result();
+}
@@ -0,0 +1,74 @@
+#define SX_INSTRUMENT 1
+
+#include "sx/instrument.h"
+
+#include <vector>
+#include "sx/algorithm.h"
+#include "sx/reduce.h"
+#include "sx/sort.h"
+#include "simple_test.hpp"
+
+static const sx::instrument::kernel_stats* find(const std::vector<sx::instrument::kernel_stats>& v,
+    const char* kernel)
+{
+    for (auto& s : v)
+        if (s.kernel == kernel)
+            return &s;
+    return nullptr;
+}
+
+int main()
+{
+    using sx::instrument::path;
+    using E2 = sx::matrix<float>::extents_type;
+
+    sx::matrix<float> X(E2(30, 4), sx::array_layout::c_order);
+    for (size_t i = 0; i < 30; ++i)
+        for (size_t j = 0; j < 4; ++j)
+            X(i, j) = (float)((i * 7 + j * 3) % 11);
+
+    sx::instrument::reset();
+    sx::matrix<float> Y(E2(30, 4), sx::array_layout::c_order);
+    Y.view() <<= X.view(); // contiguous
+    Y.view() <<= sx::matrix<float>(E2(30, 4), sx::array_layout::fortran_order).view(); // strided
+    auto P = sx::sortperm<int>(X.view(), 0); // strided along dim 0
+    auto M = sx::indmax_along(X.view(), 1); // contiguous
+    std::vector<int> y = { 0, 2, 2, 1, 5 };
+    auto c1 = sx::bincount<size_t>(y);
+    auto c2 = sx::par::bincount(sx::make_array_view(y));
+    auto ss = sx::searchsorted<size_t>(std::vector<int>{ 1, 3, 5 }, y);
+
+    auto s = sx::instrument::snapshot();
+    auto copy = find(s, "copy");
+    CHECK(copy != nullptr);
+    CHECK(copy->calls == 2);
+    CHECK(copy->elements == 240);
+    CHECK(copy->bytes == 240 * 8);
+    CHECK((copy->paths[(size_t)path::contiguous] == 1 && copy->paths[(size_t)path::strided] == 1));
+
+    auto sp = find(s, "sortperm");
+    CHECK((sp && sp->calls == 1 && sp->elements == 120 && sp->paths[(size_t)path::strided] == 1));
+    auto im = find(s, "indmax_along");
+    CHECK((im && im->calls == 1 && im->paths[(size_t)path::contiguous] == 1));
+    auto bc = find(s, "bincount");
+    CHECK((bc && bc->calls == 1 && bc->elements == 5 && bc->paths[(size_t)path::fallback] == 1));
+    auto pbc = find(s, "par::bincount");
+    CHECK((pbc && pbc->calls == 1 && pbc->paths[(size_t)path::contiguous] == 1));
+    auto sr = find(s, "searchsorted");
+    CHECK((sr && sr->calls == 1 && sr->elements == 5));
+
+    // Y, the fortran temporary, P and M at least
+    auto ma = find(s, "multi_array allocation");
+    CHECK((ma && ma->calls >= 4));
+
+    auto text = sx::instrument::to_text(s);
+    CHECK(text.find("copy calls=2 elements=240 bytes=1920 ") != std::string::npos);
+    CHECK(text.find("contiguous=1 strided=1 fallback=0\n") != std::string::npos);
+
+    sx::instrument::reset();
+    s = sx::instrument::snapshot();
+    CHECK((find(s, "copy")->calls == 0 && find(s, "copy")->nanoseconds == 0));
+    (void)c1, (void)c2, (void)ss, (void)P, (void)M;
+
+    return test_result();
+}
@@ -0,0 +1,120 @@
+#include "sx/memory.h"
+
+#include <thread>
+#include <vector>
+#include "sx/algorithm.h"
+#include "sx/multi_array.h"
+#include "sx/reduce.h"
+#include "sx/sort.h"
+#include "simple_test.hpp"
+
+static const sx::memory::stats* find(const std::vector<sx::memory::stats>& v, const char* site)
+{
+    for (auto& s : v)
+        if (s.site == site)
+            return &s;
+    return nullptr;
+}
+
+int main()
+{
+    using E2 = sx::matrix<float>::extents_type;
+
+    // multi_array, live and peak bytes
+    sx::memory::reset();
+    const auto live0 = sx::memory::totals().live_bytes;
+    {
+        sx::matrix<float> A(E2(100, 10));
+        CHECK(sx::memory::totals().live_bytes == live0 + 4000);
+        sx::matrix<float> B(A); // copy
+        sx::matrix<float> C(std::move(B)); // no allocation
+        auto s = sx::memory::snapshot();
+        auto ma = find(s, "multi_array");
+        CHECK((ma && ma->count == 2 && ma->live_bytes >= 8000));
+    }
+    auto t = sx::memory::totals();
+    CHECK((t.live_bytes == live0 && t.peak_bytes >= live0 + 8000 && t.total_bytes == 8000));
+
+    // per call site
+    sx::matrix<float> X(E2(50, 8), sx::array_layout::fortran_order);
+    for (size_t i = 0; i < 50; ++i)
+        for (size_t j = 0; j < 8; ++j)
+            X(i, j) = (float)((i * 13 + j) % 7);
+    sx::memory::reset();
+    {
+        auto P = sx::sortperm<int>(X.view(), 0);
+        auto s = sx::memory::snapshot();
+        // the packed keys of each column, the result is a multi_array
+        auto sp = find(s, "sortperm");
+        CHECK((sp && sp->count == 8 && sp->live_bytes == 0 && sp->peak_bytes == 50 * sizeof(std::uint64_t)));
+        auto ma = find(s, "multi_array");
+        CHECK((ma && ma->count == 1 && ma->total_bytes == 50 * 8 * sizeof(int)));
+    }
+    // a caller's site gets all of them
+    {
+        sx::memory::site fit("fit");
+        auto P = sx::sortperm<int>(X.view(), 0);
+        auto pc = sx::par::bincount(sx::make_array_view(std::vector<int>(100000, 3)));
+        auto s = sx::memory::snapshot();
+        auto f = find(s, "fit");
+        CHECK((f && f->count >= 10 && f->live_bytes == 50 * 8 * sizeof(int)));
+        CHECK((find(s, "sortperm")->count == 8 && !find(s, "par::bincount")));
+    }
+    std::vector<int> y = { 1, 4, 4, 0 };
+    auto c = sx::bincount<size_t>(y);
+    auto pc = sx::par::bincount(sx::make_array_view(y));
+    auto ss = sx::searchsorted<size_t>(std::vector<int>{ 0, 2 }, y);
+    {
+        auto s = sx::memory::snapshot();
+        auto bc = find(s, "bincount");
+        CHECK((bc && bc->count == 1 && bc->total_bytes == 5 * sizeof(size_t) && bc->live_bytes == 0));
+        auto pbc = find(s, "par::bincount");
+        CHECK((pbc && pbc->count >= 1 && pbc->live_bytes == 0));
+        auto sr = find(s, "searchsorted");
+        CHECK((sr && sr->total_bytes == 4 * sizeof(size_t)));
+    }
+
+    // nested sites, other threads have their own
+    sx::memory::reset();
+    {
+        sx::memory::site outer("outer");
+        sx::memory::vector<double> a(10);
+        std::thread th([] { sx::memory::vector<double> b(3); });
+        th.join();
+        {
+            sx::memory::site inner("inner");
+            sx::memory::vector<double> b(20);
+            sx::matrix<float> M(E2(2, 2));
+        }
+        auto s = sx::memory::snapshot();
+        CHECK((find(s, "outer")->total_bytes == 80 && find(s, "inner")->total_bytes == 160 + 16));
+        CHECK(find(s, "scratch")->total_bytes == 24);
+    }
+
+    // budget
+    sx::memory::set_budget(sx::memory::totals().live_bytes + 10000);
+    CHECK(sx::memory::budget() > 0);
+    bool thrown = false;
+    try {
+        sx::matrix<double> big(E2(100, 100));
+    }
+    catch (const sx::memory::budget_exceeded& e) {
+        thrown = std::string(e.what()).find("multi_array") != std::string::npos;
+    }
+    CHECK(thrown);
+    thrown = false;
+    try {
+        auto P = sx::sortperm<int>(sx::matrix<float>(E2(2000, 1)).view(), 0);
+    }
+    catch (const std::bad_alloc&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    sx::matrix<double> small(E2(10, 10)); // fits
+    sx::memory::set_budget(0);
+    CHECK(sx::memory::budget() == 0);
+    sx::matrix<double> big(E2(100, 100));
+    (void)c, (void)pc, (void)ss;
+
+    return test_result();
+}
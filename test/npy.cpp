@@ -0,0 +1,153 @@
+#include "sx/npy.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "simple_test.hpp"
+
+int main()
+{
+    using sx::array_view;
+    using sx::multi_array;
+
+    // header
+    {
+        const size_t shape[] = { 2, 3 };
+        auto h = sx::format_npy_header("<f8", false, shape, 2);
+        CHECK((h.size() % 64) == 0);
+        CHECK(h.back() == '\n');
+        auto p = sx::parse_npy_header(h.data(), h.size());
+        CHECK(p.descr == "<f8");
+        CHECK(p.fortran_order == false);
+        CHECK(p.shape.size() == 2);
+        CHECK(p.shape[0] == 2);
+        CHECK(p.shape[1] == 3);
+        CHECK(p.data_offset == h.size());
+
+        const size_t shape1[] = { 5 };
+        h = sx::format_npy_header("|u1", true, shape1, 1);
+        CHECK(h.find("(5,)") != std::string::npos);
+        p = sx::parse_npy_header(h.data(), h.size());
+        CHECK(p.descr == "|u1");
+        CHECK(p.fortran_order == true);
+        CHECK(p.shape.size() == 1);
+        CHECK(p.shape[0] == 5);
+
+        // as written by numpy 1.x
+        const char np[] = "\x93NUMPY\x01\x00\x46\x00"
+                          "{'descr': '<i4', 'fortran_order': False, 'shape': (4, 1, 7), }       \n";
+        p = sx::parse_npy_header(np, sizeof(np) - 1);
+        CHECK(p.descr == "<i4");
+        CHECK(p.shape.size() == 3);
+        CHECK(p.shape[2] == 7);
+        CHECK(p.data_offset == 80);
+
+        bool thrown = false;
+        try {
+            sx::parse_npy_header("NUMPY", 5);
+        }
+        catch (const sx::npy_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+
+        // shapes which overflow size_t
+        auto parse_fails = [](const std::string& shape) {
+            const std::string dict = "{'descr': '<f8', 'fortran_order': False, 'shape': " + shape + ", }\n";
+            std::string h = std::string("\x93NUMPY\x01\x00", 8) + (char)dict.size() + '\0' + dict;
+            try {
+                sx::parse_npy_header(h.data(), h.size());
+            }
+            catch (const sx::npy_error&) {
+                return true;
+            }
+            return false;
+        };
+        CHECK(parse_fails("(123456789012345678901234567890,)"));
+        CHECK(parse_fails("(4294967296, 4294967296, 0)"));
+        CHECK(!parse_fails("(0, 3)"));
+    }
+
+    CHECK(sx::npy_dtype<float>::descr() == "<f4");
+    CHECK(sx::npy_dtype<double>::descr() == "<f8");
+    CHECK(sx::npy_dtype<std::int32_t>::descr() == "<i4");
+    CHECK(sx::npy_dtype<std::uint8_t>::descr() == "|u1");
+    CHECK(sx::npy_dtype<bool>::descr() == "|b1");
+
+    multi_array<double, 2> m({ 3, 4 }, sx::array_layout::c_order);
+    for (size_t i = 0; i < 3; ++i)
+        for (size_t j = 0; j < 4; ++j)
+            m(i, j) = i * 10.0 + j;
+
+    const char* fn = "test-npy-tmp.npy";
+
+    // contiguous c_order
+    {
+        sx::save_npy(fn, m.view());
+        sx::mapped_npy f(fn);
+        CHECK(f.header().fortran_order == false);
+        auto v = f.view<double, 2>();
+        CHECK(v.extents(0) == 3);
+        CHECK(v.extents(1) == 4);
+        for (size_t i = 0; i < 3; ++i)
+            for (size_t j = 0; j < 4; ++j)
+                CHECK(v(i, j) == m(i, j));
+        bool thrown = false;
+        try {
+            f.view<float, 2>();
+        }
+        catch (const sx::npy_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+
+    // contiguous fortran_order is written as is
+    {
+        multi_array<double, 2> mf({ 3, 4 }, sx::array_layout::fortran_order);
+        mf.view() <<= m.view();
+        sx::save_npy(fn, mf.view());
+        auto r = sx::load_npy<double, 2>(fn);
+        CHECK(r.strides(0) == 1);
+        CHECK(r.strides(1) == 3);
+        for (size_t i = 0; i < 3; ++i)
+            for (size_t j = 0; j < 4; ++j)
+                CHECK(r(i, j) == m(i, j));
+    }
+
+    // strided view is streamed in c_order
+    {
+        auto s = m(sx::slice_bounds(0, sx::end), sx::slice_bounds(1, 3));
+        std::ostringstream os;
+        sx::save_npy(os, s);
+        auto str = os.str();
+        auto h = sx::parse_npy_header(str.data(), str.size());
+        CHECK(h.fortran_order == false);
+        CHECK(str.size() == h.data_offset + 6 * sizeof(double));
+        const double* d = reinterpret_cast<const double*>(str.data() + h.data_offset);
+        for (size_t i = 0; i < 3; ++i)
+            for (size_t j = 0; j < 2; ++j)
+                CHECK(d[i * 2 + j] == m(i, j + 1));
+    }
+
+    // a shape whose byte size wraps around doesn't pass the size check
+    {
+        const size_t shape[] = { (size_t)1 << 61 };
+        {
+            std::ofstream os(fn, std::ios::binary);
+            os << sx::format_npy_header("<f8", false, shape, 1) << std::string(64, '\0');
+        }
+        sx::mapped_npy f(fn);
+        bool thrown = false;
+        try {
+            f.view<double, 1>();
+        }
+        catch (const sx::npy_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+
+    std::remove(fn);
+    return test_result();
+}
@@ -0,0 +1,90 @@
+#include "sx/parallel.h"
+
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include "sx/multi_array.h"
+#include "simple_test.hpp"
+
+int main()
+{
+    using sx::array_view;
+    using E3 = sx::multi_array<int, 3>::extents_type;
+
+    sx::par::thread_executor ex3(3);
+    sx::par::sequential_executor seq;
+    sx::par::options small; // many chunks, some of them splitting runs
+    small.grain_bytes = 7 * sizeof(int);
+    sx::par::options det;
+    det.deterministic = true;
+    det.grain_bytes = 64;
+
+    for (auto layout : { sx::array_layout::c_order, sx::array_layout::fortran_order }) {
+        sx::multi_array<int, 3> A(E3(5, 6, 7), layout), B(E3(5, 6, 7), layout);
+        std::vector<int> expected;
+        int k = 0;
+        for (size_t i = 0; i < 5; ++i)
+            for (size_t j = 0; j < 6; ++j)
+                for (size_t l = 0; l < 7; ++l)
+                    A(i, j, l) = k++;
+
+        // fill + for_each
+        sx::par::fill(B.view(), 3, small, ex3);
+        std::atomic<int> sum(0);
+        sx::par::for_each(B.view(), [&sum](int& x) { sum += x; }, small, ex3);
+        CHECK(sum == 3 * 210);
+
+        // copy from a view with reversed and strided dimensions
+        auto src = A(sx::slice_bounds{ 0, sx::end, -1 }, sx::all, sx::all);
+        sx::par::copy(B.view(), src, small, ex3);
+        bool ok = true;
+        for (size_t i = 0; i < 5; ++i)
+            for (size_t j = 0; j < 6; ++j)
+                for (size_t l = 0; l < 7; ++l)
+                    ok = ok && B(i, j, l) == A(4 - i, j, l);
+        CHECK(ok);
+
+        // transform, with a broadcast operand
+        std::vector<int> offs = { 100, 200, 300, 400, 500, 600, 700 };
+        auto bo = sx::broadcast_to(sx::make_array_view(offs), A.extents());
+        for (auto* o : { &small, &det }) {
+            sx::par::transform(B.view(), A.view(), bo, std::plus<>(), *o, ex3);
+            ok = true;
+            for (size_t i = 0; i < 5; ++i)
+                for (size_t j = 0; j < 6; ++j)
+                    for (size_t l = 0; l < 7; ++l)
+                        ok = ok && B(i, j, l) == A(i, j, l) + (int)(l + 1) * 100;
+            CHECK(ok);
+        }
+        sx::par::transform(B.view(), A.view(), [](int x) { return -x; }, small, seq);
+        CHECK((B(4, 5, 6) == -209 && B(1, 0, 0) == -42));
+        sx::par::transform(B.view(), A.view(), [](int x) { return 2 * x; });
+        CHECK(B(4, 5, 6) == 418);
+    }
+
+    // every chunk is visited exactly once, whatever the chunking
+    {
+        std::vector<int> v(100003, 0);
+        auto x = sx::make_array_view(v);
+        sx::par::for_each(x, [](int& y) { ++y; });
+        sx::par::for_each(x, [](int& y) { ++y; }, small, ex3);
+        sx::par::for_each(x, [](int& y) { ++y; }, det, ex3);
+        CHECK(std::all_of(v.begin(), v.end(), [](int y) { return y == 3; }));
+    }
+
+    // exceptions are rethrown on the calling thread
+    {
+        std::vector<int> v(1000, 0);
+        bool thrown = false;
+        try {
+            sx::par::for_each(sx::make_array_view(v), [](int&) { throw std::runtime_error("x"); },
+                small, ex3);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+
+    return test_result();
+}
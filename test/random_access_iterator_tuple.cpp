@@ -0,0 +1,84 @@
+#include "sx/random_access_iterator_tuple.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "simple_test.hpp"
+
+int main()
+{
+    using sx::make_random_access_iterator_tuple;
+    using sx::less_by;
+
+    const int N = 1000;
+    std::vector<double> x;
+    std::vector<int> idx;
+    std::vector<float> w;
+    std::vector<std::string> label;
+    for (int i = 0; i < N; ++i) {
+        x.push_back((double)((i * 7919) % 101));
+        idx.push_back(i);
+        w.push_back((float)i / 2);
+        label.push_back(std::to_string(i));
+    }
+
+    auto consistent = [&]() {
+        bool ok = true;
+        for (int i = 0; i < N; ++i) {
+            int k = idx[i];
+            ok = ok && x[i] == (double)((k * 7919) % 101) && w[i] == (float)k / 2
+                && label[i] == std::to_string(k);
+        }
+        return ok;
+    };
+
+    // sort four arrays together
+    {
+        auto b = make_random_access_iterator_tuple(x.begin(), idx.begin(), w.begin(), label.begin());
+        auto e = make_random_access_iterator_tuple(x.end(), idx.end(), w.end(), label.end());
+        CHECK((e - b) == N);
+        std::sort(b, e, less_by<0>());
+        CHECK(std::is_sorted(x.begin(), x.end()));
+        CHECK(consistent());
+
+        // ties broken by the second member
+        std::sort(b, e, less_by<0, 1>());
+        bool ok = true;
+        for (int i = 1; i < N; ++i)
+            ok = ok && (x[i - 1] < x[i] || (x[i - 1] == x[i] && idx[i - 1] < idx[i]));
+        CHECK(ok);
+        CHECK(consistent());
+
+        // back to the original order, stably (uses value_type buffers)
+        std::stable_sort(b, e, less_by<1>());
+        ok = true;
+        for (int i = 0; i < N; ++i)
+            ok = ok && idx[i] == i;
+        CHECK(ok);
+        CHECK(consistent());
+
+        // partition
+        auto m = std::partition(b, e, [](const auto& r) { return sx::get<1>(r) % 3 == 0; });
+        CHECK((m - b) == (N + 2) / 3);
+        CHECK(consistent());
+    }
+
+    // element access and assignment through the proxy
+    {
+        auto b = make_random_access_iterator_tuple(x.begin(), idx.begin());
+        auto r = b[5];
+        std::tuple<double, int> v = r;
+        CHECK(std::get<0>(v) == x[5]);
+        b[0] = v;
+        CHECK((x[0] == x[5] && idx[0] == idx[5]));
+        sx::get<1>(*(b + 2)) = -1;
+        CHECK(idx[2] == -1);
+        CHECK(b->refs == std::make_tuple(x[0], idx[0]));
+        auto r1 = b[1], r3 = b[3];
+        double x1 = x[1], x3 = x[3];
+        swap(r1, r3);
+        CHECK((x[1] == x3 && x[3] == x1));
+    }
+
+    return test_result();
+}
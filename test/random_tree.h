@@ -0,0 +1,52 @@
+#ifndef RANDOM_TREE_INCLUDED_4417092856
+#define RANDOM_TREE_INCLUDED_4417092856
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "sx/tree.h"
+
+// random tree of at most max_depth splits, nodes in depth-first order
+// About 1 in 5 nodes above max_depth is a leaf. Half of the thresholds need
+// all digits of a float to read back.
+inline sx::tree<float, double> random_tree(std::mt19937& rng, int max_depth, int n_features, int n_outputs,
+    sx::tree_layout layout = sx::tree_layout::breadth_first)
+{
+    std::vector<int> left, right, feature;
+    std::vector<float> threshold;
+    std::vector<double> value;
+    struct grower {
+        std::mt19937& rng;
+        int n_features, n_outputs;
+        std::vector<int>&left, &right, &feature;
+        std::vector<float>& threshold;
+        std::vector<double>& value;
+        int grow(int depth)
+        {
+            const int i = (int)left.size();
+            left.push_back(-1);
+            right.push_back(-1);
+            feature.push_back(-2);
+            threshold.push_back(-2);
+            for (int o = 0; o < n_outputs; ++o)
+                value.push_back(std::ldexp((double)rng(), -32) - 0.5);
+            if (depth > 0 && rng() % 5 != 0) {
+                feature[i] = (int)(rng() % (unsigned)n_features);
+                threshold[i] = rng() % 2 ? (float)(rng() % 100) / 10 : std::ldexp((float)(rng() % (1 << 24)), -20);
+                const int l = grow(depth - 1);
+                const int r = grow(depth - 1);
+                left[i] = l;
+                right[i] = r;
+            }
+            return i;
+        }
+    } g{ rng, n_features, n_outputs, left, right, feature, threshold, value };
+    g.grow(max_depth);
+    const size_t n = left.size();
+    return sx::tree<float, double>(sx::make_array_view(left), sx::make_array_view(right),
+        sx::make_array_view(feature), sx::make_array_view(threshold),
+        sx::array_view<double, 2>(value.data(), { n, (size_t)n_outputs }, sx::array_layout::c_order), layout);
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include "sx/reduce.h"
+
+#include <cstring>
+#include <random>
+#include "simple_test.hpp"
+
+template <typename T>
+static bool bitwise_equal(const T& a, const T& b)
+{
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+int main()
+{
+    using sx::matrix;
+    using E2 = matrix<float>::extents_type;
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> u(-1000, 1000);
+
+    sx::thread_pool p1(1), p3(3), p8(8);
+    sx::par::sequential_executor seq;
+    sx::par::options det;
+    det.deterministic = true;
+    det.grain_bytes = 4096;
+
+    // sum, mean: bitwise identical in deterministic mode
+    {
+        std::vector<float> v(123457);
+        for (auto& x : v)
+            x = u(rng);
+        auto a = sx::make_array_view(v);
+        const float s = sx::par::sum(a, det, p1);
+        CHECK(bitwise_equal(s, sx::par::sum(a, det, p3)));
+        CHECK(bitwise_equal(s, sx::par::sum(a, det, p8)));
+        CHECK(bitwise_equal(s, sx::par::sum(a, det, seq)));
+        CHECK(bitwise_equal(s, sx::par::sum(a, det)));
+        double exact = 0;
+        for (auto x : v)
+            exact += x;
+        CHECK(std::abs(s - exact) < 1e-3 * std::abs(exact) + 1);
+        CHECK(sx::par::mean(a, det, p3) == s / v.size());
+
+        // non-deterministic mode, strided and reversed
+        auto r = a({ 0, sx::end, -3 });
+        double er = 0;
+        for (auto x : r)
+            er += x;
+        CHECK(std::abs(sx::par::reduce(r, 0.0, std::plus<>()) - er) < 1e-6 * std::abs(er) + 1e-6);
+
+        std::vector<int> iv(1000);
+        for (int i = 0; i < 1000; ++i)
+            iv[i] = i;
+        CHECK(sx::par::sum(sx::make_array_view(iv)) == 499500);
+        auto mx = sx::par::reduce(sx::make_array_view(iv), 0, [](int x, int y) { return std::max(x, y); });
+        CHECK(mx == 999);
+    }
+
+    // reduce_along, both strategies, both layouts
+    for (auto layout : { sx::array_layout::c_order, sx::array_layout::fortran_order })
+        for (size_t cols : { 3, 1100 }) {
+            const size_t rows = 1200;
+            matrix<float> X(E2(rows, cols), layout);
+            for (size_t i = 0; i < rows; ++i)
+                for (size_t j = 0; j < cols; ++j)
+                    X(i, j) = u(rng);
+            auto c1 = sx::par::reduce_along(X.view(), 0, 0.0f, std::plus<>(), det, p1);
+            auto c8 = sx::par::reduce_along(X.view(), 0, 0.0f, std::plus<>(), det, p8);
+            auto r3 = sx::par::reduce_along(X.view(), 1, 0.0f, std::plus<>(), det, p3);
+            CHECK((c1.extents(0) == cols && r3.extents(0) == rows));
+            bool same = true, close = true;
+            for (size_t j = 0; j < cols; ++j) {
+                same = same && bitwise_equal(c1(j), c8(j));
+                double e = 0;
+                for (size_t i = 0; i < rows; ++i)
+                    e += X(i, j);
+                close = close && std::abs(c1(j) - e) < 1e-3 * rows;
+            }
+            CHECK((same && close));
+            bool rows_ok = true;
+            for (size_t i = 0; i < rows; i += 97) {
+                float e = 0; // one row is folded in index order
+                for (size_t j = 0; j < cols; ++j)
+                    e += X(i, j);
+                rows_ok = rows_ok && r3(i) == e;
+            }
+            CHECK(rows_ok);
+            auto m = sx::par::reduce_along(X.view(), 1, -1e30f, [](float a, float b) { return std::max(a, b); });
+            auto row5 = X(5, sx::all);
+            CHECK(m(5) == *std::max_element(row5.begin(), row5.end()));
+        }
+
+    // bincount
+    {
+        const size_t n = 100000;
+        std::vector<int> y(n);
+        std::vector<double> w(n);
+        std::vector<double> expected(10, 0);
+        std::vector<size_t> counts(10, 0);
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = rng() % 7;
+            w[i] = u(rng) / 7;
+            expected[y[i]] += w[i];
+            ++counts[y[i]];
+        }
+        auto yv = sx::make_array_view(y);
+        auto h1 = sx::par::bincount(yv, sx::make_array_view(w), 10, det, p1);
+        auto h8 = sx::par::bincount(yv, sx::make_array_view(w), 10, det, p8);
+        CHECK(h1.size() == 10);
+        bool ok = true;
+        for (size_t k = 0; k < 10; ++k)
+            ok = ok && bitwise_equal(h1[k], h8[k]) && std::abs(h1[k] - expected[k]) < 1e-6 * n;
+        CHECK(ok);
+        CHECK(sx::par::bincount(yv) == std::vector<size_t>(counts.begin(), counts.begin() + 7));
+        CHECK(sx::par::bincount<float>(yv, sx::make_array_view(w)).size() == 7);
+        CHECK(sx::par::bincount(yv({ 0, sx::length = 0 }), 3).size() == 3);
+    }
+
+    return test_result();
+}
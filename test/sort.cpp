@@ -0,0 +1,86 @@
+#include "sx/sort.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "simple_test.hpp"
+
+int main()
+{
+    using sx::matrix;
+    using E2 = matrix<float>::extents_type;
+
+    // sort_zipped with packed keys
+    {
+        const int N = 10000;
+        std::vector<float> keys;
+        std::vector<int> idx;
+        std::vector<std::string> s;
+        std::vector<double> w;
+        for (int i = 0; i < N; ++i) {
+            keys.push_back((float)((i * 7919) % 997) - 500.5f);
+            idx.push_back(i);
+            s.push_back(std::to_string(i));
+            w.push_back(i * 0.5);
+        }
+        keys[3] = -0.0f;
+        keys[4] = 0.0f;
+        auto orig = keys;
+        sx::sort_zipped(keys, idx, s, w);
+        CHECK(std::is_sorted(keys.begin(), keys.end()));
+        bool ok = true;
+        for (int i = 0; i < N; ++i) {
+            ok = ok && keys[i] == orig[idx[i]] && s[i] == std::to_string(idx[i]) && w[i] == idx[i] * 0.5;
+            if (i > 0 && keys[i - 1] == keys[i])
+                ok = ok && idx[i - 1] < idx[i]; // stable
+        }
+        CHECK(ok);
+    }
+
+    // -0 and +0 are equal keys, packed or not
+    {
+        std::vector<float> kf = { 0.0f, -0.0f, 0.0f };
+        std::vector<double> kd = { 0.0, -0.0, 0.0 };
+        std::vector<int> pf = { 0, 1, 2 }, pd = { 0, 1, 2 };
+        sx::sort_zipped(kf, pf);
+        sx::sort_zipped(kd, pd);
+        CHECK((pf == std::vector<int>{ 0, 1, 2 } && pd == pf));
+    }
+
+    // 64-bit keys, strided array_view payload
+    {
+        std::vector<long long> keys = { 5, -3, 1LL << 40, 0, -3 };
+        std::vector<int> buf = { 0, -1, 1, -1, 2, -1, 3, -1, 4, -1 };
+        sx::array_view<int> payload(buf.data(), { 5 }, sx::array_view<int>::strides_type{ 2 });
+        sx::sort_zipped(keys, payload);
+        CHECK((keys == std::vector<long long>{ -3, -3, 0, 5, 1LL << 40 }));
+        CHECK((buf == std::vector<int>{ 1, -1, 4, -1, 3, -1, 0, -1, 2, -1 }));
+    }
+
+    // sortperm, sort
+    {
+        matrix<float> X(E2(3, 4));
+        const float v[3][4] = { { 3, 1, 2, 0 }, { -1, 5, 5, 2 }, { 0, 0, 0, 0 } };
+        for (size_t i = 0; i < 3; ++i)
+            for (size_t j = 0; j < 4; ++j)
+                X(i, j) = v[i][j];
+
+        auto P = sx::sortperm<int>(X.view(), 1);
+        CHECK((P(0, 0) == 3 && P(0, 1) == 1 && P(0, 2) == 2 && P(0, 3) == 0));
+        CHECK((P(1, 0) == 0 && P(1, 1) == 3 && P(1, 2) == 1 && P(1, 3) == 2));
+        CHECK((P(2, 0) == 0 && P(2, 3) == 3));
+
+        auto Q = sx::sortperm<size_t>(X.view(), 0);
+        CHECK((Q(0, 0) == 1 && Q(1, 0) == 2 && Q(2, 0) == 0));
+        CHECK((Q(0, 1) == 2 && Q(2, 1) == 1));
+
+        auto S = sx::sort(X.view(), 0);
+        CHECK((S(0, 0) == -1 && S(2, 0) == 3 && S(0, 1) == 0 && S(2, 1) == 5));
+        CHECK(X(0, 0) == 3);
+
+        auto M = sx::indmax_along(X.view(), 1);
+        CHECK((M(0) == 0 && M(1) == 1 && M(2) == 0));
+    }
+
+    return test_result();
+}
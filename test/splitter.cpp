@@ -0,0 +1,135 @@
+#include "sx/splitter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "simple_test.hpp"
+
+using E2 = sx::matrix<float>::extents_type;
+using splitter_t = sx::presorted_splitter<float>;
+
+// the best split of the samples by brute force, same tie-breaking
+static sx::split<float> reference_split(const sx::matrix<float>& X, const std::vector<double>& y,
+    std::vector<std::uint32_t> s, size_t min_leaf)
+{
+    sx::split<float> r;
+    const size_t n = s.size();
+    if (n < 2 * min_leaf)
+        return r;
+    for (size_t j = 0; j < X.extents(1); ++j) {
+        std::stable_sort(s.begin(), s.end(), [&](std::uint32_t a, std::uint32_t b) { return X(a, j) < X(b, j); });
+        for (size_t k = min_leaf; k + min_leaf <= n; ++k) {
+            if (!(X(s[k - 1], j) < X(s[k], j)))
+                continue;
+            double l = 0, sum = 0;
+            for (size_t i = 0; i < n; ++i)
+                (i < k ? l : sum) += y[s[i]];
+            sum += l;
+            const double gain = l * l / k + (sum - l) * (sum - l) / (n - k) - sum * sum / n;
+            if (gain > r.gain + 1e-9) {
+                r.feature = (std::int32_t)j;
+                r.gain = gain;
+                r.n_left = k;
+            }
+        }
+    }
+    return r;
+}
+
+template <typename Executor>
+static bool grow(splitter_t& sp, const sx::matrix<float>& X, const std::vector<double>& y,
+    const splitter_t::node_range& node, int depth, Executor& ex, int& n_splits)
+{
+    bool ok = true;
+    // every column holds the same samples, sorted by its feature
+    auto s0 = sp.samples(node, 0);
+    std::vector<std::uint32_t> set0(s0.begin(), s0.end());
+    std::sort(set0.begin(), set0.end());
+    for (size_t j = 0; j < sp.n_features(); ++j) {
+        auto s = sp.samples(node, j);
+        std::vector<std::uint32_t> set(s.begin(), s.end());
+        for (size_t k = 1; k < set.size(); ++k)
+            ok = ok && X(set[k - 1], j) <= X(set[k], j);
+        std::sort(set.begin(), set.end());
+        ok = ok && set == set0;
+    }
+    if (depth == 0)
+        return ok;
+
+    sx::split_options opts;
+    opts.min_samples_leaf = 3;
+    auto s = sp.find_split(node, sx::make_array_view(y), opts, ex);
+    auto e = reference_split(X, y, set0, 3);
+    ok = ok && s.is_valid() == e.is_valid();
+    if (!s.is_valid())
+        return ok;
+    ok = ok && std::abs(s.gain - e.gain) < 1e-9 && s.feature == e.feature && s.n_left == e.n_left;
+
+    auto children = sp.apply_split(node, s, ex);
+    ok = ok && children.first.size() == s.n_left && children.first.size() + children.second.size() == node.size();
+    for (auto i : sp.samples(children.first, 2))
+        ok = ok && X(i, s.feature) <= s.threshold;
+    for (auto i : sp.samples(children.second, 1))
+        ok = ok && X(i, s.feature) > s.threshold;
+    ++n_splits;
+    ok = ok && grow(sp, X, y, children.first, depth - 1, ex, n_splits);
+    ok = ok && grow(sp, X, y, children.second, depth - 1, ex, n_splits);
+    return ok;
+}
+
+int main()
+{
+    std::mt19937 rng(3);
+    const size_t n = 500;
+    sx::matrix<float> X(E2(n, 4), sx::array_layout::c_order);
+    std::vector<double> y(n);
+    for (size_t i = 0; i < n; ++i) {
+        X(i, 0) = (float)(rng() % 1000) / 100;
+        X(i, 1) = (float)(rng() % 4); // many ties
+        X(i, 2) = std::ldexp((float)(rng() % 1000), -3);
+        X(i, 3) = 7; // constant
+        y[i] = (X(i, 0) > 5 ? 1.0 : -1.0) + 0.5 * X(i, 1) + (double)(rng() % 100) / 200;
+    }
+
+    sx::thread_pool pool(3);
+    sx::par::sequential_executor seq;
+    {
+        splitter_t sp(sx::array_view<const float, 2>(X.view()), seq);
+        CHECK((sp.n_samples() == n && sp.n_features() == 4));
+        int n_splits = 0;
+        CHECK(grow(sp, X, y, sp.root(), 5, seq, n_splits));
+        CHECK(n_splits > 10);
+    }
+    {
+        splitter_t sp(sx::array_view<const float, 2>(X.view()), pool);
+        int n_splits = 0;
+        CHECK(grow(sp, X, y, sp.root(), 5, pool, n_splits));
+    }
+
+    // the root split separates the two halves of y
+    {
+        splitter_t sp(sx::array_view<const float, 2>(X.view()));
+        auto s = sp.find_split(sp.root(), sx::make_array_view(y));
+        CHECK((s.feature == 0 && s.threshold >= 4.99f && s.threshold < 5.01f));
+    }
+
+    // constant or too small nodes don't split
+    {
+        sx::matrix<float> C(E2(10, 2), 1.0f);
+        std::vector<double> yc(10);
+        for (size_t i = 0; i < 10; ++i)
+            yc[i] = (double)i;
+        splitter_t sp(sx::array_view<const float, 2>(C.view()));
+        CHECK(!sp.find_split(sp.root(), sx::make_array_view(yc)).is_valid());
+        C(3, 1) = 2;
+        sx::split_options opts;
+        opts.min_samples_leaf = 2;
+        splitter_t sp2(sx::array_view<const float, 2>(C.view()));
+        CHECK(!sp2.find_split(sp2.root(), sx::make_array_view(yc), opts).is_valid());
+        auto s = sp2.find_split(sp2.root(), sx::make_array_view(yc));
+        CHECK((s.feature == 1 && s.n_left == 9 && s.threshold >= 1 && s.threshold < 2));
+    }
+
+    return test_result();
+}
@@ -0,0 +1,97 @@
+#include "range/view/take_at.hpp"
+
+#include <vector>
+#include <list>
+#include <deque>
+#include <string>
+#include <algorithm>
+#include "simple_test.hpp"
+
+int main()
+{
+    using ranges::view::take_at;
+
+    std::vector<int> data(1000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = (int)(i * 3);
+    std::vector<int> idx;
+    for (int i = 0; i < 100; ++i)
+        idx.push_back((i * 131) % 1000);
+
+    // size, random access, std algorithms
+    {
+        auto v = take_at(data, idx);
+        CHECK(v.size() == idx.size());
+        CHECK(!v.empty());
+        CHECK(v[5] == data[idx[5]]);
+        CHECK(v.begin()[7] == data[idx[7]]);
+        CHECK(std::distance(v.begin(), v.end()) == 100);
+        auto it = std::find(v.begin(), v.end(), data[idx[42]]);
+        CHECK((it - v.begin()) == 42);
+
+        v[0] = -1;
+        CHECK(data[0] == -1);
+        data[0] = 0;
+    }
+
+    // gather_into, contiguous and not
+    {
+        std::vector<int> out(idx.size());
+        auto v = take_at(data, idx);
+        auto e = v.gather_into(out.begin());
+        CHECK(e == out.end());
+        bool ok = true;
+        for (size_t i = 0; i < idx.size(); ++i)
+            ok = ok && out[i] == data[idx[i]];
+        CHECK(ok);
+
+        struct raw {
+            int* p;
+            size_t n;
+            int* begin() const { return p; }
+            int* end() const { return p + n; }
+        };
+        std::fill(out.begin(), out.end(), 0);
+        take_at(raw{ data.data(), data.size() }, idx).gather_into(out.data());
+        ok = true;
+        for (size_t i = 0; i < idx.size(); ++i)
+            ok = ok && out[i] == data[idx[i]];
+        CHECK(ok);
+
+        // the unrolled path is taken for vector and string iterators too
+        using ranges::view::is_contiguous_iterator;
+        static_assert(is_contiguous_iterator<std::vector<int>::iterator>::value, "");
+        static_assert(is_contiguous_iterator<std::vector<int>::const_iterator>::value, "");
+        static_assert(is_contiguous_iterator<std::string::const_iterator>::value, "");
+        static_assert(!is_contiguous_iterator<std::vector<bool>::iterator>::value, "");
+        static_assert(!is_contiguous_iterator<std::deque<int>::iterator>::value, "");
+        const std::vector<int>& cdata = data;
+        std::fill(out.begin(), out.end(), 0);
+        take_at(cdata, idx).gather_into(out.begin());
+        ok = true;
+        for (size_t i = 0; i < idx.size(); ++i)
+            ok = ok && out[i] == data[idx[i]];
+        CHECK(ok);
+        const std::string str = "abcdefghijklmnopqrstuvwxyz";
+        std::vector<int> sidx(idx);
+        for (auto& i : sidx)
+            i %= 26;
+        std::string sout(sidx.size(), ' ');
+        take_at(str, sidx).gather_into(sout.begin());
+        ok = true;
+        for (size_t i = 0; i < sidx.size(); ++i)
+            ok = ok && sout[i] == str[sidx[i]];
+        CHECK(ok);
+        std::vector<int> none;
+        CHECK(take_at(none, none).gather_into(out.begin()) == out.begin());
+
+        std::list<int> lidx(idx.begin(), idx.end());
+        std::vector<int> out2;
+        auto lv = take_at(data, lidx);
+        CHECK(lv.size() == idx.size());
+        lv.gather_into(std::back_inserter(out2));
+        CHECK(out2 == out);
+    }
+
+    return test_result();
+}
@@ -0,0 +1,110 @@
+#include "sx/thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "sx/parallel.h"
+#include "simple_test.hpp"
+
+static long fib(sx::thread_pool& pool, int n)
+{
+    if (n < 15)
+        return n < 2 ? n : fib(pool, n - 1) + fib(pool, n - 2);
+    long a, b;
+    sx::task_group g(pool);
+    g.run([&] { a = fib(pool, n - 1); });
+    b = fib(pool, n - 2);
+    g.wait();
+    return a + b;
+}
+
+int main()
+{
+    for (size_t n_threads : { 1, 2, 4 }) {
+        sx::thread_pool pool(n_threads);
+        CHECK(pool.concurrency() == n_threads);
+
+        // task groups, recursive
+        CHECK(fib(pool, 25) == 75025);
+
+        // parallel_for over subranges, nested
+        std::vector<int> v(10000, 0);
+        pool.parallel_for(0, 100, 0, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i)
+                pool.parallel_for(i * 100, (i + 1) * 100, 7, [&](size_t b2, size_t e2) {
+                    for (size_t j = b2; j < e2; ++j)
+                        v[j] += (int)j;
+                });
+        });
+        bool ok = true;
+        for (size_t j = 0; j < v.size(); ++j)
+            ok = ok && v[j] == (int)j;
+        CHECK(ok);
+
+        // exceptions reach wait()
+        sx::task_group g(pool);
+        std::atomic<int> done(0);
+        for (int i = 0; i < 20; ++i)
+            g.run([&done, i] {
+                ++done;
+                if (i == 13)
+                    throw std::runtime_error("13");
+            });
+        bool thrown = false;
+        try {
+            g.wait();
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        CHECK((thrown && done == 20));
+        g.wait(); // the error is reported once
+
+        // the waiting thread sleeps while a worker runs the task, and wakes
+        // for the tasks queued later
+        {
+            sx::task_group g2(pool);
+            std::atomic<int> n(0);
+            g2.run([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                for (int i = 0; i < 10; ++i)
+                    g2.run([&n] { ++n; });
+                ++n;
+            });
+            g2.wait();
+            CHECK(n == 11);
+        }
+
+        // as the executor of the parallel algorithms
+        std::vector<double> x(50000), y(50000);
+        std::iota(x.begin(), x.end(), 0.0);
+        sx::par::options small;
+        small.grain_bytes = 1024;
+        sx::par::transform(sx::make_array_view(y), sx::make_array_view(x),
+            [](double a) { return a * 2; }, small, pool);
+        CHECK((y[0] == 0 && y[49999] == 99998));
+    }
+
+    // pinned workers
+    {
+        sx::thread_pool::config c;
+        c.n_threads = 3;
+        c.cpus = { 0 };
+        sx::thread_pool pool(c);
+        std::atomic<int> n(0);
+        pool.parallel_for(1000, [&n](size_t) { ++n; });
+        CHECK(n == 1000);
+    }
+
+    // the default pool
+    {
+        std::vector<int> v(100000, 1);
+        sx::par::for_each(sx::make_array_view(v), [](int& a) { a *= 3; });
+        CHECK(std::accumulate(v.begin(), v.end(), 0) == 300000);
+    }
+
+    return test_result();
+}
@@ -0,0 +1,142 @@
+#include "sx/tree.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "simple_test.hpp"
+
+// a random tree with nodes in depth-first order (like scikit-learn's)
+struct raw_tree {
+    std::vector<int> left, right, feature;
+    std::vector<float> threshold;
+    std::vector<double> value; // n x 2
+
+    int grow(std::mt19937& rng, int depth)
+    {
+        const int i = (int)left.size();
+        left.push_back(-1);
+        right.push_back(-1);
+        feature.push_back(-2);
+        threshold.push_back(-2);
+        value.push_back(i);
+        value.push_back(-i);
+        if (depth > 0 && (depth > 3 || rng() % 4 != 0)) {
+            feature[i] = (int)(rng() % 5);
+            threshold[i] = (float)(rng() % 100) / 10;
+            const int l = grow(rng, depth - 1);
+            const int r = grow(rng, depth - 1);
+            left[i] = l;
+            right[i] = r;
+        }
+        return i;
+    }
+    int leaf_of(const std::vector<float>& x) const
+    {
+        int i = 0;
+        while (left[i] >= 0)
+            i = x[feature[i]] > threshold[i] ? right[i] : left[i];
+        return i;
+    }
+};
+
+int main()
+{
+    using sx::tree_layout;
+    std::mt19937 rng(5);
+
+    // complete tree of 4 levels
+    {
+        raw_tree rt;
+        for (int i = 0; i < 15; ++i) {
+            rt.left.push_back(i < 7 ? 2 * i + 1 : -1);
+            rt.right.push_back(i < 7 ? 2 * i + 2 : -1);
+            rt.feature.push_back(0);
+            rt.threshold.push_back((float)i);
+            rt.value.push_back(i);
+            rt.value.push_back(0);
+        }
+        auto vals = sx::array_view<double, 2>(rt.value.data(), { 15, 2 }, sx::array_layout::c_order);
+        sx::tree<float, double> bf(sx::make_array_view(rt.left), sx::make_array_view(rt.right),
+            sx::make_array_view(rt.feature), sx::make_array_view(rt.threshold), vals);
+        CHECK((bf.size() == 15 && bf.n_leaves() == 8 && bf.n_outputs() == 2 && bf.depth() == 4));
+        for (int i = 0; i < 7; ++i)
+            CHECK(bf.threshold(i) == (float)i); // already breadth-first
+
+        sx::tree<float, double> veb(bf, tree_layout::van_emde_boas);
+        CHECK(veb.layout() == tree_layout::van_emde_boas);
+        // top 2 levels, then the 4 subtrees of 2 levels
+        const float expected[] = { 0, 1, 2, 3, 7, 8, 4, 9, 10, 5, 11, 12, 6, 13, 14 };
+        bool ok = true;
+        for (int i = 0; i < 15; ++i)
+            ok = ok && (veb.is_leaf(i) ? veb.value(i)(0) == expected[i] : veb.threshold(i) == expected[i]);
+        CHECK(ok);
+        CHECK((veb.left(3) == 4 && veb.right(3) == 5 && veb.left(1) == 3 && veb.right(1) == 6));
+        // leaf values are in node order
+        CHECK((veb.value(4)(0) == 7 && veb.value(5)(0) == 8 && veb.value(7)(0) == 9));
+        CHECK((veb.value_offset(4) == 0 && veb.value_offset(0) == -1));
+        CHECK((veb.is_leaf(4) && veb.left(4) == 4 && veb.right(4) == 4 && veb.feature(4) == 0));
+    }
+
+    // thresholds converted to a narrower type keep the split:
+    // x > threshold(i) for exactly the same x
+    {
+        const std::vector<int> l = { 1, -1, -1 }, r = { 2, -1, -1 }, f = { 0, 0, 0 };
+        const std::vector<double> v = { 0, 1, 2 };
+        const auto vals = sx::array_view<const double, 2>(v.data(), { 3, 1 }, sx::array_layout::c_order);
+        // the midpoint of two adjacent floats, (float)m rounds up to b
+        const float a = 1 + std::ldexp(1.0f, -23), b = 1 + std::ldexp(1.0f, -22);
+        const std::vector<double> m = { ((double)a + b) / 2, 0, 0 };
+        sx::tree<float, double> t(sx::make_array_view(l), sx::make_array_view(r), sx::make_array_view(f),
+            sx::make_array_view(m), vals);
+        CHECK((float)m[0] == b);
+        CHECK(t.threshold(0) == a);
+        std::vector<float> x = { b };
+        CHECK(t.value(t.leaf_of(sx::make_array_view(x)))(0) == 2);
+        x[0] = a;
+        CHECK(t.value(t.leaf_of(sx::make_array_view(x)))(0) == 1);
+
+        for (double h : { -2.5, 2.5, 3.0 }) {
+            const std::vector<double> hm = { h, 0, 0 };
+            sx::tree<int, double> ti(sx::make_array_view(l), sx::make_array_view(r), sx::make_array_view(f),
+                sx::make_array_view(hm), vals);
+            bool ok = true;
+            for (int xi = -5; xi <= 5; ++xi) {
+                const std::vector<int> xv = { xi };
+                ok = ok && ti.value(ti.leaf_of(sx::make_array_view(xv)))(0) == (xi > h ? 2 : 1);
+            }
+            CHECK(ok);
+        }
+    }
+
+    // random trees, both layouts give the same leaves as the raw arrays
+    for (int t = 0; t < 10; ++t) {
+        raw_tree rt;
+        rt.grow(rng, 9);
+        const size_t n = rt.left.size();
+        auto vals = sx::array_view<double, 2>(rt.value.data(), { n, 2 }, sx::array_layout::c_order);
+        sx::tree<float, double> bf(sx::make_array_view(rt.left), sx::make_array_view(rt.right),
+            sx::make_array_view(rt.feature), sx::make_array_view(rt.threshold), vals);
+        sx::tree<float, double> veb(sx::make_array_view(rt.left), sx::make_array_view(rt.right),
+            sx::make_array_view(rt.feature), sx::make_array_view(rt.threshold), vals,
+            tree_layout::van_emde_boas);
+        CHECK((bf.size() == n && veb.size() == n && bf.depth() == veb.depth()));
+        bool ok = true;
+        std::vector<float> x(5);
+        for (int s = 0; s < 200; ++s) {
+            for (auto& xi : x)
+                xi = (float)(rng() % 110) / 10;
+            const int e = rt.leaf_of(x);
+            auto xv = sx::make_array_view(x);
+            ok = ok && bf.value(bf.leaf_of(xv))(0) == e && veb.value(veb.leaf_of(xv))(0) == e
+                && veb.value(veb.leaf_of(xv))(1) == -e;
+        }
+        CHECK(ok);
+        // children come after their parent
+        for (int i = 0; i < (int)n; ++i)
+            ok = ok && (bf.is_leaf(i) || bf.left(i) > i) && (veb.is_leaf(i) || veb.right(i) > veb.left(i))
+                && (veb.is_leaf(i) || veb.left(i) > i);
+        CHECK(ok);
+    }
+
+    return test_result();
+}